@@ -0,0 +1,861 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+typedef struct
+{
+    int key;
+    double value;
+} Rec;
+
+#define ZVEC_ENABLE_IO
+#define ZVEC_ENABLE_THREADS
+#define REGISTER_ZVEC_TYPES(X) \
+    X(int, Int)                \
+    X(Rec, Rec)
+
+#include "zvec.h"
+
+#define TEST(name) printf("[TEST] %-35s", name);
+#define PASS() printf(" \033[0;32mPASS\033[0m\n")
+
+static char g_dir[] = "/tmp/zvec_io_XXXXXX";
+
+static const char *tmp_path(const char *name)
+{
+    static char buf[4][256];
+    static int next = 0;
+    char *p = buf[next++ & 3];
+    snprintf(p, sizeof(buf[0]), "%s/%s", g_dir, name);
+    return p;
+}
+
+static int cmp_rec(const Rec *a, const Rec *b)
+{
+    return (a->key > b->key) - (a->key < b->key);
+}
+
+void test_save_view_mmap(void)
+{
+    TEST("Save / View Mmap");
+
+    const char *path = tmp_path("recs.zvec");
+    zvec_Rec v = zvec_init(Rec);
+    int i;
+    for (i = 0; i < 10000; ++i)
+    {
+        Rec r = {i * 2, i * 0.5};
+        zvec_push(&v, r);
+    }
+    assert(Z_OK == zvec_save(&v, path));
+    assert(Z_OK == zvec_verify_file(path));
+
+    zvec_Rec view = zvec_view_mmap(Rec, path);
+    assert(view.data && view.length == 10000);
+    assert(((size_t)view.data % 64) == 0);
+    assert(zvec_at(&view, 1234)->key == 2468);
+
+    Rec key = {4000, 0};
+    Rec *hit = zvec_bsearch(&view, &key, cmp_rec);
+    assert(hit && hit->value == 1000.0);
+    key.key = 4001;
+    assert(NULL == zvec_bsearch(&view, &key, cmp_rec));
+    assert(zvec_lower_bound(&view, &key, cmp_rec)->key == 4002);
+
+    double sum = 0;
+    zvec_foreach(&view, it)
+    {
+        sum += it->value;
+    }
+    assert(sum == 0.5 * (9999.0 * 10000.0 / 2.0));
+
+    zvec_unmap(&view);
+    assert(NULL == view.data && 0 == view.length);
+    zvec_free(&v);
+    PASS();
+}
+
+void test_view_mmap_rejects(void)
+{
+    TEST("View Mmap Rejects Bad Files");
+
+    const char *path = tmp_path("ints.zvec");
+    zvec_Int v = zvec_from(Int, 1, 2, 3, 4, 5);
+    assert(Z_OK == zvec_save(&v, path));
+
+    // Wrong element type.
+    zvec_Rec wrong = zvec_view_mmap(Rec, path);
+    assert(NULL == wrong.data && 0 == wrong.length);
+
+    // A flipped payload byte still maps but fails verification.
+    FILE *f = fopen(path, "r+b");
+    assert(f);
+    fseek(f, ZVEC_FILE_HEADER_SIZE + 4, SEEK_SET);
+    fputc(0x7f, f);
+    fclose(f);
+    assert(Z_EINVAL == zvec_verify_file(path));
+    zvec_Int view = zvec_view_mmap(Int, path);
+    assert(view.data && view.length == 5 && *zvec_at(&view, 0) == 1);
+    zvec_unmap(&view);
+
+    // Truncated file.
+    assert(0 == truncate(path, ZVEC_FILE_HEADER_SIZE + 8));
+    view = zvec_view_mmap(Int, path);
+    assert(NULL == view.data);
+    assert(Z_EINVAL == zvec_verify_file(path));
+
+    // Missing file.
+    view = zvec_view_mmap(Int, tmp_path("missing.zvec"));
+    assert(NULL == view.data);
+
+    // Empty vectors round-trip.
+    zvec_clear(&v);
+    assert(Z_OK == zvec_save(&v, path));
+    view = zvec_view_mmap(Int, path);
+    assert(view.data && 0 == view.length);
+    zvec_unmap(&view);
+
+    zvec_free(&v);
+    PASS();
+}
+
+void test_file_backed_vector(void)
+{
+    TEST("File-Backed Vector (mremap)");
+
+    const char *path = tmp_path("log.zvec");
+    zvec_file_Int f;
+    int i;
+
+    // A writer that dies without closing keeps exactly its last checkpoint.
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (0 == pid)
+    {
+        if (Z_OK != zvec_file_open(&f, path))
+        {
+            _exit(1);
+        }
+        for (i = 0; i < 1000; ++i)
+        {
+            zvec_file_push(&f, i);
+        }
+        zvec_file_sync(&f);
+        for (i = 1000; i < 1500; ++i)
+        {
+            zvec_file_push(&f, i);
+        }
+        _exit(0);
+    }
+    int status;
+    assert(pid == waitpid(pid, &status, 0) && WIFEXITED(status) && 0 == WEXITSTATUS(status));
+
+    assert(Z_OK == zvec_file_open(&f, path));
+    assert(f.vec.length == 1000 && f.vec.capacity >= 1000);
+    assert(*zvec_at(&f.vec, 999) == 999);
+
+    // Grow through several remaps; in-place edits go straight to the file.
+    for (i = 1000; i < 200000; ++i)
+    {
+        assert(Z_OK == zvec_file_push(&f, i));
+    }
+    *zvec_at(&f.vec, 0) = -1;
+    int tail[3] = {7, 8, 9};
+    assert(Z_OK == zvec_file_extend(&f, tail, 3));
+    assert(Z_OK == zvec_file_close(&f));
+    assert(-1 == f.fd && NULL == f.vec.data);
+
+    // Other element types are refused.
+    zvec_file_Rec wrong;
+    assert(Z_EINVAL == zvec_file_open(&wrong, path));
+
+    // A closed file is trimmed to the zvec_save layout.
+    assert(Z_OK == zvec_verify_file(path));
+    zvec_Int view = zvec_view_mmap(Int, path);
+    assert(view.data && view.length == 200003);
+    assert(*zvec_at(&view, 0) == -1 && *zvec_at(&view, 123456) == 123456);
+    assert(*zvec_last(&view) == 9);
+    zvec_unmap(&view);
+    PASS();
+}
+
+#define LOG_THREADS     8
+#define LOG_PER_THREAD  400
+#define LOG_TOTAL       (LOG_THREADS * LOG_PER_THREAD + LOG_THREADS)
+
+static zvec_log_Int g_log;
+
+static void *log_writer(void *arg)
+{
+    int base = (int)(size_t)arg * LOG_PER_THREAD;
+    int i;
+    for (i = 0; i < LOG_PER_THREAD; i += 2)
+    {
+        if (i % 4 == 0)
+        {
+            int pair[2] = {base + i, base + i + 1};
+            assert(Z_OK == zvec_log_extend(&g_log, pair, 2));
+        }
+        else
+        {
+            assert(Z_OK == zvec_log_push(&g_log, base + i));
+            assert(Z_OK == zvec_log_push(&g_log, base + i + 1));
+        }
+    }
+    return NULL;
+}
+
+// One commit of the last LOG_THREADS values, for the single-round check.
+static void *log_one(void *arg)
+{
+    assert(Z_OK == zvec_log_push(&g_log, LOG_THREADS * LOG_PER_THREAD + (int)(size_t)arg));
+    return NULL;
+}
+
+static int cmp_int(const int *a, const int *b)
+{
+    return (*a > *b) - (*a < *b);
+}
+
+void test_durable_log(void)
+{
+    TEST("Durable Log (Group Commit)");
+
+    const char *path = tmp_path("ingest.log");
+    pthread_t th[LOG_THREADS];
+    size_t i;
+    assert(Z_OK == zvec_log_open(&g_log, path));
+    assert(0 == g_log.vec.length);
+    for (i = 0; i < LOG_THREADS; ++i)
+    {
+        pthread_create(&th[i], NULL, log_writer, (void *)i);
+    }
+    for (i = 0; i < LOG_THREADS; ++i)
+    {
+        pthread_join(th[i], NULL);
+    }
+    assert(g_log.vec.length == LOG_THREADS * LOG_PER_THREAD);
+    assert(g_log.core.durable == g_log.core.staged);
+    assert(g_log.core.syncs >= 1 && g_log.core.syncs <= g_log.core.staged);
+
+    // Commits staged while a flush is in flight all go out in the next one.
+    uint64_t syncs = g_log.core.syncs, staged = g_log.core.staged;
+    pthread_mutex_lock(&g_log.core.lock);
+    g_log.core.flushing = 1;
+    pthread_mutex_unlock(&g_log.core.lock);
+    for (i = 0; i < LOG_THREADS; ++i)
+    {
+        pthread_create(&th[i], NULL, log_one, (void *)i);
+    }
+    for (;;)
+    {
+        pthread_mutex_lock(&g_log.core.lock);
+        if (g_log.core.staged == staged + LOG_THREADS)
+        {
+            break;
+        }
+        pthread_mutex_unlock(&g_log.core.lock);
+        sched_yield();
+    }
+    g_log.core.flushing = 0;
+    pthread_cond_broadcast(&g_log.core.flushed);
+    pthread_mutex_unlock(&g_log.core.lock);
+    for (i = 0; i < LOG_THREADS; ++i)
+    {
+        pthread_join(th[i], NULL);
+    }
+    assert(g_log.core.syncs == syncs + 1);
+    assert(g_log.core.durable == g_log.core.staged);
+    assert(g_log.vec.length == LOG_TOTAL);
+    zvec_log_close(&g_log);
+
+    // Recovery rebuilds every committed element.
+    zvec_Int v;
+    assert(Z_OK == zvec_log_load(Int, path, &v));
+    assert(v.length == LOG_TOTAL);
+    zvec_sort(&v, cmp_int);
+    for (i = 0; i < v.length; ++i)
+    {
+        assert(v.data[i] == (int)i);
+    }
+    zvec_free(&v);
+
+    // A torn tail (partial frame) is dropped and truncated away.
+    struct stat st;
+    assert(0 == stat(path, &st));
+    off_t good = st.st_size;
+    FILE *f = fopen(path, "ab");
+    assert(f);
+    fwrite("\x05\0\0\0torn", 1, 8, f);
+    fclose(f);
+    assert(Z_OK == zvec_log_open(&g_log, path));
+    assert(g_log.vec.length == LOG_TOTAL);
+    assert(0 == stat(path, &st) && st.st_size == good);
+
+    // Appending after recovery continues the log; a corrupt last frame is cut.
+    assert(Z_OK == zvec_log_push(&g_log, 42));
+    zvec_log_close(&g_log);
+    f = fopen(path, "r+b");
+    assert(f);
+    fseek(f, -1, SEEK_END);
+    fputc(0x55, f);
+    fclose(f);
+    assert(Z_OK == zvec_log_load(Int, path, &v));
+    assert(v.length == LOG_TOTAL);
+    zvec_free(&v);
+
+    // A failed commit leaves 'vec' as it was, and the log stays failed.
+    assert(Z_OK == zvec_log_open(&g_log, path));
+    int ro = open(path, O_RDONLY);
+    assert(ro >= 0 && g_log.core.fd == dup2(ro, g_log.core.fd));
+    close(ro);
+    int batch[3] = {1, 2, 3};
+    assert(Z_ERR == zvec_log_extend(&g_log, batch, 3));
+    assert(g_log.vec.length == LOG_TOTAL);
+    assert(Z_ERR == zvec_log_push(&g_log, 4));
+    assert(g_log.vec.length == LOG_TOTAL);
+    zvec_log_close(&g_log);
+    assert(Z_OK == zvec_log_load(Int, path, &v));
+    assert(v.length == LOG_TOTAL);
+    zvec_free(&v);
+
+    // Logs are not zvec_save files, and vice versa.
+    assert(NULL == zvec_view_mmap(Int, path).data);
+    assert(Z_EINVAL == zvec_log_load(Int, tmp_path("ints.zvec"), &v));
+    PASS();
+}
+
+#define SHM_COUNT 100000
+
+static int shm_reader(const char *name)
+{
+    zvec_shm_Int r;
+    size_t checked = 0;
+    int rc;
+    while (Z_OK != (rc = zvec_shm_attach(&r, name)))
+    {
+        if (Z_ENOTFOUND != rc && Z_EEMPTY != rc)
+        {
+            return 1;
+        }
+        sched_yield();
+    }
+    while (checked < SHM_COUNT)
+    {
+        size_t len = zvec_shm_refresh(&r);
+        for (; checked < len; ++checked)
+        {
+            if (*zvec_at(&r.vec, checked) != (int)checked)
+            {
+                return 2;
+            }
+        }
+        sched_yield();
+    }
+    zvec_shm_detach(&r);
+    return 0;
+}
+
+void test_shm_vector(void)
+{
+    TEST("Shared-Memory Vector (2 Processes)");
+
+    char name[64];
+    snprintf(name, sizeof(name), "/zvec_test_%d", (int)getpid());
+    zvec_shm_unlink(name);
+
+    zvec_shm_Int w;
+    assert(Z_OK == zvec_shm_create(&w, name, 16));
+    zvec_shm_Int dup;
+    assert(Z_EEXIST == zvec_shm_create(&dup, name, 16));
+
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (0 == pid)
+    {
+        _exit(shm_reader(name));
+    }
+
+    // Appends grow the segment many times while the reader follows along.
+    int i, batch[100];
+    for (i = 0; i < SHM_COUNT; i += 100)
+    {
+        int k;
+        for (k = 0; k < 100; ++k)
+        {
+            batch[k] = i + k;
+        }
+        if (i % 200 == 0)
+        {
+            assert(Z_OK == zvec_shm_extend(&w, batch, 100));
+        }
+        else
+        {
+            for (k = 0; k < 100; ++k)
+            {
+                assert(Z_OK == zvec_shm_push(&w, batch[k]));
+            }
+        }
+    }
+    int status;
+    assert(pid == waitpid(pid, &status, 0) && WIFEXITED(status) && 0 == WEXITSTATUS(status));
+    assert(w.vec.length == SHM_COUNT && w.vec.capacity >= SHM_COUNT);
+
+    zvec_shm_Rec wrong;
+    assert(Z_EINVAL == zvec_shm_attach(&wrong, name));
+
+    zvec_shm_detach(&w);
+    assert(Z_OK == zvec_shm_unlink(name));
+    zvec_shm_Int gone;
+    assert(Z_ENOTFOUND == zvec_shm_attach(&gone, name));
+    PASS();
+}
+
+#define XSORT_COUNT 300000
+
+static void check_sorted_file(const char *path, size_t count, long long key_sum)
+{
+    zvec_Rec out = zvec_init(Rec);
+    FILE *f = fopen(path, "rb");
+    assert(f);
+    zvec_reserve(&out, count + 1);
+    out.length = fread(out.data, sizeof(Rec), count + 1, f);
+    fclose(f);
+    assert(out.length == count);
+    long long sum = 0;
+    size_t i;
+    for (i = 0; i < out.length; ++i)
+    {
+        sum += out.data[i].key;
+        // Stable: equal keys keep their input order (value is the input index).
+        assert(0 == i || out.data[i - 1].key < out.data[i].key ||
+               (out.data[i - 1].key == out.data[i].key &&
+                out.data[i - 1].value < out.data[i].value));
+    }
+    assert(sum == key_sum);
+    zvec_free(&out);
+}
+
+static int xsort_cmp_calls;
+
+static int cmp_rec_counted(const void *a, const void *b)
+{
+    xsort_cmp_calls++;
+    return cmp_rec((const Rec *)a, (const Rec *)b);
+}
+
+void test_external_sort(void)
+{
+    TEST("External Merge Sort (Loser Tree)");
+
+    const char *in = tmp_path("unsorted.bin");
+    const char *out = tmp_path("sorted.bin");
+    unsigned seed = 12345;
+    long long key_sum = 0;
+    zvec_Rec recs = zvec_init(Rec);
+    int i;
+    for (i = 0; i < XSORT_COUNT; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        Rec r = {(int)(seed >> 8) % 50000, (double)i};
+        key_sum += r.key;
+        zvec_push(&recs, r);
+    }
+    FILE *f = fopen(in, "wb");
+    assert(f && fwrite(recs.data, sizeof(Rec), recs.length, f) == recs.length);
+    fclose(f);
+    zvec_free(&recs);
+
+    // 256 KiB: ~28 runs and a fan-in of 3, so intermediate passes run too.
+    assert(Z_OK == zvec_external_sort(in, out, Rec, cmp_rec, 256 * 1024));
+    check_sorted_file(out, XSORT_COUNT, key_sum);
+
+    // Everything fits in one run.
+    assert(Z_OK == zvec_external_sort(in, out, Rec, cmp_rec, 64 << 20));
+    check_sorted_file(out, XSORT_COUNT, key_sum);
+
+    // Empty input, partial trailing record, missing input.
+    f = fopen(in, "wb");
+    fclose(f);
+    assert(Z_OK == zvec_external_sort(in, out, Rec, cmp_rec, 1 << 20));
+    check_sorted_file(out, 0, 0);
+    f = fopen(in, "wb");
+    fwrite("short", 1, 5, f);
+    fclose(f);
+    assert(Z_EINVAL == zvec_external_sort(in, out, Rec, cmp_rec, 1 << 20));
+    remove(in);
+    assert(Z_ERR == zvec_external_sort(in, out, Rec, cmp_rec, 1 << 20));
+
+    // Spill reads failing: before the tree is built (the cursors are never
+    // compared) and mid-merge, when a run turns out shorter than recorded.
+    Rec four[4] = {{3, 0}, {1, 1}, {2, 2}, {0, 3}};
+    zvec_xsort_run runs[2] = {{0, 2}, {2 * sizeof(Rec), 10}};
+    f = fopen(in, "wb");
+    assert(f && 4 == fwrite(four, sizeof(Rec), 4, f));
+    fclose(f);
+    int dst = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int src = open(in, O_WRONLY);
+    assert(dst >= 0 && src >= 0);
+    xsort_cmp_calls = 0;
+    assert(Z_ERR == zvec_xsort_merge_impl(src, runs, 2, dst, sizeof(Rec), cmp_rec_counted,
+                                          3 * sizeof(Rec)));
+    assert(0 == xsort_cmp_calls);
+    close(src);
+    src = open(in, O_RDONLY);
+    assert(src >= 0);
+    assert(Z_EINVAL == zvec_xsort_merge_impl(src, runs, 2, dst, sizeof(Rec), cmp_rec_counted,
+                                             3 * sizeof(Rec)));
+    close(src);
+    close(dst);
+    remove(in);
+    remove(out);
+    PASS();
+}
+
+#define PAGED_COUNT 200000
+
+void test_paged_vector(void)
+{
+    TEST("Paged Vector (LRU, Out-of-Core)");
+
+    const char *path = tmp_path("paged.bin");
+    zvec_paged_Int p;
+    int i;
+    assert(Z_OK == zvec_paged_open(&p, path, 3));
+    for (i = 0; i < PAGED_COUNT; i += 1000)
+    {
+        int chunk[1000], k;
+        for (k = 0; k < 1000; ++k)
+        {
+            chunk[k] = i + k;
+        }
+        if (i % 2000 == 0)
+        {
+            assert(Z_OK == zvec_paged_extend(&p, chunk, 1000));
+        }
+        else
+        {
+            for (k = 0; k < 1000; ++k)
+            {
+                assert(Z_OK == zvec_paged_push(&p, chunk[k]));
+            }
+        }
+    }
+    assert(zvec_paged_size(&p) == PAGED_COUNT);
+    assert(p.core.nframes == 3 && p.core.writebacks > 0);
+
+    // Random access faults pages back in; writes survive eviction.
+    *zvec_paged_at(&p, 5) = -5;
+    *zvec_paged_at(&p, 150000) = -150000;
+    assert(*zvec_paged_peek(&p, 199999) == 199999);
+    assert(*zvec_paged_peek(&p, 5) == -5);
+    assert(NULL == zvec_paged_at(&p, PAGED_COUNT));
+
+    long long sum = 0;
+    size_t n = 0;
+    zvec_paged_prefetch(&p, 0, PAGED_COUNT);
+    zvec_paged_foreach(&p, it)
+    {
+        sum += *it;
+        n++;
+    }
+    assert(n == PAGED_COUNT);
+    assert(sum == (long long)PAGED_COUNT * (PAGED_COUNT - 1) / 2 - 10 - 300000);
+
+    // 'break' ends the whole scan, not just the current page.
+    n = 0;
+    zvec_paged_foreach(&p, it)
+    {
+        if (*it == 77777)
+        {
+            break;
+        }
+        n++;
+    }
+    assert(n == 77777);
+    assert(p.core.nframes == 3);
+    assert(Z_OK == zvec_paged_close(&p));
+
+    // The backing file is plain records and reopens with its length.
+    struct stat st;
+    assert(0 == stat(path, &st) && st.st_size == PAGED_COUNT * (off_t)sizeof(int));
+    assert(Z_OK == zvec_paged_open(&p, path, 2));
+    assert(zvec_paged_size(&p) == PAGED_COUNT);
+    assert(*zvec_paged_peek(&p, 150000) == -150000 && *zvec_paged_peek(&p, 77777) == 77777);
+    assert(Z_OK == zvec_paged_close(&p));
+
+    // Anonymous backing store.
+    assert(Z_OK == zvec_paged_open(&p, NULL, 1));
+    assert(Z_OK == zvec_paged_push(&p, 1) && *zvec_paged_peek(&p, 0) == 1);
+    assert(Z_OK == zvec_paged_close(&p));
+    remove(path);
+    PASS();
+}
+
+void test_fd_io(void)
+{
+    TEST("Direct fd I/O (Partial Carry)");
+
+    Rec src[64];
+    const char *bytes = (const char *)src;
+    int i, fds[2];
+    for (i = 0; i < 64; ++i)
+    {
+        src[i].key = i;
+        src[i].value = i * 1.5;
+    }
+
+    // Non-blocking pipe fed in odd-sized pieces: fragments carry across calls.
+    assert(0 == pipe(fds));
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    zvec_Rec v = zvec_init(Rec);
+    size_t part = 0, sent = 0;
+    assert(Z_EEMPTY == zvec_read_fd(&v, fds[0], 8, &part));
+    while (sent < sizeof(src))
+    {
+        size_t n = (sizeof(src) - sent < 37) ? sizeof(src) - sent : 37;
+        assert((ssize_t)n == write(fds[1], bytes + sent, n));
+        sent += n;
+        assert(zvec_read_fd(&v, fds[0], 8, &part) >= 0);
+        assert(v.length == (sent - part) / sizeof(Rec) && part == sent % sizeof(Rec));
+    }
+    close(fds[1]);
+    while (zvec_read_fd(&v, fds[0], 8, &part) > 0)
+    {
+    }
+    assert(0 == part && v.length == 64);
+    assert(0 == memcmp(v.data, src, sizeof(src)));
+    close(fds[0]);
+
+    // Blocking mode: the writer trickles 5 bytes at a time.
+    assert(0 == pipe(fds));
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (0 == pid)
+    {
+        close(fds[0]);
+        for (sent = 0; sent < sizeof(src); sent += 5)
+        {
+            size_t n = (sizeof(src) - sent < 5) ? sizeof(src) - sent : 5;
+            if ((ssize_t)n != write(fds[1], bytes + sent, n))
+            {
+                _exit(1);
+            }
+            sched_yield();
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+    zvec_clear(&v);
+    ssize_t got;
+    while ((got = zvec_read_fd(&v, fds[0], 16, NULL)) > 0)
+    {
+    }
+    assert(0 == got && v.length == 64 && 0 == memcmp(v.data, src, sizeof(src)));
+    close(fds[0]);
+    int status;
+    assert(pid == waitpid(pid, &status, 0) && WIFEXITED(status) && 0 == WEXITSTATUS(status));
+
+    // writev of several vectors, then positional reads.
+    const char *path = tmp_path("fdio.bin");
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    assert(fd >= 0);
+    zvec_Int head = zvec_from(Int, 1, 2, 3, 4);
+    zvec_Rec empty = zvec_init(Rec);
+    struct iovec iov[3] = {ZVEC_IOV(&head), ZVEC_IOV(&empty), ZVEC_IOV(&v)};
+    assert(Z_OK == zvec_writev_fd(fd, iov, 3));
+    assert(Z_OK == zvec_write_fd(&head, fd));
+
+    zvec_Rec back = zvec_init(Rec);
+    assert(64 == zvec_pread_fd(&back, fd, 64, sizeof(int) * 4));
+    assert(64 == zvec_pread_fd(&back, fd, 100, sizeof(int) * 4 + 4) && back.length == 128);
+    assert(0 == memcmp(back.data, src, sizeof(src)));
+    zvec_Int tail = zvec_init(Int);
+    assert(4 == zvec_pread_fd(&tail, fd, 4, sizeof(int) * 4 + sizeof(src)));
+    assert(0 == memcmp(tail.data, head.data, 4 * sizeof(int)));
+    assert(0 == zvec_pread_fd(&tail, fd, 4, 1 << 20));
+    close(fd);
+    remove(path);
+
+    zvec_free(&v);
+    zvec_free(&head);
+    zvec_free(&back);
+    zvec_free(&tail);
+    PASS();
+}
+
+#define STREAM_COUNT 1000003
+
+void test_stream_loader(void)
+{
+    TEST("Streaming Loader (Double Buffer)");
+
+    const char *path = tmp_path("stream.bin");
+    zvec_Int all = zvec_init(Int);
+    int i;
+    for (i = 0; i < STREAM_COUNT; ++i)
+    {
+        zvec_push(&all, i * 3);
+    }
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    assert(fd >= 0 && Z_OK == zvec_write_fd(&all, fd));
+    close(fd);
+
+    zvec_stream_Int s;
+    zvec_Int *chunk;
+    void *seen[2] = {NULL, NULL};
+    size_t total = 0, chunks = 0;
+    assert(Z_OK == zvec_stream_open(&s, path, 4096));
+    while ((chunk = zvec_stream_next_chunk(&s)))
+    {
+        assert(chunk->length == 4096 || total + chunk->length == STREAM_COUNT);
+        assert(0 == memcmp(chunk->data, all.data + total, chunk->length * sizeof(int)));
+        // Only the two buffers ever circulate.
+        assert(chunk->data == seen[0] || chunk->data == seen[1] || !seen[chunks & 1]);
+        seen[chunks & 1] = chunk->data;
+        total += chunk->length;
+        chunks++;
+    }
+    assert(Z_OK == s.core.error && total == STREAM_COUNT);
+    assert(chunks == (STREAM_COUNT + 4095) / 4096);
+    assert(NULL == zvec_stream_next_chunk(&s));
+    zvec_stream_close(&s);
+
+    // Early close while the loader is busy, and a trailing partial record.
+    assert(Z_OK == zvec_stream_open(&s, path, 100));
+    assert(zvec_stream_next_chunk(&s)->length == 100);
+    zvec_stream_close(&s);
+    assert(0 == truncate(path, 10 * sizeof(int) + 2));
+    assert(Z_OK == zvec_stream_open(&s, path, 64));
+    chunk = zvec_stream_next_chunk(&s);
+    assert(chunk && chunk->length == 10);
+    assert(NULL == zvec_stream_next_chunk(&s) && Z_EINVAL == s.core.error);
+    zvec_stream_close(&s);
+
+    remove(path);
+    zvec_free(&all);
+    PASS();
+}
+
+// True if the checkpoint file at path holds exactly t's vector.
+static int ckpt_matches(const char *path, const zvec_Int *vec)
+{
+    zvec_Int view = zvec_view_mmap(Int, path);
+    int ok = view.data && view.length == vec->length &&
+             0 == memcmp(view.data, vec->data, vec->length * sizeof(int));
+    zvec_unmap(&view);
+    return ok;
+}
+
+void test_checkpoint(void)
+{
+    TEST("Incremental Checkpoint");
+
+    char path_a[256], path_b[256];
+    strcpy(path_a, tmp_path("state.a"));
+    strcpy(path_b, tmp_path("state.b"));
+    const size_t per_page = ZVEC_CKPT_PAGE_BYTES / sizeof(int);
+    const uint64_t marker_off = ZVEC_FILE_HEADER_SIZE + 5 * per_page * sizeof(int);
+    zvec_track_Int t, other;
+    int i, probe = -1;
+    zvec_track_init(&t);
+    for (i = 0; i < 10000; ++i)
+    {
+        assert(Z_OK == zvec_track_push(&t, i));
+    }
+    int fa = open(path_a, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    int fb = open(path_b, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    assert(fa >= 0 && fb >= 0);
+    assert(Z_ENOTFOUND == zvec_checkpoint_pick(fa, fb));
+    assert(Z_OK == zvec_checkpoint(&t, fa, fb));       // 1 -> a (full).
+    assert(0 == zvec_checkpoint_pick(fa, fb));
+    assert(Z_OK == zvec_checkpoint(&t, fa, fb));       // 2 -> b (full).
+    assert(1 == zvec_checkpoint_pick(fa, fb));
+    assert(ckpt_matches(path_a, &t.vec) && ckpt_matches(path_b, &t.vec));
+    assert(Z_OK == zvec_verify_file(path_a));
+
+    // Plant a marker in a clean page of a: the next checkpoint must not rewrite it.
+    assert(sizeof(int) == pwrite(fa, &probe, sizeof(int), (off_t)marker_off));
+    *zvec_track_at(&t, 10) = 777;
+    *zvec_track_push_slot(&t) = 10000;
+    assert(NULL == zvec_track_at(&t, 20000));
+    assert(Z_OK == zvec_checkpoint(&t, fa, fb));       // 3 -> a (incremental).
+    assert(0 == zvec_checkpoint_pick(fa, fb));
+    zvec_Int view = zvec_view_mmap(Int, path_a);
+    assert(view.length == 10001 && view.data[10] == 777 && view.data[10000] == 10000);
+    assert(view.data[5 * per_page] == -1);
+    zvec_unmap(&view);
+
+    // b missed checkpoint 3, so it gets the pages of both intervals.
+    *zvec_track_at(&t, 2 * per_page) = 888;
+    assert(Z_OK == zvec_checkpoint(&t, fa, fb));       // 4 -> b.
+    assert(1 == zvec_checkpoint_pick(fa, fb) && ckpt_matches(path_b, &t.vec));
+
+    // A crash while writing a leaves it torn, and b still loads.
+    uint32_t flags = ZVEC_FILE_LIVE | ZVEC_FILE_TORN;
+    assert(sizeof(flags) == pwrite(fa, &flags, sizeof(flags),
+                                   offsetof(zvec_file_header, flags)));
+    assert(Z_EINVAL == zvec_verify_file(path_a));
+    assert(NULL == zvec_view_mmap(Int, path_a).data);
+    assert(1 == zvec_checkpoint_pick(fa, fb) && ckpt_matches(path_b, &t.vec));
+    assert(Z_OK == zvec_checkpoint(&t, fa, fb));       // 5 -> a (full: torn).
+    assert(0 == zvec_checkpoint_pick(fa, fb) && ckpt_matches(path_a, &t.vec));
+
+    // Another tracker's file of the same length is rewritten in full.
+    zvec_track_init(&other);
+    for (i = 0; i < 10001; ++i)
+    {
+        assert(Z_OK == zvec_track_push(&other, -i));
+    }
+    assert(Z_OK == zvec_checkpoint(&other, fb, fa));   // Overwrites b.
+    *zvec_track_at(&t, 0) = 5;
+    assert(Z_OK == zvec_checkpoint(&t, fa, fb));       // 6 -> b.
+    assert(ckpt_matches(path_b, &t.vec));
+    zvec_track_free(&other);
+
+    // A remove shifts everything after it; direct edits need an explicit mark.
+    zvec_track_remove(&t, 5 * per_page - 1);
+    t.vec.data[1] = 111;
+    zvec_track_mark(&t, 1, 1);
+    assert(Z_OK == zvec_checkpoint(&t, fa, fb));       // 7 -> a.
+    assert(Z_OK == zvec_checkpoint(&t, fa, fb));       // 8 -> b.
+    assert(ckpt_matches(path_a, &t.vec) && ckpt_matches(path_b, &t.vec));
+    struct stat st;
+    assert(0 == fstat(fa, &st) && st.st_size == ZVEC_FILE_HEADER_SIZE + 10000 * sizeof(int));
+
+    close(fa);
+    close(fb);
+    remove(path_a);
+    remove(path_b);
+    zvec_track_free(&t);
+    PASS();
+}
+
+int main(void)
+{
+    printf("=> Running tests (zvec.h, I/O).\n");
+    assert(mkdtemp(g_dir));
+
+    test_save_view_mmap();
+    test_view_mmap_rejects();
+    test_file_backed_vector();
+    test_durable_log();
+    test_shm_vector();
+    test_external_sort();
+    test_paged_vector();
+    test_fd_io();
+    test_stream_loader();
+    test_checkpoint();
+
+    remove(tmp_path("recs.zvec"));
+    remove(tmp_path("ints.zvec"));
+    remove(tmp_path("log.zvec"));
+    remove(tmp_path("ingest.log"));
+    rmdir(g_dir);
+    printf("=> All tests passed successfully.\n");
+    return 0;
+}
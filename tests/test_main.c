@@ -10,6 +10,8 @@ typedef struct
 
 #define REGISTER_ZVEC_TYPES(X) \
     X(int, Int)                \
+    X(float, Float)            \
+    X(double, Double)          \
     X(Vec2, Vec2)
 
 #include "zvec.h"
@@ -204,6 +206,403 @@ void test_algorithms(void)
     PASS();
 }
 
+void test_stable_sort(void)
+{
+    TEST("Stable Sort (Runs, Scratch Reuse)");
+
+    // Small input goes through insertion sort; equal keys keep their order.
+    zvec_Vec2 pts = zvec_from(Vec2, {3, 0}, {1, 1}, {3, 2}, {1, 3}, {2, 4});
+    assert(Z_OK == zvec_stable_sort(&pts, cmp_vec2_x, NULL));
+    assert(zvec_at(&pts, 0)->y == 1 && zvec_at(&pts, 1)->y == 3);
+    assert(zvec_at(&pts, 3)->y == 0 && zvec_at(&pts, 4)->y == 2);
+
+    // Large input with few distinct keys exercises run merging and galloping.
+    zvec_Vec2 scratch = zvec_init(Vec2);
+    unsigned seed = 12345;
+    size_t i;
+    zvec_clear(&pts);
+    for (i = 0; i < 5000; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        Vec2 *p = zvec_push_slot(&pts);
+        p->x = (float)((seed >> 16) % 50);
+        p->y = (float)i;
+    }
+    assert(Z_OK == zvec_stable_sort(&pts, cmp_vec2_x, &scratch));
+    assert(scratch.capacity > 0 && scratch.length == 0);
+    for (i = 1; i < pts.length; ++i)
+    {
+        Vec2 *a = zvec_at(&pts, i - 1);
+        Vec2 *b = zvec_at(&pts, i);
+        assert(a->x < b->x || (a->x == b->x && a->y < b->y));
+    }
+
+    // Nearly sorted and descending inputs.
+    zvec_Int v = zvec_init(Int);
+    for (i = 0; i < 3000; ++i)
+    {
+        zvec_push(&v, (int)i);
+    }
+    for (i = 0; i < 3000; i += 97)
+    {
+        *zvec_at(&v, i) = (int)(3000 - i);
+    }
+    for (i = 0; i < 1000; ++i)
+    {
+        zvec_push(&v, (int)(1000 - i));
+    }
+    assert(Z_OK == zvec_stable_sort(&v, cmp_int, NULL));
+    for (i = 1; i < v.length; ++i)
+    {
+        assert(*zvec_at(&v, i - 1) <= *zvec_at(&v, i));
+    }
+
+    zvec_free(&v);
+    zvec_free(&pts);
+    zvec_free(&scratch);
+    PASS();
+}
+
+void test_set_algebra(void)
+{
+    TEST("Merge, Union, Intersect, Diff, Uniq");
+
+    zvec_Int a = zvec_from(Int, 1, 3, 5, 7, 9);
+    zvec_Int b = zvec_from(Int, 3, 4, 5, 10);
+    zvec_Int out = zvec_init(Int);
+
+    assert(Z_OK == zvec_merge(&out, &a, &b, cmp_int)); // [1, 3, 3, 4, 5, 5, 7, 9, 10].
+    assert(out.length == 9 && *zvec_at(&out, 2) == 3 && *zvec_last(&out) == 10);
+
+    assert(Z_OK == zvec_union(&out, &a, &b, cmp_int)); // [1, 3, 4, 5, 7, 9, 10].
+    assert(out.length == 7 && *zvec_at(&out, 2) == 4);
+
+    assert(Z_OK == zvec_intersect(&out, &a, &b, cmp_int)); // [3, 5].
+    assert(out.length == 2 && *zvec_at(&out, 0) == 3 && *zvec_at(&out, 1) == 5);
+
+    assert(Z_OK == zvec_difference(&out, &a, &b, cmp_int)); // [1, 7, 9].
+    assert(out.length == 3 && *zvec_at(&out, 1) == 7);
+
+    // In place into the first input.
+    assert(Z_OK == zvec_union(&a, &a, &b, cmp_int));
+    assert(a.length == 7 && *zvec_at(&a, 0) == 1 && *zvec_last(&a) == 10);
+
+    // Skewed sizes take the galloping path.
+    zvec_Int big = zvec_init(Int);
+    int i;
+    for (i = 0; i < 10000; ++i)
+    {
+        zvec_push(&big, i * 2);
+    }
+    zvec_Int small = zvec_from(Int, 7, 100, 101, 9998, 19998, 30000);
+    assert(Z_OK == zvec_intersect(&out, &small, &big, cmp_int));
+    assert(out.length == 3 && *zvec_at(&out, 0) == 100 && *zvec_at(&out, 2) == 19998);
+    assert(Z_OK == zvec_intersect(&big, &big, &small, cmp_int));
+    assert(big.length == 3 && *zvec_at(&big, 1) == 9998);
+
+    // zvec_unique.
+    zvec_Int dups = zvec_from(Int, 1, 1, 2, 3, 3, 3, 4);
+    assert(zvec_unique(&dups, cmp_int) == 4);
+    assert(*zvec_at(&dups, 2) == 3 && *zvec_last(&dups) == 4);
+
+    zvec_free(&a);
+    zvec_free(&b);
+    zvec_free(&out);
+    zvec_free(&big);
+    zvec_free(&small);
+    zvec_free(&dups);
+    PASS();
+}
+
+void test_roaring(void)
+{
+    TEST("Roaring Set (Build, And, Or, Expand)");
+
+    // Dense block (becomes a bitmap) plus a few sparse ids.
+    zvec_Int ids = zvec_init(Int);
+    int i;
+    for (i = 0; i < 10000; ++i)
+    {
+        zvec_push(&ids, i);
+    }
+    zvec_push(&ids, 70000);
+    zvec_push(&ids, 1 << 24);
+
+    zvec_roar a = zvec_roar_init();
+    zvec_roar b = zvec_roar_init();
+    zvec_roar out = zvec_roar_init();
+    assert(Z_OK == zvec_roar_from_vec(&a, &ids));
+    assert(zvec_roar_cardinality(&a) == 10002);
+    assert(zvec_roar_contains(&a, 9999) && zvec_roar_contains(&a, 70000));
+    assert(!zvec_roar_contains(&a, 10000));
+
+    for (i = 0; i < 20000; i += 2)
+    {
+        zvec_roar_add(&b, (uint32_t)i);
+    }
+    zvec_roar_add(&b, 70000);
+    assert(zvec_roar_and_cardinality(&a, &b) == 5001);
+
+    assert(Z_OK == zvec_roar_and(&out, &a, &b));
+    assert(zvec_roar_cardinality(&out) == 5001);
+    assert(zvec_roar_contains(&out, 9998) && !zvec_roar_contains(&out, 9999));
+
+    assert(Z_OK == zvec_roar_or(&out, &a, &b));
+    assert(zvec_roar_cardinality(&out) == 15002);
+
+    // Sparse array containers sharing many values (SSE2 8x8 intersection),
+    // checked against a scalar merge of the sorted inputs.
+    zvec_roar c = zvec_roar_init();
+    zvec_roar d = zvec_roar_init();
+    zvec_Int cv = zvec_init(Int);
+    zvec_Int dv = zvec_init(Int);
+    zvec_Int ref_and = zvec_init(Int);
+    zvec_Int ref_or = zvec_init(Int);
+    zvec_Int got = zvec_init(Int);
+    for (i = 0; i < 3000; ++i)
+    {
+        zvec_push(&cv, (5 << 16) + i * 3 + (i % 7 == 0));
+    }
+    for (i = 0; i < 2000; ++i)
+    {
+        zvec_push(&dv, (5 << 16) + i * 5);
+        if (i % 50 == 0)
+        {
+            zvec_push(&dv, (6 << 16) + i);      // Container only d has.
+        }
+    }
+    zvec_sort(&dv, cmp_int);
+    assert(Z_OK == zvec_roar_from_vec(&c, &cv));
+    assert(Z_OK == zvec_roar_from_vec(&d, &dv));
+    size_t x = 0, y = 0;
+    while (x < cv.length || y < dv.length)
+    {
+        if (y == dv.length || (x < cv.length && cv.data[x] < dv.data[y]))
+        {
+            zvec_push(&ref_or, cv.data[x++]);
+        }
+        else if (x == cv.length || dv.data[y] < cv.data[x])
+        {
+            zvec_push(&ref_or, dv.data[y++]);
+        }
+        else
+        {
+            zvec_push(&ref_and, cv.data[x]);
+            zvec_push(&ref_or, cv.data[x]);
+            x++;
+            y++;
+        }
+    }
+    assert(ref_and.length >= 8);
+    assert(zvec_roar_and_cardinality(&c, &d) == ref_and.length);
+    assert(Z_OK == zvec_roar_and(&out, &c, &d));
+    assert(Z_OK == zvec_roar_to_vec(&out, &got));
+    assert(got.length == ref_and.length);
+    assert(0 == memcmp(got.data, ref_and.data, got.length * sizeof(int)));
+    assert(Z_OK == zvec_roar_or(&out, &c, &d));
+    got.length = 0;
+    assert(Z_OK == zvec_roar_to_vec(&out, &got));
+    assert(got.length == ref_or.length);
+    assert(0 == memcmp(got.data, ref_or.data, got.length * sizeof(int)));
+    zvec_roar_free(&c);
+    zvec_roar_free(&d);
+    zvec_free(&cv);
+    zvec_free(&dv);
+    zvec_free(&ref_and);
+    zvec_free(&ref_or);
+    zvec_free(&got);
+
+    // Expand back into a sorted vector.
+    zvec_Int back = zvec_init(Int);
+    assert(Z_OK == zvec_roar_to_vec(&a, &back));
+    assert(back.length == ids.length);
+    assert(0 == memcmp(back.data, ids.data, ids.length * sizeof(int)));
+
+    zvec_roar_free(&a);
+    zvec_roar_free(&b);
+    zvec_roar_free(&out);
+    zvec_free(&ids);
+    zvec_free(&back);
+    PASS();
+}
+
+void test_bits(void)
+{
+    TEST("Bit Vector (Count, Scan, Rank/Select)");
+
+    zvec_bits b = zvec_bits_init();
+    size_t i;
+    for (i = 0; i < 1000; ++i)
+    {
+        zvec_bits_push(&b, i % 3 == 0);
+    }
+    assert(b.length == 1000);
+    assert(zvec_bits_at(&b, 3) == 1 && zvec_bits_at(&b, 4) == 0);
+    assert(zvec_bits_count(&b) == 334);
+    assert(zvec_bits_find_next_set(&b, 4) == 6);
+    assert(zvec_bits_find_next_set(&b, 1000) == ZVEC_BITS_NONE);
+
+    // Visited-set idiom.
+    assert(zvec_bits_test_and_set(&b, 5) == 0);
+    assert(zvec_bits_test_and_set(&b, 5) == 1);
+    zvec_bits_set(&b, 5, 0);
+
+    // Rank/select agree with and without the index.
+    assert(zvec_bits_rank(&b, 10) == 4);
+    assert(zvec_bits_select(&b, 100) == 300);
+    assert(Z_OK == zvec_bits_build_rank(&b));
+    assert(zvec_bits_rank(&b, 10) == 4);
+    assert(zvec_bits_rank(&b, 1000) == 334);
+    assert(zvec_bits_select(&b, 100) == 300);
+    assert(zvec_bits_select(&b, 334) == ZVEC_BITS_NONE);
+
+    size_t seen = 0;
+    zvec_bits_foreach_set(&b, idx)
+    {
+        assert(idx % 3 == 0);
+        seen++;
+    }
+    assert(seen == 334);
+
+    // Truncation keeps the tail zeroed; growth adds zero bits.
+    assert(zvec_bits_pop_get(&b) == 1); // Bit 999.
+    zvec_bits_resize(&b, 10);
+    zvec_bits_resize(&b, 2000);
+    assert(zvec_bits_count(&b) == 4);
+
+    zvec_bits_clear(&b);
+    assert(zvec_bits_is_empty(&b) && zvec_bits_count(&b) == 0);
+    zvec_bits_free(&b);
+    PASS();
+}
+
+void test_packed(void)
+{
+    TEST("Packed Ints (FOR, Delta, Decode)");
+
+    zvec_packed p = zvec_packed_init();
+    zvec_Int src = zvec_init(Int);
+    zvec_Int out = zvec_init(Int);
+    int i, ts = 1000000;
+
+    // Empty in both directions (no data pointer yet on either side).
+    assert(Z_OK == zvec_packed_to_vec(&p, &out) && 0 == out.length);
+    assert(Z_OK == zvec_packed_from_vec(&p, &out) && 0 == p.length);
+
+    for (i = 0; i < 1000; ++i)
+    {
+        ts += i % 7;                  // Sorted, small deltas.
+        zvec_push(&src, ts);
+    }
+    for (i = 0; i < 300; ++i)
+    {
+        zvec_push(&src, 500 + (i * 37) % 100); // Unsorted, narrow range.
+    }
+    assert(Z_OK == zvec_packed_from_vec(&p, &src));
+    assert(p.length == 1300);
+    assert(zvec_packed_bytes(&p) < src.length * sizeof(int) / 4);
+
+    // Random access into delta blocks, FOR blocks and the open tail.
+    assert(zvec_packed_at(&p, 0) == *zvec_at(&src, 0));
+    assert(zvec_packed_at(&p, 777) == *zvec_at(&src, 777));
+    assert(zvec_packed_at(&p, 1100) == *zvec_at(&src, 1100));
+    assert(zvec_packed_at(&p, 1299) == *zvec_at(&src, 1299));
+
+    assert(Z_OK == zvec_packed_to_vec(&p, &out));
+    assert(out.length == src.length);
+    assert(0 == memcmp(out.data, src.data, src.length * sizeof(int)));
+
+    // Whole blocks only, so the open tail is empty.
+    zvec_packed_free(&p);
+    p = zvec_packed_init();
+    assert(Z_OK == zvec_packed_extend(&p, src.data, 1280) && 0 == p.tail_len);
+    out.length = 0;
+    assert(Z_OK == zvec_packed_to_vec(&p, &out));
+    assert(out.length == 1280 && 0 == memcmp(out.data, src.data, 1280 * sizeof(int)));
+
+    zvec_packed_free(&p);
+    zvec_free(&src);
+    zvec_free(&out);
+    PASS();
+}
+
+void test_parse(void)
+{
+    TEST("Text Parsing (Ints, Floats)");
+
+    zvec_Int ints = zvec_init(Int);
+    const char *csv = "12,-7, 0042\r\n2147483647,-2147483648,+5\n";
+    assert(Z_OK == zvec_parse_ints(&ints, csv, strlen(csv), ','));
+    assert(ints.length == 6);
+    assert(ints.data[0] == 12 && ints.data[1] == -7 && ints.data[2] == 42);
+    assert(ints.data[3] == 2147483647 && ints.data[4] == (-2147483647 - 1) && ints.data[5] == 5);
+
+    // Long columns exercise the 16-byte scan and the 8-digit conversion.
+    char *col = (char *)malloc(20000 * 12);
+    size_t len = 0;
+    int i;
+    for (i = 0; i < 20000; ++i)
+    {
+        len += (size_t)sprintf(col + len, "%d\n", i * 104729 - 1000000000);
+    }
+    assert(Z_OK == zvec_parse_ints(&ints, col, len, '\n'));
+    assert(ints.length == 20006);
+    for (i = 0; i < 20000; ++i)
+    {
+        assert(ints.data[6 + i] == i * 104729 - 1000000000);
+    }
+
+    // Bad or out-of-range fields fail the call and leave the vector untouched.
+    assert(Z_EINVAL == zvec_parse_ints(&ints, "1,x,3", 5, ','));
+    assert(Z_EINVAL == zvec_parse_ints(&ints, "1,,3", 4, ','));
+    assert(Z_EINVAL == zvec_parse_ints(&ints, "2147483648", 10, ','));
+    assert(Z_EINVAL == zvec_parse_ints(&ints, "1.5", 3, ','));
+    assert(ints.length == 20006);
+    assert(Z_OK == zvec_parse_ints(&ints, "", 0, ','));
+    assert(ints.length == 20006);
+
+    zvec_Double d = zvec_init(Double);
+    const char *nums = "3.25;-0.1;1e3;  6.02214076e23;0.000001;inf;1e-320;12345678901234567890.5";
+    assert(Z_OK == zvec_parse_floats(&d, nums, strlen(nums), ';'));
+    assert(d.length == 8);
+    assert(d.data[0] == 3.25 && d.data[1] == -0.1 && d.data[2] == 1000.0);
+    assert(d.data[3] == strtod("6.02214076e23", NULL) && d.data[4] == 0.000001);
+    assert(d.data[5] > 1e308 && d.data[6] == strtod("1e-320", NULL));
+    assert(d.data[7] == strtod("12345678901234567890.5", NULL));
+    assert(Z_EINVAL == zvec_parse_floats(&d, "1e", 2, ';'));
+    assert(Z_EINVAL == zvec_parse_floats(&d, ".", 1, ';'));
+    assert(Z_EINVAL == zvec_parse_floats(&d, "1;1e400", 7, ';'));
+    assert(Z_EINVAL == zvec_parse_floats(&d, "-1e400", 6, ';'));
+    assert(d.length == 8);
+
+    zvec_Float f = zvec_init(Float);
+    assert(Z_OK == zvec_parse_floats(&f, "0.1\n-2.5e-3\n3.4028235e38\n", 25, '\n'));
+    assert(f.length == 3 && f.data[0] == 0.1f && f.data[1] == -2.5e-3f);
+    assert(f.data[2] == 3.4028235e38f);
+    assert(Z_EINVAL == zvec_parse_floats(&f, "1e39", 4, '\n'));
+    assert(Z_OK == zvec_parse_floats(&f, "-inf\n1e-50", 10, '\n'));
+    assert(f.length == 5 && f.data[3] < -3.4028235e38f && f.data[4] == 0.0f);
+    zvec_free(&f);
+
+    len = 0;
+    for (i = 0; i < 20000; ++i)
+    {
+        len += (size_t)sprintf(col + len, "%.3f,", (i - 10000) * 0.125);
+    }
+    d.length = 0;
+    assert(Z_OK == zvec_parse_floats(&d, col, len, ','));
+    assert(d.length == 20000);
+    for (i = 0; i < 20000; ++i)
+    {
+        assert(d.data[i] == (i - 10000) * 0.125);
+    }
+
+    free(col);
+    zvec_free(&ints);
+    zvec_free(&d);
+    PASS();
+}
+
 // Extension test (GCC/Clang only).
 #if defined(__GNUC__) || defined(__clang__)
 void test_autofree(void) 
@@ -230,6 +629,12 @@ int main(void)
     test_data_access();
     test_modification();
     test_algorithms();
+    test_stable_sort();
+    test_set_algebra();
+    test_roaring();
+    test_bits();
+    test_packed();
+    test_parse();
 
 #if defined(__GNUC__) || defined(__clang__)
     test_autofree();
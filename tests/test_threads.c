@@ -0,0 +1,902 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+typedef struct
+{
+    int id;
+    int priority;
+} Task;
+
+#define ZVEC_ENABLE_THREADS
+#define ZVEC_PAR_THREADS 3
+#define REGISTER_ZVEC_TYPES(X) \
+    X(int, Int)                \
+    X(Task, Task)
+
+#include "zvec.h"
+
+#define TEST(name) printf("[TEST] %-35s", name);
+#define PASS() printf(" \033[0;32mPASS\033[0m\n")
+
+#define N_THREADS   8
+#define PER_THREAD  20000
+
+static zvec_conc_Int g_conc;
+
+static void *conc_producer(void *arg)
+{
+    int base = (int)(size_t)arg * PER_THREAD;
+    int i;
+    for (i = 0; i < PER_THREAD; i += 4)
+    {
+        if (i % 8 == 0)
+        {
+            int batch[4] = {base + i, base + i + 1, base + i + 2, base + i + 3};
+            assert(Z_OK == zvec_conc_extend(&g_conc, batch, 4));
+        }
+        else
+        {
+            int k;
+            for (k = 0; k < 4; ++k)
+            {
+                size_t idx;
+                int *slot = zvec_conc_push_slot(&g_conc, &idx);
+                assert(slot);
+                *slot = base + i + k;
+                zvec_conc_publish(&g_conc, idx);
+            }
+        }
+    }
+    return NULL;
+}
+
+void test_conc_append(void)
+{
+    TEST("Concurrent Append (Multi-Producer)");
+
+    pthread_t th[N_THREADS];
+    size_t i;
+    g_conc = zvec_conc_init(Int);
+    for (i = 0; i < N_THREADS; ++i)
+    {
+        pthread_create(&th[i], NULL, conc_producer, (void *)i);
+    }
+    for (i = 0; i < N_THREADS; ++i)
+    {
+        pthread_join(th[i], NULL);
+    }
+
+    assert(zvec_conc_size(&g_conc) == N_THREADS * PER_THREAD);
+    assert(zvec_conc_watermark(&g_conc) == N_THREADS * PER_THREAD);
+    assert(zvec_conc_at(&g_conc, N_THREADS * PER_THREAD) == NULL);
+
+    // Every value shows up exactly once.
+    zvec_Int all = zvec_init(Int);
+    assert(Z_OK == zvec_conc_to_vec(&g_conc, &all));
+    assert(all.length == N_THREADS * PER_THREAD);
+    char *seen = calloc(all.length, 1);
+    zvec_foreach(&all, it)
+    {
+        assert(!seen[*it]);
+        seen[*it] = 1;
+    }
+    free(seen);
+
+    zvec_free(&all);
+    zvec_conc_free(&g_conc);
+    PASS();
+}
+
+#define SPSC_COUNT 200000
+
+static void *spsc_producer(void *arg)
+{
+    zvec_spsc_Task *q = (zvec_spsc_Task *)arg;
+    int next = 0;
+    while (next < SPSC_COUNT)
+    {
+        if (next % 3 == 0)
+        {
+            // Zero-copy slot.
+            Task *slot = zvec_spsc_reserve_slot(q);
+            if (slot)
+            {
+                slot->id = next++;
+                slot->priority = 1;
+                zvec_spsc_commit(q);
+            }
+        }
+        else
+        {
+            Task batch[16];
+            int n = SPSC_COUNT - next < 16 ? SPSC_COUNT - next : 16;
+            int k;
+            for (k = 0; k < n; ++k)
+            {
+                batch[k].id = next + k;
+                batch[k].priority = 1;
+            }
+            next += (int)zvec_spsc_push_n(q, batch, (size_t)n);
+        }
+    }
+    return NULL;
+}
+
+void test_spsc_ring(void)
+{
+    TEST("SPSC Ring (Batch, Zero-Copy)");
+
+    zvec_spsc_Task q;
+    pthread_t th;
+    int expect = 0;
+    assert(Z_OK == zvec_spsc_init(&q, 100));
+    assert(q.buf.capacity == 128);
+
+    pthread_create(&th, NULL, spsc_producer, &q);
+    while (expect < SPSC_COUNT)
+    {
+        Task out[8];
+        size_t n, k;
+        Task *front = zvec_spsc_front(&q);
+        if (front)
+        {
+            assert(front->id == expect++);
+            zvec_spsc_release(&q);
+        }
+        n = zvec_spsc_pop_n(&q, out, 8);
+        for (k = 0; k < n; ++k)
+        {
+            assert(out[k].id == expect++);
+        }
+        if (zvec_spsc_pop(&q, &out[0]))
+        {
+            assert(out[0].id == expect++);
+        }
+    }
+    pthread_join(th, NULL);
+    assert(zvec_spsc_size(&q) == 0);
+
+    // Full ring rejects pushes.
+    Task t = {0, 0};
+    size_t i;
+    for (i = 0; i < 128; ++i)
+    {
+        assert(zvec_spsc_push(&q, t));
+    }
+    assert(!zvec_spsc_push(&q, t));
+    assert(zvec_spsc_reserve_slot(&q) == NULL);
+
+    zvec_spsc_free(&q);
+    PASS();
+}
+
+#define MPMC_PRODUCERS  4
+#define MPMC_CONSUMERS  4
+#define MPMC_PER_THREAD 50000
+
+static zvec_mpmc_Task g_mpmc;
+
+static void *mpmc_producer(void *arg)
+{
+    int id = (int)(size_t)arg;
+    int i = 0;
+    while (i < MPMC_PER_THREAD)
+    {
+        if (i % 3 == 0 && i + 4 <= MPMC_PER_THREAD)
+        {
+            // Batch try-push; finish whatever did not fit with blocking pushes.
+            Task batch[4];
+            size_t k, sent;
+            for (k = 0; k < 4; ++k)
+            {
+                batch[k] = (Task){id, i + (int)k};
+            }
+            sent = zvec_mpmc_try_push_n(&g_mpmc, batch, 4);
+            for (k = sent; k < 4; ++k)
+            {
+                assert(zvec_mpmc_push(&g_mpmc, batch[k]));
+            }
+            i += 4;
+        }
+        else
+        {
+            assert(zvec_mpmc_push(&g_mpmc, ((Task){id, i})));
+            i++;
+        }
+    }
+    return NULL;
+}
+
+static void *mpmc_consumer(void *arg)
+{
+    char *seen = (char *)arg;
+    int last[MPMC_PRODUCERS];
+    Task out[8];
+    size_t n, k;
+    for (k = 0; k < MPMC_PRODUCERS; ++k)
+    {
+        last[k] = -1;
+    }
+    while ((n = zvec_mpmc_pop_n(&g_mpmc, out, 8)) > 0)
+    {
+        for (k = 0; k < n; ++k)
+        {
+            // One consumer sees each producer's items in FIFO order.
+            assert(out[k].priority > last[out[k].id]);
+            last[out[k].id] = out[k].priority;
+            assert(!seen[out[k].id * MPMC_PER_THREAD + out[k].priority]);
+            seen[out[k].id * MPMC_PER_THREAD + out[k].priority] = 1;
+        }
+    }
+    return NULL;
+}
+
+void test_mpmc_queue(void)
+{
+    TEST("MPMC Queue (Bounded)");
+
+    pthread_t prod[MPMC_PRODUCERS], cons[MPMC_CONSUMERS];
+    char *seen = calloc(MPMC_PRODUCERS * MPMC_PER_THREAD, 1);
+    size_t i;
+    Task t;
+
+    // Non-blocking edges on a tiny queue.
+    assert(Z_OK == zvec_mpmc_init(&g_mpmc, 3));
+    assert(g_mpmc.mask == 3);
+    assert(!zvec_mpmc_try_pop(&g_mpmc, &t));
+    for (i = 0; i < 4; ++i)
+    {
+        assert(zvec_mpmc_try_push(&g_mpmc, ((Task){0, (int)i})));
+    }
+    assert(!zvec_mpmc_try_push(&g_mpmc, ((Task){0, 99})));
+    assert(zvec_mpmc_size(&g_mpmc) == 4);
+    assert(zvec_mpmc_try_pop(&g_mpmc, &t) && t.priority == 0);
+    assert(zvec_mpmc_try_push(&g_mpmc, ((Task){0, 4})));
+    Task drain[8];
+    assert(zvec_mpmc_try_pop_n(&g_mpmc, drain, 8) == 4);
+    assert(drain[0].priority == 1 && drain[3].priority == 4);
+    zvec_mpmc_close(&g_mpmc);
+    assert(!zvec_mpmc_push(&g_mpmc, t));
+    assert(!zvec_mpmc_pop(&g_mpmc, &t));
+    zvec_mpmc_free(&g_mpmc);
+
+    // Contended run; the small capacity forces both sides to block.
+    assert(Z_OK == zvec_mpmc_init(&g_mpmc, 64));
+    for (i = 0; i < MPMC_CONSUMERS; ++i)
+    {
+        pthread_create(&cons[i], NULL, mpmc_consumer, seen);
+    }
+    for (i = 0; i < MPMC_PRODUCERS; ++i)
+    {
+        pthread_create(&prod[i], NULL, mpmc_producer, (void *)i);
+    }
+    for (i = 0; i < MPMC_PRODUCERS; ++i)
+    {
+        pthread_join(prod[i], NULL);
+    }
+    zvec_mpmc_close(&g_mpmc);
+    for (i = 0; i < MPMC_CONSUMERS; ++i)
+    {
+        pthread_join(cons[i], NULL);
+    }
+
+    for (i = 0; i < MPMC_PRODUCERS * MPMC_PER_THREAD; ++i)
+    {
+        assert(seen[i]);
+    }
+    assert(zvec_mpmc_size(&g_mpmc) == 0);
+
+    free(seen);
+    zvec_mpmc_free(&g_mpmc);
+    PASS();
+}
+
+#define DEQUE_THIEVES 3
+#define DEQUE_COUNT   200000
+
+static zvec_deque_Int g_deque;
+static int g_deque_done;
+
+static void *deque_thief(void *arg)
+{
+    char *seen = (char *)arg;
+    int v;
+    while (!__atomic_load_n(&g_deque_done, __ATOMIC_ACQUIRE) || zvec_deque_size(&g_deque))
+    {
+        if (zvec_deque_steal(&g_deque, &v))
+        {
+            assert(!seen[v]);
+            seen[v] = 1;
+        }
+    }
+    return NULL;
+}
+
+void test_work_stealing_deque(void)
+{
+    TEST("Work-Stealing Deque (Chase-Lev)");
+
+    pthread_t th[DEQUE_THIEVES];
+    char *seen = calloc(DEQUE_COUNT, 1);
+    size_t i;
+    int v;
+
+    // Owner pops LIFO, thieves steal FIFO; growth keeps the order.
+    assert(Z_OK == zvec_deque_init(&g_deque, 2));
+    for (i = 0; i < 10; ++i)
+    {
+        assert(Z_OK == zvec_deque_push(&g_deque, (int)i));
+    }
+    assert(zvec_deque_size(&g_deque) == 10);
+    assert(zvec_deque_steal(&g_deque, &v) && v == 0);
+    assert(zvec_deque_pop(&g_deque, &v) && v == 9);
+    while (zvec_deque_pop(&g_deque, &v))
+    {
+    }
+    assert(v == 1 && zvec_deque_size(&g_deque) == 0);
+    assert(!zvec_deque_steal(&g_deque, &v));
+    zvec_deque_free(&g_deque);
+
+    // Small initial ring so growth races with the thieves.
+    assert(Z_OK == zvec_deque_init(&g_deque, 4));
+    for (i = 0; i < DEQUE_THIEVES; ++i)
+    {
+        pthread_create(&th[i], NULL, deque_thief, seen);
+    }
+    for (i = 0; i < DEQUE_COUNT; ++i)
+    {
+        assert(Z_OK == zvec_deque_push(&g_deque, (int)i));
+        if (i % 3 == 0 && zvec_deque_pop(&g_deque, &v))
+        {
+            assert(!seen[v]);
+            seen[v] = 1;
+        }
+    }
+    while (zvec_deque_pop(&g_deque, &v))
+    {
+        assert(!seen[v]);
+        seen[v] = 1;
+    }
+    __atomic_store_n(&g_deque_done, 1, __ATOMIC_RELEASE);
+    for (i = 0; i < DEQUE_THIEVES; ++i)
+    {
+        pthread_join(th[i], NULL);
+    }
+
+    for (i = 0; i < DEQUE_COUNT; ++i)
+    {
+        assert(seen[i]);
+    }
+
+    free(seen);
+    zvec_deque_free(&g_deque);
+    PASS();
+}
+
+#define PAR_COUNT 100003
+
+static void par_double(int *x, void *ctx)
+{
+    (void)ctx;
+    *x *= 2;
+}
+
+static void par_nested(int *x, void *ctx)
+{
+    // Nested calls run inline on the current thread.
+    zvec_Int *inner = (zvec_Int *)ctx;
+    if (*x == 0)
+    {
+        zvec_par_foreach(inner, par_double, NULL);
+    }
+}
+
+static void par_square(Task *out, const Task *in)
+{
+    out->id = in->id;
+    out->priority = in->priority * in->priority;
+}
+
+static int par_mod7(const int *x)
+{
+    return *x % 7;
+}
+
+static int par_add(int a, int b)
+{
+    return a + b;
+}
+
+static Task par_task_map(const Task *t)
+{
+    return *t;
+}
+
+// Associative but not commutative: keeps the first id and the last priority.
+static Task par_first_last(Task a, Task b)
+{
+    Task r = {a.id, b.priority};
+    return r;
+}
+
+void test_parallel_algorithms(void)
+{
+    TEST("Parallel foreach/transform/reduce");
+
+    zvec_Int v = zvec_init(Int);
+    zvec_Int inner = zvec_init(Int);
+    zvec_Task tasks = zvec_init(Task);
+    zvec_Task squared = zvec_init(Task);
+    size_t i;
+    long expect = 0;
+
+    for (i = 0; i < PAR_COUNT; ++i)
+    {
+        zvec_push(&v, (int)i);
+        zvec_push(&tasks, ((Task){(int)i, (int)(i % 1000)}));
+    }
+
+    zvec_par_foreach(&v, par_double, NULL);
+    for (i = 0; i < PAR_COUNT; ++i)
+    {
+        assert(v.data[i] == (int)(2 * i));
+        expect += (long)((2 * i) % 7);
+    }
+    assert(zvec_par_reduce(&v, 0, par_mod7, par_add) == expect);
+
+    assert(Z_OK == zvec_par_transform(&squared, &tasks, par_square));
+    assert(squared.length == PAR_COUNT);
+    for (i = 0; i < PAR_COUNT; ++i)
+    {
+        assert(squared.data[i].id == (int)i);
+        assert(squared.data[i].priority == (int)((i % 1000) * (i % 1000)));
+    }
+
+    Task first = {-1, -1};
+    Task r = zvec_par_reduce(&tasks, first, par_task_map, par_first_last);
+    assert(r.id == -1 && r.priority == (int)((PAR_COUNT - 1) % 1000));
+
+    // A view that starts mid cache line still gets every element exactly once.
+    zvec_Int view = {v.data + 3, 5000, 5000};
+    zvec_par_foreach(&view, par_double, NULL);
+    assert(v.data[2] == 4 && v.data[3] == 12);
+    assert(v.data[5002] == 5002 * 4 && v.data[5003] == 5003 * 2);
+    zvec_Int empty = zvec_init(Int);
+    assert(zvec_par_reduce(&empty, 7, par_mod7, par_add) == 7);
+
+    for (i = 0; i < 3000; ++i)
+    {
+        zvec_push(&inner, 1);
+    }
+    zvec_par_foreach(&v, par_nested, &inner);
+    zvec_foreach(&inner, it)
+    {
+        assert(*it == 2);
+    }
+
+    zvec_free(&v);
+    zvec_free(&inner);
+    zvec_free(&tasks);
+    zvec_free(&squared);
+    PASS();
+}
+
+#define RCU_READERS 4
+#define RCU_APPENDS 20000
+
+static zvec_rcu_Int g_rcu;
+static int g_rcu_done;
+
+static void *rcu_reader(void *arg)
+{
+    int slot = zvec_rcu_register(&g_rcu);
+    size_t last_len = 0;
+    (void)arg;
+    assert(slot >= 0);
+    while (!__atomic_load_n(&g_rcu_done, __ATOMIC_ACQUIRE))
+    {
+        zvec_rcu_snap_Int s = zvec_rcu_read_lock(&g_rcu, slot);
+        size_t i;
+        // Every published version holds consecutive values.
+        for (i = 1; i < s.length; ++i)
+        {
+            assert(s.data[i] == s.data[0] + (int)i);
+        }
+        assert(s.length >= last_len);
+        last_len = s.length;
+        zvec_rcu_read_unlock(&g_rcu, slot);
+    }
+    zvec_rcu_unregister(&g_rcu, slot);
+    return NULL;
+}
+
+void test_rcu_vector(void)
+{
+    TEST("RCU Snapshot Vector");
+
+    pthread_t th[RCU_READERS];
+    size_t i;
+    int next = 0;
+
+    assert(Z_OK == zvec_rcu_init(&g_rcu));
+    for (i = 0; i < RCU_READERS; ++i)
+    {
+        pthread_create(&th[i], NULL, rcu_reader, NULL);
+    }
+    for (i = 0; i < RCU_APPENDS; ++i)
+    {
+        if (i % 2 == 0)
+        {
+            assert(Z_OK == zvec_rcu_push(&g_rcu, next++));
+        }
+        else
+        {
+            int pair[2] = {next, next + 1};
+            assert(Z_OK == zvec_rcu_extend(&g_rcu, pair, 2));
+            next += 2;
+        }
+        if (i % 1000 == 999)
+        {
+            // Copy-on-write edit: shift every value, then publish atomically.
+            zvec_Int *draft = zvec_rcu_edit(&g_rcu);
+            assert(draft);
+            zvec_foreach(draft, it)
+            {
+                *it += 1;
+            }
+            assert(Z_OK == zvec_rcu_push(&g_rcu, next + 1));
+            assert(Z_OK == zvec_rcu_publish(&g_rcu));
+            next += 2;
+        }
+    }
+    __atomic_store_n(&g_rcu_done, 1, __ATOMIC_RELEASE);
+    for (i = 0; i < RCU_READERS; ++i)
+    {
+        pthread_join(th[i], NULL);
+    }
+
+    // Discarded drafts never become visible.
+    zvec_Int *draft = zvec_rcu_edit(&g_rcu);
+    draft->data[0] = -100;
+    zvec_rcu_discard(&g_rcu);
+    zvec_rcu_synchronize(&g_rcu);
+    assert(g_rcu.epoch.retired_len == 0);
+
+    int slot = zvec_rcu_register(&g_rcu);
+    zvec_rcu_snap_Int s = zvec_rcu_read_lock(&g_rcu, slot);
+    assert(s.length == (size_t)(RCU_APPENDS / 2 * 3) + RCU_APPENDS / 1000);
+    assert(s.data[0] == RCU_APPENDS / 1000 && s.data[s.length - 1] == next - 1);
+    zvec_rcu_read_unlock(&g_rcu, slot);
+    zvec_rcu_unregister(&g_rcu, slot);
+
+    zvec_rcu_free(&g_rcu);
+    PASS();
+}
+
+#define LOCAL_THREADS 6
+#define LOCAL_PER     30000
+
+static void *local_producer(void *arg)
+{
+    int id = (int)(size_t)arg;
+    zvec_Task *mine = zvec_local(Task);
+    int i;
+    assert(mine);
+    for (i = 0; i < LOCAL_PER; ++i)
+    {
+        zvec_push(mine, ((Task){id, i}));
+    }
+    return NULL;
+}
+
+static void *local_single(void *arg)
+{
+    zvec_Int *mine = zvec_local(Int);
+    int i;
+    for (i = 0; i < 100; ++i)
+    {
+        zvec_push(mine, i);
+    }
+    *(int **)arg = mine->data;
+    return NULL;
+}
+
+void test_local_combine(void)
+{
+    TEST("Thread-Local Staging + Combine");
+
+    pthread_t th[LOCAL_THREADS];
+    zvec_Task all = zvec_init(Task);
+    size_t i, round, nodes = 0;
+    zvec_local_node_Task *n;
+
+    for (round = 0; round < 2; ++round)
+    {
+        for (i = 0; i < LOCAL_THREADS; ++i)
+        {
+            pthread_create(&th[i], NULL, local_producer, (void *)i);
+        }
+        for (i = 0; i < LOCAL_THREADS; ++i)
+        {
+            pthread_join(th[i], NULL);
+        }
+        assert(Z_OK == zvec_combine_into(&all));
+        assert(all.length == (round + 1) * LOCAL_THREADS * LOCAL_PER);
+    }
+
+    // Every (id, i) pair shows up once per round; each buffer stays in order.
+    char *seen = calloc(LOCAL_THREADS * LOCAL_PER, 1);
+    for (i = 0; i < all.length; ++i)
+    {
+        Task *t = &all.data[i];
+        assert(seen[t->id * LOCAL_PER + t->priority] == (char)(i >= all.length / 2));
+        seen[t->id * LOCAL_PER + t->priority]++;
+        assert(t->priority == 0 || all.data[i - 1].priority == t->priority - 1);
+    }
+    free(seen);
+
+    // Exited threads hand their buffers to the next round instead of leaking nodes.
+    for (n = zvec_local_head_Task; n; n = n->next)
+    {
+        assert(n->buf.length == 0);
+        nodes++;
+    }
+    assert(nodes <= LOCAL_THREADS);
+
+    // A single producer's buffer is adopted without copying.
+    zvec_Int adopted = zvec_init(Int);
+    int *staged = NULL;
+    pthread_t one;
+    pthread_create(&one, NULL, local_single, &staged);
+    pthread_join(one, NULL);
+    assert(Z_OK == zvec_combine_into(&adopted));
+    assert(adopted.data == staged && adopted.length == 100 && adopted.data[99] == 99);
+    assert(Z_OK == zvec_combine_into(&adopted));
+    assert(adopted.length == 100);
+
+    zvec_local_release(Task);
+    zvec_local_release(Int);
+    zvec_free(&adopted);
+    zvec_free(&all);
+    PASS();
+}
+
+#define SHARD_COUNT 4
+#define SHARD_PER   50000
+
+static zvec_shard_Int g_shard;
+
+static void *shard_owner(void *arg)
+{
+    size_t k = (size_t)arg;
+    int i;
+    for (i = 0; i < SHARD_PER; ++i)
+    {
+        assert(Z_OK == zvec_shard_push(&g_shard, k, (int)k * SHARD_PER + i));
+        if (i % 5 == 4)
+        {
+            // Shard-local O(1) removal, no locks.
+            zvec_Int *mine = zvec_shard_get(&g_shard, k);
+            zvec_shard_swap_remove(&g_shard, k, mine->length - 5);
+        }
+    }
+    return NULL;
+}
+
+static void shard_sum(size_t k, zvec_Int *v, void *ctx)
+{
+    long *sums = (long *)ctx;
+    zvec_foreach(v, it)
+    {
+        sums[k] += *it;
+    }
+}
+
+void test_sharded_vector(void)
+{
+    TEST("Sharded Vector (Per-Core)");
+
+    pthread_t th[SHARD_COUNT];
+    long sums[SHARD_COUNT] = {0};
+    size_t i, seen = 0, polls = 0;
+
+    assert(Z_OK == zvec_shard_init(&g_shard, SHARD_COUNT));
+    assert((uintptr_t)g_shard.shards % ZVEC_CACHE_LINE == 0);
+    assert(sizeof(g_shard.shards[0]) % ZVEC_CACHE_LINE == 0);
+    assert(zvec_shard_local(&g_shard) == zvec_shard_local(&g_shard));
+
+    for (i = 0; i < SHARD_COUNT; ++i)
+    {
+        pthread_create(&th[i], NULL, shard_owner, (void *)i);
+    }
+    // Global size is readable while the owners mutate.
+    while (polls++ < 1000)
+    {
+        assert(zvec_shard_size(&g_shard) <= SHARD_COUNT * SHARD_PER);
+    }
+    for (i = 0; i < SHARD_COUNT; ++i)
+    {
+        pthread_join(th[i], NULL);
+    }
+
+    assert(zvec_shard_size(&g_shard) == SHARD_COUNT * SHARD_PER / 5 * 4);
+    zvec_shard_visit(&g_shard, shard_sum, sums);
+    zvec_shard_foreach(&g_shard, it)
+    {
+        assert((*it / SHARD_PER) == (int)it_shard);
+        seen++;
+    }
+    assert(seen == zvec_shard_size(&g_shard));
+    for (i = 0; i < SHARD_COUNT; ++i)
+    {
+        long expect = 0;
+        zvec_foreach(zvec_shard_get(&g_shard, i), it)
+        {
+            expect += *it;
+        }
+        assert(sums[i] == expect);
+    }
+
+    zvec_Int all = zvec_init(Int);
+    assert(Z_OK == zvec_shard_gather(&g_shard, &all));
+    assert(all.length == seen);
+
+    zvec_free(&all);
+    zvec_shard_free(&g_shard);
+    PASS();
+}
+
+#define SEQ_READERS 3
+#define SEQ_COUNT   300000
+
+static zvec_seq_Int g_seq;
+static int g_seq_done;
+
+static void *seq_monitor(void *arg)
+{
+    size_t last = 0, rounds = 0;
+    (void)arg;
+    while (!__atomic_load_n(&g_seq_done, __ATOMIC_ACQUIRE))
+    {
+        zvec_seq_snap_Int s = zvec_seq_snapshot(&g_seq);
+        size_t i, from = s.length > 64 ? s.length - 64 : 0;
+        assert(s.length >= last);
+        assert(zvec_seq_length(&g_seq) >= s.length);
+        // Spot-check the tail every round and the whole prefix now and then.
+        for (i = (rounds++ % 64 == 0) ? 0 : from; i < s.length; ++i)
+        {
+            assert(s.data[i] == (int)i);
+        }
+        last = s.length;
+    }
+    return NULL;
+}
+
+void test_seqlock_vector(void)
+{
+    TEST("Seqlock Vector (Single Writer)");
+
+    pthread_t th[SEQ_READERS];
+    size_t i;
+
+    zvec_seq_init(&g_seq);
+    for (i = 0; i < SEQ_READERS; ++i)
+    {
+        pthread_create(&th[i], NULL, seq_monitor, NULL);
+    }
+    for (i = 0; i < SEQ_COUNT; ++i)
+    {
+        if (i % 3 == 0 && i + 2 < SEQ_COUNT)
+        {
+            int trio[3] = {(int)i, (int)i + 1, (int)i + 2};
+            assert(Z_OK == zvec_seq_extend(&g_seq, trio, 3));
+            i += 2;
+        }
+        else
+        {
+            assert(Z_OK == zvec_seq_push(&g_seq, (int)i));
+        }
+    }
+    __atomic_store_n(&g_seq_done, 1, __ATOMIC_RELEASE);
+    for (i = 0; i < SEQ_READERS; ++i)
+    {
+        pthread_join(th[i], NULL);
+    }
+
+    assert(zvec_seq_length(&g_seq) == SEQ_COUNT);
+    assert(g_seq.seq % 2 == 0 && g_seq.retired_len > 0);
+    zvec_seq_reclaim(&g_seq);
+    assert(g_seq.retired_len == 0);
+
+    zvec_seq_snap_Int s = zvec_seq_snapshot(&g_seq);
+    assert(s.length == SEQ_COUNT && s.data[SEQ_COUNT - 1] == SEQ_COUNT - 1);
+    zvec_seq_free(&g_seq);
+    PASS();
+}
+
+#define EBR_READERS 3
+#define EBR_COUNT   200000
+
+static zvec_Int g_ebr_vec;
+static zvec_epoch g_ebr;
+static int g_ebr_done;
+
+static void *ebr_scanner(void *arg)
+{
+    int slot = zvec_epoch_register(&g_ebr);
+    size_t last = 0;
+    (void)arg;
+    assert(slot >= 0);
+    while (!__atomic_load_n(&g_ebr_done, __ATOMIC_ACQUIRE))
+    {
+        zvec_epoch_enter(&g_ebr, slot);
+        zvec_Int view = zvec_load_epoch(&g_ebr_vec);
+        assert(view.length >= last);
+        zvec_foreach(&view, it)
+        {
+            assert(*it == (int)(it - view.data));
+        }
+        last = view.length;
+        zvec_epoch_exit(&g_ebr, slot);
+    }
+    zvec_epoch_unregister(&g_ebr, slot);
+    return NULL;
+}
+
+void test_epoch_growth(void)
+{
+    TEST("Epoch Growth Mode (Reserve)");
+
+    pthread_t th[EBR_READERS];
+    size_t i;
+
+    g_ebr_vec = zvec_init(Int);
+    zvec_epoch_init(&g_ebr);
+    for (i = 0; i < EBR_READERS; ++i)
+    {
+        pthread_create(&th[i], NULL, ebr_scanner, NULL);
+    }
+    for (i = 0; i < EBR_COUNT; ++i)
+    {
+        assert(Z_OK == zvec_push_epoch(&g_ebr_vec, (int)i, &g_ebr));
+    }
+    int tail[4] = {EBR_COUNT, EBR_COUNT + 1, EBR_COUNT + 2, EBR_COUNT + 3};
+    assert(Z_OK == zvec_extend_epoch(&g_ebr_vec, tail, 4, &g_ebr));
+    __atomic_store_n(&g_ebr_done, 1, __ATOMIC_RELEASE);
+    for (i = 0; i < EBR_READERS; ++i)
+    {
+        pthread_join(th[i], NULL);
+    }
+
+    // With every reader gone, one collect frees all retired buffers.
+    assert(zvec_epoch_collect(&g_ebr) == 0);
+    assert(Z_OK == zvec_reserve_epoch(&g_ebr_vec, 1 << 20, &g_ebr));
+    zvec_epoch_synchronize(&g_ebr);
+    assert(g_ebr_vec.capacity == 1 << 20 && g_ebr_vec.length == EBR_COUNT + 4);
+    assert(*zvec_at(&g_ebr_vec, EBR_COUNT + 3) == EBR_COUNT + 3);
+
+    zvec_epoch_free(&g_ebr);
+    zvec_free(&g_ebr_vec);
+    PASS();
+}
+
+int main(void)
+{
+    printf("=> Running tests (zvec.h, threads).\n");
+
+    test_conc_append();
+    test_spsc_ring();
+    test_mpmc_queue();
+    test_work_stealing_deque();
+    test_parallel_algorithms();
+    test_rcu_vector();
+    test_local_combine();
+    test_sharded_vector();
+    test_seqlock_vector();
+    test_epoch_growth();
+
+    printf("=> All tests passed successfully.\n");
+    return 0;
+}
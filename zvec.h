@@ -173,6 +173,7 @@
 #include <string.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <errno.h>
 
 #if defined(__has_include) && __has_include("zerror.h")
 #   include "zerror.h"
@@ -183,6 +184,32 @@
 #   define Z_HAS_ZERROR 0
 #endif
 
+// Concurrent containers are opt-in (C only; they need pthreads and GCC/Clang atomics).
+#if defined(ZVEC_ENABLE_THREADS) && !defined(__cplusplus)
+#   include <pthread.h>
+#   include <sched.h>
+#   include <unistd.h>
+#   define ZVEC_HAS_THREADS 1
+#else
+#   define ZVEC_HAS_THREADS 0
+#endif
+
+// File and memory-mapped I/O is opt-in (C only; needs POSIX, e.g. _GNU_SOURCE).
+#if defined(ZVEC_ENABLE_IO) && !defined(__cplusplus)
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <limits.h>
+#   include <stdio.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <sys/uio.h>
+#   include <time.h>
+#   include <unistd.h>
+#   define ZVEC_HAS_IO 1
+#else
+#   define ZVEC_HAS_IO 0
+#endif
+
 // C++ interop preamble.
 #ifdef __cplusplus
 #include <initializer_list>
@@ -191,6 +218,7 @@
 #include <iterator>
 #include <algorithm>
 #include <new>
+#include <type_traits>
 
 namespace z_vec
 {
@@ -691,6 +719,13 @@ extern "C" {
             zvec_sort_##Name(v, cmp);                                                       \
         }                                                                                   \
                                                                                             \
+        static inline int zvec_stable_sort_dispatch(zvec_##Name *v,                         \
+                                                    int (*cmp)(const T*, const T*),         \
+                                                    zvec_##Name *scratch)                   \
+        {                                                                                   \
+            return zvec_stable_sort_##Name(v, cmp, scratch);                                \
+        }                                                                                   \
+                                                                                            \
         static inline T* zvec_bsearch_dispatch(zvec_##Name *v, const T* k,                  \
                                                int (*cmp)(const T*, const T*))              \
         {                                                                                   \
@@ -701,6 +736,40 @@ extern "C" {
                                                    int (*cmp)(const T*, const T*))          \
         {                                                                                   \
             return zvec_lower_bound_##Name(v, k, cmp);                                      \
+        }                                                                                   \
+                                                                                            \
+        static inline int zvec_merge_dispatch(zvec_##Name *d, const zvec_##Name *a,         \
+                                              const zvec_##Name *b,                         \
+                                              int (*cmp)(const T*, const T*))               \
+        {                                                                                   \
+            return zvec_merge_##Name(d, a, b, cmp);                                         \
+        }                                                                                   \
+                                                                                            \
+        static inline int zvec_union_dispatch(zvec_##Name *d, const zvec_##Name *a,         \
+                                              const zvec_##Name *b,                         \
+                                              int (*cmp)(const T*, const T*))               \
+        {                                                                                   \
+            return zvec_union_##Name(d, a, b, cmp);                                         \
+        }                                                                                   \
+                                                                                            \
+        static inline int zvec_intersect_dispatch(zvec_##Name *d, const zvec_##Name *a,     \
+                                                  const zvec_##Name *b,                     \
+                                                  int (*cmp)(const T*, const T*))           \
+        {                                                                                   \
+            return zvec_intersect_##Name(d, a, b, cmp);                                     \
+        }                                                                                   \
+                                                                                            \
+        static inline int zvec_difference_dispatch(zvec_##Name *d, const zvec_##Name *a,    \
+                                                   const zvec_##Name *b,                    \
+                                                   int (*cmp)(const T*, const T*))          \
+        {                                                                                   \
+            return zvec_difference_##Name(d, a, b, cmp);                                    \
+        }                                                                                   \
+                                                                                            \
+        static inline size_t zvec_unique_dispatch(zvec_##Name *v,                           \
+                                                  int (*cmp)(const T*, const T*))           \
+        {                                                                                   \
+            return zvec_unique_##Name(v, cmp);                                              \
         }
 #else
     // C implementation: uses realloc / memmove / free.
@@ -760,378 +829,8266 @@ extern "C" {
 #endif
 
 /*
- * ZVEC_GENERATE_IMPL(T, Name)
- *
- * Primary generation macro.
- *
- * Use manually via:
- * #define REGISTER_ZVEC_TYPES(X)   \
- * X(int, Int)                      \
- * X(float, Float)                  \
- * X(MyType, MyType)
- * #include "zvec.h"
+ * Stable sort generation.
  *
- * This creates:
- * • struct zvec_Int / zvec_Float, etc.
- * • All functions: zvec_push_Int, zvec_reserve_Float, etc.
- * • Full _Generic dispatch.
- * • C++ traits specialization for z_vec::vector<T>
+ * zvec_stable_sort is an adaptive merge sort in the style of timsort: it detects
+ * natural runs (reversing strictly descending ones), extends short runs to a
+ * minimum length with binary insertion sort, and merges them while keeping the
+ * run stack balanced. Merges trim elements that are already in place and switch
+ * to galloping (exponential search) when one side keeps winning, so nearly
+ * sorted input costs close to a single linear pass.
  *
- * Fast path: returns int (Z_OK / Z_ENOMEM), asserts on logic errors.
- * Safe path (when zerror.h present): returns zres / zresult<T>.
+ * The merge buffer is taken from an optional caller-owned scratch vector of the
+ * same type, so repeated sorts do not allocate. Pass NULL to use a temporary one.
  */
-#define ZVEC_GENERATE_IMPL(T, Name)                                                         \
-                                                                                            \
-    typedef T zvec_T_##Name;                                                                \
+#ifndef ZVEC_MIN_MERGE
+#   define ZVEC_MIN_MERGE   64  // Inputs up to this size are insertion sorted.
+#endif
+
+#ifndef ZVEC_MIN_GALLOP
+#   define ZVEC_MIN_GALLOP  7   // Consecutive wins before a merge starts galloping.
+#endif
+
+#define ZVEC_MAX_RUNS       85  // Enough pending runs for any 64-bit length.
+
+typedef struct
+{
+    size_t base;
+    size_t len;
+} zvec_run_t;
+
+static inline size_t zvec_minrun_impl(size_t n)
+{
+    size_t r = 0;
+    while (n >= ZVEC_MIN_MERGE)
+    {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+#define ZVEC_GEN_STABLE_SORT_IMPL(T, Name)                                                  \
                                                                                             \
-    typedef struct                                                                          \
+    /* First index in base[0..n) whose element is not less than *key. */                    \
+    static inline size_t zvec_gallop_left_##Name(const T *key, const T *base, size_t n,     \
+                                                 int (*compar)(const T *, const T *))       \
     {                                                                                       \
-        T *data;                                                                            \
-        size_t length;                                                                      \
-        size_t capacity;                                                                    \
-    } zvec_##Name;                                                                          \
-                                                                                            \
-    /* Forward declaration for C++ allocators to see. */                                    \
-    static inline int zvec_reserve_##Name(zvec_##Name *v, size_t new_cap);                  \
-                                                                                            \
-    ZVEC_IMPL_ALLOC(T, Name)                                                                \
+        size_t lo = 0;                                                                      \
+        size_t hi = 1;                                                                      \
+        if (0 == n || compar(&base[0], key) >= 0)                                           \
+        {                                                                                   \
+            return 0;                                                                       \
+        }                                                                                   \
+        while (hi < n && compar(&base[hi], key) < 0)                                        \
+        {                                                                                   \
+            lo = hi;                                                                        \
+            hi = (hi << 1) + 1;                                                             \
+        }                                                                                   \
+        if (hi > n)                                                                         \
+        {                                                                                   \
+            hi = n;                                                                         \
+        }                                                                                   \
+        lo++;                                                                               \
+        while (lo < hi)                                                                     \
+        {                                                                                   \
+            size_t mid = lo + (hi - lo) / 2;                                                \
+            if (compar(&base[mid], key) < 0)                                                \
+            {                                                                               \
+                lo = mid + 1;                                                               \
+            }                                                                               \
+            else                                                                            \
+            {                                                                               \
+                hi = mid;                                                                   \
+            }                                                                               \
+        }                                                                                   \
+        return lo;                                                                          \
+    }                                                                                       \
                                                                                             \
-    static inline zvec_##Name zvec_init_capacity_##Name(size_t cap)                         \
+    /* First index in base[0..n) whose element is greater than *key. */                     \
+    static inline size_t zvec_gallop_right_##Name(const T *key, const T *base, size_t n,    \
+                                                  int (*compar)(const T *, const T *))      \
     {                                                                                       \
-        zvec_##Name v;                                                                      \
-        memset(&v, 0, sizeof(zvec_##Name));                                                 \
-        if (cap > 0)                                                                        \
+        size_t lo = 0;                                                                      \
+        size_t hi = 1;                                                                      \
+        if (0 == n || compar(&base[0], key) > 0)                                            \
         {                                                                                   \
-            zvec_reserve_##Name(&v, cap);                                                   \
+            return 0;                                                                       \
         }                                                                                   \
-        return v;                                                                           \
+        while (hi < n && compar(&base[hi], key) <= 0)                                       \
+        {                                                                                   \
+            lo = hi;                                                                        \
+            hi = (hi << 1) + 1;                                                             \
+        }                                                                                   \
+        if (hi > n)                                                                         \
+        {                                                                                   \
+            hi = n;                                                                         \
+        }                                                                                   \
+        lo++;                                                                               \
+        while (lo < hi)                                                                     \
+        {                                                                                   \
+            size_t mid = lo + (hi - lo) / 2;                                                \
+            if (compar(&base[mid], key) <= 0)                                               \
+            {                                                                               \
+                lo = mid + 1;                                                               \
+            }                                                                               \
+            else                                                                            \
+            {                                                                               \
+                hi = mid;                                                                   \
+            }                                                                               \
+        }                                                                                   \
+        return lo;                                                                          \
     }                                                                                       \
                                                                                             \
-    static inline zvec_##Name zvec_from_array_##Name(const T *arr, size_t count)            \
+    /* Binary insertion sort of a[lo..hi), where a[lo..start) is already sorted. */         \
+    static inline void zvec_insertion_sort_impl_##Name(T *a, size_t lo, size_t start,       \
+                                                       size_t hi,                           \
+                                                       int (*compar)(const T *, const T *)) \
     {                                                                                       \
-        zvec_##Name v = zvec_init_capacity_##Name(count);                                   \
-        if (v.data)                                                                         \
+        size_t i;                                                                           \
+        for (i = start; i < hi; ++i)                                                        \
         {                                                                                   \
-            size_t i;                                                                       \
-            for(i = 0; i<count; ++i)                                                        \
+            T pivot = a[i];                                                                 \
+            size_t pos = lo + zvec_gallop_right_##Name(&pivot, &a[lo], i - lo, compar);     \
+            size_t j;                                                                       \
+            for (j = i; j > pos; --j)                                                       \
             {                                                                               \
-                v.data[i] = arr[i];                                                         \
+                a[j] = a[j - 1];                                                            \
             }                                                                               \
-            v.length = count;                                                               \
+            a[pos] = pivot;                                                                 \
         }                                                                                   \
-        return v;                                                                           \
     }                                                                                       \
                                                                                             \
-    static inline int zvec_is_empty_##Name(zvec_##Name *v)                                  \
+    /* Length of the natural run at a[lo..hi); strictly descending runs are reversed. */    \
+    static inline size_t zvec_count_run_impl_##Name(T *a, size_t lo, size_t hi,             \
+                                                    int (*compar)(const T *, const T *))    \
     {                                                                                       \
-        return 0 == v->length;                                                              \
+        size_t i = lo + 1;                                                                  \
+        if (i >= hi)                                                                        \
+        {                                                                                   \
+            return hi - lo;                                                                 \
+        }                                                                                   \
+        if (compar(&a[i], &a[lo]) < 0)                                                      \
+        {                                                                                   \
+            while (i + 1 < hi && compar(&a[i + 1], &a[i]) < 0)                              \
+            {                                                                               \
+                i++;                                                                        \
+            }                                                                               \
+            size_t l = lo;                                                                  \
+            size_t r = i;                                                                   \
+            while (l < r)                                                                   \
+            {                                                                               \
+                T temp = a[l];                                                              \
+                a[l] = a[r];                                                                \
+                a[r] = temp;                                                                \
+                l++;                                                                        \
+                r--;                                                                        \
+            }                                                                               \
+        }                                                                                   \
+        else                                                                                \
+        {                                                                                   \
+            while (i + 1 < hi && compar(&a[i + 1], &a[i]) >= 0)                             \
+            {                                                                               \
+                i++;                                                                        \
+            }                                                                               \
+        }                                                                                   \
+        return i - lo + 1;                                                                  \
     }                                                                                       \
                                                                                             \
-    static inline T *zvec_push_slot_##Name(zvec_##Name *v)                                  \
+    /* Merges the adjacent sorted runs a[b1..b1+n1) and a[b1+n1..b1+n1+n2) via tmp. */      \
+    static inline void zvec_merge_runs_impl_##Name(T *a, size_t b1, size_t n1, size_t n2,   \
+                                                   T *tmp,                                  \
+                                                   int (*compar)(const T *, const T *))     \
     {                                                                                       \
-        if (v->length >= v->capacity)                                                       \
+        size_t b2 = b1 + n1;                                                                \
+        size_t k = zvec_gallop_right_##Name(&a[b2], &a[b1], n1, compar);                    \
+        b1 += k;                                                                            \
+        n1 -= k;                                                                            \
+        if (0 == n1)                                                                        \
         {                                                                                   \
-            size_t new_cap = Z_GROWTH_FACTOR(v->capacity);                                  \
-            if (Z_OK != zvec_reserve_##Name(v, new_cap))                                    \
+            return;                                                                         \
+        }                                                                                   \
+        n2 = zvec_gallop_left_##Name(&a[b2 - 1], &a[b2], n2, compar);                       \
+        if (0 == n2)                                                                        \
+        {                                                                                   \
+            return;                                                                         \
+        }                                                                                   \
+        if (n1 <= n2)                                                                       \
+        {                                                                                   \
+            size_t i = 0, j = b2, d = b1, end = b2 + n2;                                    \
+            unsigned wins_a = 0, wins_b = 0;                                                \
+            for (k = 0; k < n1; ++k)                                                        \
             {                                                                               \
-                return NULL;                                                                \
+                tmp[k] = a[b1 + k];                                                         \
+            }                                                                               \
+            while (i < n1 && j < end)                                                       \
+            {                                                                               \
+                if (compar(&a[j], &tmp[i]) < 0)                                             \
+                {                                                                           \
+                    a[d++] = a[j++];                                                        \
+                    wins_a = 0;                                                             \
+                    if (++wins_b >= ZVEC_MIN_GALLOP)                                        \
+                    {                                                                       \
+                        size_t c = zvec_gallop_left_##Name(&tmp[i], &a[j], end - j,         \
+                                                           compar);                         \
+                        for (k = 0; k < c; ++k)                                             \
+                        {                                                                   \
+                            a[d++] = a[j++];                                                \
+                        }                                                                   \
+                        wins_b = 0;                                                         \
+                    }                                                                       \
+                }                                                                           \
+                else                                                                        \
+                {                                                                           \
+                    a[d++] = tmp[i++];                                                      \
+                    wins_b = 0;                                                             \
+                    if (++wins_a >= ZVEC_MIN_GALLOP && j < end)                             \
+                    {                                                                       \
+                        size_t c = zvec_gallop_right_##Name(&a[j], &tmp[i], n1 - i,         \
+                                                            compar);                        \
+                        for (k = 0; k < c; ++k)                                             \
+                        {                                                                   \
+                            a[d++] = tmp[i++];                                              \
+                        }                                                                   \
+                        wins_a = 0;                                                         \
+                    }                                                                       \
+                }                                                                           \
+            }                                                                               \
+            while (i < n1)                                                                  \
+            {                                                                               \
+                a[d++] = tmp[i++];                                                          \
+            }                                                                               \
+        }                                                                                   \
+        else                                                                                \
+        {                                                                                   \
+            size_t i = b2, j = n2, d = b2 + n2;                                             \
+            unsigned wins_a = 0, wins_b = 0;                                                \
+            for (k = 0; k < n2; ++k)                                                        \
+            {                                                                               \
+                tmp[k] = a[b2 + k];                                                         \
+            }                                                                               \
+            while (i > b1 && j > 0)                                                         \
+            {                                                                               \
+                if (compar(&tmp[j - 1], &a[i - 1]) < 0)                                     \
+                {                                                                           \
+                    a[--d] = a[--i];                                                        \
+                    wins_b = 0;                                                             \
+                    if (++wins_a >= ZVEC_MIN_GALLOP)                                        \
+                    {                                                                       \
+                        size_t c = (i - b1) - zvec_gallop_right_##Name(&tmp[j - 1], &a[b1], \
+                                                                       i - b1, compar);     \
+                        for (k = 0; k < c; ++k)                                             \
+                        {                                                                   \
+                            a[--d] = a[--i];                                                \
+                        }                                                                   \
+                        wins_a = 0;                                                         \
+                    }                                                                       \
+                }                                                                           \
+                else                                                                        \
+                {                                                                           \
+                    a[--d] = tmp[--j];                                                      \
+                    wins_a = 0;                                                             \
+                    if (++wins_b >= ZVEC_MIN_GALLOP && i > b1)                              \
+                    {                                                                       \
+                        size_t c = j - zvec_gallop_left_##Name(&a[i - 1], tmp, j, compar);  \
+                        for (k = 0; k < c; ++k)                                             \
+                        {                                                                   \
+                            a[--d] = tmp[--j];                                              \
+                        }                                                                   \
+                        wins_b = 0;                                                         \
+                    }                                                                       \
+                }                                                                           \
+            }                                                                               \
+            while (j > 0)                                                                   \
+            {                                                                               \
+                a[--d] = tmp[--j];                                                          \
             }                                                                               \
         }                                                                                   \
-        return &v->data[v->length++];                                                       \
     }                                                                                       \
                                                                                             \
-    static inline int zvec_push_##Name(zvec_##Name *v, T value)                             \
+    static inline int zvec_stable_sort_##Name(zvec_##Name *v,                               \
+                                              int (*compar)(const T *, const T *),          \
+                                              zvec_##Name *scratch)                         \
     {                                                                                       \
-        T *slot = zvec_push_slot_##Name(v);                                                 \
-        if (!slot)                                                                          \
+        zvec_run_t runs[ZVEC_MAX_RUNS];                                                     \
+        size_t nruns = 0;                                                                   \
+        size_t n = v->length;                                                               \
+        size_t lo = 0;                                                                      \
+        size_t minrun;                                                                      \
+        zvec_##Name local;                                                                  \
+        zvec_##Name *buf = scratch ? scratch : &local;                                      \
+        T *a = v->data;                                                                     \
+        assert(scratch != v && "scratch must not alias v");                                 \
+        if (n < 2)                                                                          \
+        {                                                                                   \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+        if (n <= ZVEC_MIN_MERGE)                                                            \
+        {                                                                                   \
+            size_t run = zvec_count_run_impl_##Name(a, 0, n, compar);                       \
+            zvec_insertion_sort_impl_##Name(a, 0, run, n, compar);                          \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+        memset(&local, 0, sizeof(local));                                                   \
+        if (Z_OK != zvec_reserve_##Name(buf, n / 2 + 1))                                    \
         {                                                                                   \
             return Z_ENOMEM;                                                                \
         }                                                                                   \
-        *slot = value;                                                                      \
+        minrun = zvec_minrun_impl(n);                                                       \
+        while (lo < n)                                                                      \
+        {                                                                                   \
+            size_t run = zvec_count_run_impl_##Name(a, lo, n, compar);                      \
+            if (run < minrun)                                                               \
+            {                                                                               \
+                size_t forced = (n - lo < minrun) ? n - lo : minrun;                        \
+                zvec_insertion_sort_impl_##Name(a, lo, lo + run, lo + forced, compar);      \
+                run = forced;                                                               \
+            }                                                                               \
+            runs[nruns].base = lo;                                                          \
+            runs[nruns].len = run;                                                          \
+            nruns++;                                                                        \
+            lo += run;                                                                      \
+            while (nruns > 1)                                                               \
+            {                                                                               \
+                size_t k = nruns - 2;                                                       \
+                if ((k > 0 && runs[k - 1].len <= runs[k].len + runs[k + 1].len) ||          \
+                    (k > 1 && runs[k - 2].len <= runs[k - 1].len + runs[k].len))            \
+                {                                                                           \
+                    if (runs[k - 1].len < runs[k + 1].len)                                  \
+                    {                                                                       \
+                        k--;                                                                \
+                    }                                                                       \
+                }                                                                           \
+                else if (runs[k].len > runs[k + 1].len)                                     \
+                {                                                                           \
+                    break;                                                                  \
+                }                                                                           \
+                zvec_merge_runs_impl_##Name(a, runs[k].base, runs[k].len, runs[k + 1].len,  \
+                                            buf->data, compar);                             \
+                runs[k].len += runs[k + 1].len;                                             \
+                if (k + 2 < nruns)                                                          \
+                {                                                                           \
+                    runs[k + 1] = runs[k + 2];                                              \
+                }                                                                           \
+                nruns--;                                                                    \
+            }                                                                               \
+        }                                                                                   \
+        while (nruns > 1)                                                                   \
+        {                                                                                   \
+            size_t k = nruns - 2;                                                           \
+            if (k > 0 && runs[k - 1].len < runs[k + 1].len)                                 \
+            {                                                                               \
+                k--;                                                                        \
+            }                                                                               \
+            zvec_merge_runs_impl_##Name(a, runs[k].base, runs[k].len, runs[k + 1].len,      \
+                                        buf->data, compar);                                 \
+            runs[k].len += runs[k + 1].len;                                                 \
+            if (k + 2 < nruns)                                                              \
+            {                                                                               \
+                runs[k + 1] = runs[k + 2];                                                  \
+            }                                                                               \
+            nruns--;                                                                        \
+        }                                                                                   \
+        if (scratch)                                                                        \
+        {                                                                                   \
+            scratch->length = 0;                                                            \
+        }                                                                                   \
+        else                                                                                \
+        {                                                                                   \
+            zvec_free_##Name(&local);                                                       \
+        }                                                                                   \
         return Z_OK;                                                                        \
-    }                                                                                       \
+    }
+
+/*
+ * Sorted set algebra generation.
+ *
+ * Combines two vectors sorted by the same comparator into a third one:
+ * zvec_merge keeps every element, zvec_union / zvec_intersect / zvec_difference
+ * follow std::set_* semantics. The output may be the first input (in place), but
+ * never the second. Merge, union and difference gallop once one side wins
+ * ZVEC_MIN_GALLOP times in a row; intersection switches to exponential search
+ * from the smaller side when one input is ZVEC_GALLOP_RATIO times larger.
+ */
+#ifndef ZVEC_GALLOP_RATIO
+#   define ZVEC_GALLOP_RATIO 32
+#endif
+
+#define ZVEC_GEN_SET_OPS_IMPL(T, Name)                                                      \
                                                                                             \
-    static inline int zvec_extend_##Name(zvec_##Name *v, const T *items, size_t count)      \
+    /* Merges a and b into out; keep_dups = 0 collapses equal pairs (union). */             \
+    static inline size_t zvec_merge_impl_##Name(const T *a, size_t na, const T *b,          \
+                                                size_t nb, T *out,                          \
+                                                int (*compar)(const T *, const T *),        \
+                                                int keep_dups)                              \
     {                                                                                       \
-        if (v->length + count > v->capacity)                                                \
+        size_t i = 0, j = 0, w = 0, c, k;                                                   \
+        unsigned wins_a = 0, wins_b = 0;                                                    \
+        while (i < na && j < nb)                                                            \
         {                                                                                   \
-            size_t new_cap = v->capacity ? v->capacity : Z_GROWTH_FACTOR(0);                \
-            while (new_cap < v->length + count)                                             \
+            int r = compar(&a[i], &b[j]);                                                   \
+            if (r < 0 || (0 == r && keep_dups))                                             \
             {                                                                               \
-                new_cap = Z_GROWTH_FACTOR(new_cap);                                         \
+                out[w++] = a[i++];                                                          \
+                wins_b = 0;                                                                 \
+                if (++wins_a >= ZVEC_MIN_GALLOP)                                            \
+                {                                                                           \
+                    c = keep_dups ? zvec_gallop_right_##Name(&b[j], &a[i], na - i, compar)  \
+                                  : zvec_gallop_left_##Name(&b[j], &a[i], na - i, compar);  \
+                    for (k = 0; k < c; ++k)                                                 \
+                    {                                                                       \
+                        out[w++] = a[i++];                                                  \
+                    }                                                                       \
+                    wins_a = 0;                                                             \
+                }                                                                           \
             }                                                                               \
-            if (Z_OK != zvec_reserve_##Name(v, new_cap))                                    \
+            else if (r > 0)                                                                 \
             {                                                                               \
-                return Z_ENOMEM;                                                            \
+                out[w++] = b[j++];                                                          \
+                wins_a = 0;                                                                 \
+                if (++wins_b >= ZVEC_MIN_GALLOP && i < na)                                  \
+                {                                                                           \
+                    c = zvec_gallop_left_##Name(&a[i], &b[j], nb - j, compar);              \
+                    for (k = 0; k < c; ++k)                                                 \
+                    {                                                                       \
+                        out[w++] = b[j++];                                                  \
+                    }                                                                       \
+                    wins_b = 0;                                                             \
+                }                                                                           \
+            }                                                                               \
+            else                                                                            \
+            {                                                                               \
+                out[w++] = a[i++];                                                          \
+                j++;                                                                        \
+                wins_a = wins_b = 0;                                                        \
             }                                                                               \
         }                                                                                   \
-        size_t i;                                                                           \
-        for( i = 0; i<count; ++i)                                                           \
+        while (i < na)                                                                      \
         {                                                                                   \
-            v->data[v->length + i] = items[i];                                              \
+            out[w++] = a[i++];                                                              \
         }                                                                                   \
-        v->length += count;                                                                 \
-        return Z_OK;                                                                        \
-    }                                                                                       \
-                                                                                            \
-    static inline void zvec_pop_##Name(zvec_##Name *v)                                      \
-       {                                                                                    \
-        assert(v->length > 0 && "Popping empty vector");                                    \
-        v->length--;                                                                        \
+        while (j < nb)                                                                      \
+        {                                                                                   \
+            out[w++] = b[j++];                                                              \
+        }                                                                                   \
+        return w;                                                                           \
     }                                                                                       \
                                                                                             \
-    static inline T zvec_pop_get_##Name(zvec_##Name *v)                                     \
+    /* Intersection of a and b into out (elements are taken from a). */                     \
+    static inline size_t zvec_intersect_impl_##Name(const T *a, size_t na, const T *b,      \
+                                                    size_t nb, T *out,                      \
+                                                    int (*compar)(const T *, const T *))    \
     {                                                                                       \
-        assert(v->length > 0 && "Vector is empty");                                         \
-        return v->data[--v->length];                                                        \
+        size_t i = 0, j = 0, w = 0;                                                         \
+        if (na > nb * ZVEC_GALLOP_RATIO)                                                    \
+        {                                                                                   \
+            for (j = 0; j < nb && i < na; ++j)                                              \
+            {                                                                               \
+                i += zvec_gallop_left_##Name(&b[j], &a[i], na - i, compar);                 \
+                if (i < na && 0 == compar(&a[i], &b[j]))                                    \
+                {                                                                           \
+                    out[w++] = a[i++];                                                      \
+                }                                                                           \
+            }                                                                               \
+        }                                                                                   \
+        else if (nb > na * ZVEC_GALLOP_RATIO)                                               \
+        {                                                                                   \
+            for (i = 0; i < na && j < nb; ++i)                                              \
+            {                                                                               \
+                j += zvec_gallop_left_##Name(&a[i], &b[j], nb - j, compar);                 \
+                if (j < nb && 0 == compar(&a[i], &b[j]))                                    \
+                {                                                                           \
+                    out[w++] = a[i];                                                        \
+                    j++;                                                                    \
+                }                                                                           \
+            }                                                                               \
+        }                                                                                   \
+        else                                                                                \
+        {                                                                                   \
+            while (i < na && j < nb)                                                        \
+            {                                                                               \
+                int r = compar(&a[i], &b[j]);                                               \
+                if (r < 0)                                                                  \
+                {                                                                           \
+                    i++;                                                                    \
+                }                                                                           \
+                else if (r > 0)                                                             \
+                {                                                                           \
+                    j++;                                                                    \
+                }                                                                           \
+                else                                                                        \
+                {                                                                           \
+                    out[w++] = a[i++];                                                      \
+                    j++;                                                                    \
+                }                                                                           \
+            }                                                                               \
+        }                                                                                   \
+        return w;                                                                           \
     }                                                                                       \
                                                                                             \
-    static inline T *zvec_at_##Name(zvec_##Name *v, size_t index)                           \
+    /* Elements of a that are not in b, into out. */                                        \
+    static inline size_t zvec_difference_impl_##Name(const T *a, size_t na, const T *b,     \
+                                                     size_t nb, T *out,                     \
+                                                     int (*compar)(const T *, const T *))   \
     {                                                                                       \
-        return (index < v->length) ? &v->data[index] : NULL;                                \
+        size_t i = 0, j = 0, w = 0, c, k;                                                   \
+        unsigned wins_a = 0, wins_b = 0;                                                    \
+        while (i < na && j < nb)                                                            \
+        {                                                                                   \
+            int r = compar(&a[i], &b[j]);                                                   \
+            if (r < 0)                                                                      \
+            {                                                                               \
+                out[w++] = a[i++];                                                          \
+                wins_b = 0;                                                                 \
+                if (++wins_a >= ZVEC_MIN_GALLOP)                                            \
+                {                                                                           \
+                    c = zvec_gallop_left_##Name(&b[j], &a[i], na - i, compar);              \
+                    for (k = 0; k < c; ++k)                                                 \
+                    {                                                                       \
+                        out[w++] = a[i++];                                                  \
+                    }                                                                       \
+                    wins_a = 0;                                                             \
+                }                                                                           \
+            }                                                                               \
+            else if (r > 0)                                                                 \
+            {                                                                               \
+                j++;                                                                        \
+                wins_a = 0;                                                                 \
+                if (++wins_b >= ZVEC_MIN_GALLOP)                                            \
+                {                                                                           \
+                    j += zvec_gallop_left_##Name(&a[i], &b[j], nb - j, compar);             \
+                    wins_b = 0;                                                             \
+                }                                                                           \
+            }                                                                               \
+            else                                                                            \
+            {                                                                               \
+                i++;                                                                        \
+                j++;                                                                        \
+                wins_a = wins_b = 0;                                                        \
+            }                                                                               \
+        }                                                                                   \
+        while (i < na)                                                                      \
+        {                                                                                   \
+            out[w++] = a[i++];                                                              \
+        }                                                                                   \
+        return w;                                                                           \
     }                                                                                       \
                                                                                             \
-    static inline T *zvec_data_##Name(zvec_##Name *v)                                       \
+    static inline int zvec_combine_impl_##Name(zvec_##Name *dst, const zvec_##Name *a,      \
+                                               const zvec_##Name *b,                        \
+                                               int (*compar)(const T *, const T *),         \
+                                               int keep_dups)                               \
     {                                                                                       \
-        return v->data;                                                                     \
+        size_t na = a->length;                                                              \
+        size_t nb = b->length;                                                              \
+        const T *src;                                                                       \
+        assert(dst != b && "Output may only alias the first input");                        \
+        if (Z_OK != zvec_reserve_##Name(dst, na + nb))                                      \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        if (dst == a)                                                                       \
+        {                                                                                   \
+            /* Park a at the tail so the forward merge never overtakes its reads. */        \
+            size_t i;                                                                       \
+            for (i = na; i > 0; --i)                                                        \
+            {                                                                               \
+                dst->data[nb + i - 1] = dst->data[i - 1];                                   \
+            }                                                                               \
+            src = dst->data + nb;                                                           \
+        }                                                                                   \
+        else                                                                                \
+        {                                                                                   \
+            src = a->data;                                                                  \
+        }                                                                                   \
+        dst->length = zvec_merge_impl_##Name(src, na, b->data, nb, dst->data, compar,       \
+                                             keep_dups);                                    \
+        return Z_OK;                                                                        \
     }                                                                                       \
                                                                                             \
-    static inline T *zvec_last_##Name(zvec_##Name *v)                                       \
+    static inline int zvec_merge_##Name(zvec_##Name *dst, const zvec_##Name *a,             \
+                                        const zvec_##Name *b,                               \
+                                        int (*compar)(const T *, const T *))                \
     {                                                                                       \
-        return (v->length > 0) ? &v->data[v->length - 1] : NULL;                            \
+        return zvec_combine_impl_##Name(dst, a, b, compar, 1);                              \
     }                                                                                       \
                                                                                             \
-    static inline void zvec_swap_remove_##Name(zvec_##Name *v, size_t index)                \
+    static inline int zvec_union_##Name(zvec_##Name *dst, const zvec_##Name *a,             \
+                                        const zvec_##Name *b,                               \
+                                        int (*compar)(const T *, const T *))                \
     {                                                                                       \
-        if (index >= v->length) return;                                                     \
-        v->data[index] = v->data[--v->length];                                              \
+        return zvec_combine_impl_##Name(dst, a, b, compar, 0);                              \
     }                                                                                       \
                                                                                             \
-    static inline void zvec_clear_##Name(zvec_##Name *v)                                    \
+    static inline int zvec_intersect_##Name(zvec_##Name *dst, const zvec_##Name *a,         \
+                                            const zvec_##Name *b,                           \
+                                            int (*compar)(const T *, const T *))            \
     {                                                                                       \
-        v->length = 0;                                                                      \
+        assert(dst != b && "Output may only alias the first input");                        \
+        if (dst != a && Z_OK != zvec_reserve_##Name(dst, a->length < b->length ?            \
+                                                         a->length : b->length))            \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        dst->length = zvec_intersect_impl_##Name(a->data, a->length, b->data, b->length,    \
+                                                 dst->data, compar);                        \
+        return Z_OK;                                                                        \
     }                                                                                       \
                                                                                             \
-    static inline void zvec_reverse_##Name(zvec_##Name *v)                                  \
-    {                                                                                       \
-        if (v->length < 2)                                                                  \
-        {                                                                                   \
-            return;                                                                         \
-        }                                                                                   \
-        size_t i = 0;                                                                       \
-        size_t j = v->length - 1;                                                           \
-        while (i < j)                                                                       \
-        {                                                                                   \
-            T temp = v->data[i];                                                            \
-            v->data[i] = v->data[j];                                                        \
-            v->data[j] = temp;                                                              \
-            i++;                                                                            \
-            j--;                                                                            \
-        }                                                                                   \
-    }                                                                                       \
-                                                                                            \
-    static inline void zvec_sort_##Name(zvec_##Name *v,                                     \
-                                        int (*compar)(const T *, const T *))                \
+    static inline int zvec_difference_##Name(zvec_##Name *dst, const zvec_##Name *a,        \
+                                             const zvec_##Name *b,                          \
+                                             int (*compar)(const T *, const T *))           \
     {                                                                                       \
-        if (v->length > 1)                                                                  \
+        assert(dst != b && "Output may only alias the first input");                        \
+        if (dst != a && Z_OK != zvec_reserve_##Name(dst, a->length))                        \
         {                                                                                   \
-            qsort(v->data, v->length, sizeof(T),                                            \
-                (int(*)(const void *, const void *))compar);                                \
+            return Z_ENOMEM;                                                                \
         }                                                                                   \
+        dst->length = zvec_difference_impl_##Name(a->data, a->length, b->data, b->length,   \
+                                                  dst->data, compar);                       \
+        return Z_OK;                                                                        \
     }                                                                                       \
                                                                                             \
-    static inline T *zvec_bsearch_##Name(zvec_##Name *v, const T *key,                      \
-                                         int (*compar)(const T *, const T *))               \
+    static inline size_t zvec_unique_##Name(zvec_##Name *v,                                 \
+                                            int (*compar)(const T *, const T *))            \
     {                                                                                       \
-        if (0 == v->length)                                                                 \
+        size_t i, w = 1;                                                                    \
+        if (v->length < 2)                                                                  \
         {                                                                                   \
-            return NULL;                                                                    \
+            return v->length;                                                               \
         }                                                                                   \
-        return (T *)bsearch(key, v->data, v->length, sizeof(T),                             \
-                            (int(*)(const void *, const void *))compar);                    \
-    }                                                                                       \
-                                                                                            \
-    static inline T *zvec_lower_bound_##Name(zvec_##Name *v, const T *key,                  \
-                                             int (*compar)(const T *, const T *))           \
-    {                                                                                       \
-        size_t l = 0;                                                                       \
-        size_t r = v->length;                                                               \
-        while (l < r)                                                                       \
+        for (i = 1; i < v->length; ++i)                                                     \
         {                                                                                   \
-            size_t mid = l + (r - l) / 2;                                                   \
-            if (compar((const T *)&v->data[mid], key) < 0)                                  \
-            {                                                                               \
-                l = mid + 1;                                                                \
-            }                                                                               \
-            else                                                                            \
+            if (0 != compar(&v->data[w - 1], &v->data[i]))                                  \
             {                                                                               \
-                r = mid;                                                                    \
+                if (w != i)                                                                 \
+                {                                                                           \
+                    v->data[w] = v->data[i];                                                \
+                }                                                                           \
+                w++;                                                                        \
             }                                                                               \
         }                                                                                   \
-        return (l < v->length) ? &v->data[l] : NULL;                                        \
-    }                                                                                       \
-                                                                                            \
-    /* Inject safe API. */                                                                  \
-    ZVEC_GEN_SAFE_IMPL(T, Name)
+        v->length = w;                                                                      \
+        return w;                                                                           \
+    }
 
-// Dispatch table entries for _Generic.
-#define PUSH_ENTRY(T, Name)         zvec_##Name *: zvec_push_##Name,
-#define PUSH_SLOT_ENTRY(T, Name)    zvec_##Name *: zvec_push_slot_##Name,
-#define EXTEND_ENTRY(T, Name)       zvec_##Name *: zvec_extend_##Name,
-#define RESERVE_ENTRY(T, Name)      zvec_##Name *: zvec_reserve_##Name,
-#define IS_EMPTY_ENTRY(T, Name)     zvec_##Name *: zvec_is_empty_##Name,
-#define AT_ENTRY(T, Name)           zvec_##Name *: zvec_at_##Name,
-#define DATA_ENTRY(T, Name)         zvec_##Name *: zvec_data_##Name,
-#define LAST_ENTRY(T, Name)         zvec_##Name *: zvec_last_##Name,
-#define FREE_ENTRY(T, Name)         zvec_##Name *: zvec_free_##Name,
-#define POP_ENTRY(T, Name)          zvec_##Name *: zvec_pop_##Name,
-#define POP_GET_ENTRY(T, Name)      zvec_##Name *: zvec_pop_get_##Name,
-#define SHRINK_ENTRY(T, Name)       zvec_##Name *: zvec_shrink_to_fit_##Name,
-#define REMOVE_ENTRY(T, Name)       zvec_##Name *: zvec_remove_##Name,
-#define SWAP_REM_ENTRY(T, Name)     zvec_##Name *: zvec_swap_remove_##Name,
-#define CLEAR_ENTRY(T, Name)        zvec_##Name *: zvec_clear_##Name,
-#define REVERSE_ENTRY(T, Name)      zvec_##Name *: zvec_reverse_##Name,
-#define SORT_ENTRY(T, Name)         zvec_##Name *: zvec_sort_##Name,
-#define BSEARCH_ENTRY(T, Name)      zvec_##Name *: zvec_bsearch_##Name,
-#define LOWER_BOUND_ENTRY(T, Name)  zvec_##Name *: zvec_lower_bound_##Name,
+/*
+ * Concurrent containers (requires ZVEC_ENABLE_THREADS, C only).
+ *
+ * Like the safe API, these are disabled for C++: slots are raw memory rather than
+ * constructed objects. Atomics use the GCC/Clang __atomic builtins.
+ */
+#if ZVEC_HAS_THREADS
 
-#if Z_HAS_ZERROR
-#   define RESERVE_SAFE_ENTRY(T, Name) zvec_##Name *: zvec_reserve_safe_##Name,
-#   define PUSH_SAFE_ENTRY(T, Name)    zvec_##Name *: zvec_push_safe_##Name,
-#   define POP_SAFE_ENTRY(T, Name)     zvec_##Name *: zvec_pop_safe_##Name,
-#   define AT_SAFE_ENTRY(T, Name)      zvec_##Name *: zvec_at_safe_##Name,
-#   define LAST_SAFE_ENTRY(T, Name)    zvec_##Name *: zvec_last_safe_##Name,
+#if !defined(__GNUC__) && !defined(__clang__)
+#   error "ZVEC_ENABLE_THREADS requires GCC or Clang atomic builtins."
 #endif
 
-#ifndef REGISTER_ZVEC_TYPES
-#   if defined(__has_include) && __has_include("z_registry.h")
-#       include "z_registry.h"
-#   endif
-#endif
+#define ZVEC_ATOMIC_LOAD(p)          __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define ZVEC_ATOMIC_LOAD_RELAXED(p)  __atomic_load_n((p), __ATOMIC_RELAXED)
+#define ZVEC_ATOMIC_STORE(p, v)      __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define ZVEC_ATOMIC_FETCH_ADD(p, v)  __atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL)
+#define ZVEC_ATOMIC_CAS(p, e, d)                                                            \
+    __atomic_compare_exchange_n((p), (e), (d), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define ZVEC_ATOMIC_FENCE()          __atomic_thread_fence(__ATOMIC_SEQ_CST)
 
-#ifndef REGISTER_ZVEC_TYPES
-#   define REGISTER_ZVEC_TYPES(X)
+#ifndef ZVEC_CACHE_LINE
+#   define ZVEC_CACHE_LINE 64
 #endif
 
-#ifndef Z_AUTOGEN_VECS
-#   define Z_AUTOGEN_VECS(X)
+#if defined(__x86_64__) || defined(__i386__)
+#   define ZVEC_CPU_RELAX()  __builtin_ia32_pause()
+#else
+#   define ZVEC_CPU_RELAX()  ((void)0)
 #endif
 
-#define Z_ALL_VECS(X)       \
-    Z_AUTOGEN_VECS(X)       \
-    REGISTER_ZVEC_TYPES(X)
-
-Z_ALL_VECS(ZVEC_GENERATE_IMPL)
+// Busy-wait iterations before a blocking call falls back to sleeping.
+#ifndef ZVEC_SPIN_LIMIT
+#   define ZVEC_SPIN_LIMIT 64
+#endif
 
-// Public convenience macros.
+/*
+ * Parallel algorithms thread pool.
+ *
+ * One process-wide pool (per translation unit, like every other static in this
+ * header) is started on the first parallel call. A job is a range of n elements
+ * cut into chunks; each participant (the workers plus the calling thread) owns
+ * a contiguous run of chunk indices packed as (lo, hi) in one word. Owners take
+ * from lo and thieves take from hi, both with a CAS, so idle threads steal
+ * from busy ones. Calls made from inside a parallel body run serially.
+ */
+#ifndef ZVEC_PAR_THREADS
+#   define ZVEC_PAR_THREADS 0    // 0 = one worker per online CPU (minus the caller).
+#endif
 
-#define zvec_from(Name, ...)                                                                \
-    zvec_from_array_##Name((zvec_T_##Name[]){__VA_ARGS__},                                  \
-                           sizeof((zvec_T_##Name[]){__VA_ARGS__}) / sizeof(zvec_T_##Name))
+#ifndef ZVEC_PAR_GRAIN
+#   define ZVEC_PAR_GRAIN 1024   // Minimum elements per chunk.
+#endif
 
-#define zvec_init(Name)           zvec_init_capacity_##Name(0)
-#define zvec_init_with_cap(Name, cap) zvec_init_capacity_##Name(cap)
+#define ZVEC_PAR_CHUNKS_PER_THREAD 4
 
-#if Z_HAS_CLEANUP
-#   define zvec_autofree(Name)  Z_CLEANUP(zvec_free_##Name) zvec_##Name
+// Number of online CPUs (at least 1).
+static inline size_t zvec_cpu_count_impl(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0)
+    {
+        return (size_t)n;
+    }
 #endif
+    return 1;
+}
 
-// Generic dispatch using _Generic.
+// Small stable per-thread ordinal (0, 1, 2, ... in first-use order).
+static size_t zvec_thread_next_g = 0;
+static __thread size_t zvec_thread_index_g = 0;
 
-#ifdef __cplusplus
-    // C++ Overload Dispatch
-#   define zvec_push(v, val)          zvec_push_dispatch(v, val)
-#   define zvec_push_slot(v)          zvec_push_slot_dispatch(v)
-#   define zvec_extend(v, arr, count) zvec_extend_dispatch(v, arr, count)
-#   define zvec_reserve(v, cap)       zvec_reserve_dispatch(v, cap)
-#   define zvec_is_empty(v)           zvec_is_empty_dispatch(v)
-#   define zvec_at(v, idx)            zvec_at_dispatch(v, idx)
-#   define zvec_data(v)               zvec_data_dispatch(v)
-#   define zvec_last(v)               zvec_last_dispatch(v)
-#   define zvec_free(v)               zvec_free_dispatch(v)
-#   define zvec_pop(v)                zvec_pop_dispatch(v)
-#   define zvec_pop_get(v)            zvec_pop_get_dispatch(v)
-#   define zvec_shrink_to_fit(v)      zvec_shrink_to_fit_dispatch(v)
-#   define zvec_remove(v, i)          zvec_remove_dispatch(v, i)
-#   define zvec_swap_remove(v, i)     zvec_swap_remove_dispatch(v, i)
-#   define zvec_clear(v)              zvec_clear_dispatch(v)
-#   define zvec_reverse(v)            zvec_reverse_dispatch(v)
-#   define zvec_sort(v, cmp)          zvec_sort_dispatch(v, cmp)
-#   define zvec_bsearch(v, k, c)      zvec_bsearch_dispatch(v, k, c)
-#   define zvec_lower_bound(v, k, c)  zvec_lower_bound_dispatch(v, k, c)
-#else
-    // C _Generic Dispatch
-#   define zvec_push(v, val)          _Generic((v), Z_ALL_VECS(PUSH_ENTRY)          default: 0)(v, val)
-#   define zvec_push_slot(v)          _Generic((v), Z_ALL_VECS(PUSH_SLOT_ENTRY)     default: (void *)0)(v)
-#   define zvec_extend(v, arr, count) _Generic((v), Z_ALL_VECS(EXTEND_ENTRY)        default: 0)(v, arr, count)
-#   define zvec_reserve(v, cap)       _Generic((v), Z_ALL_VECS(RESERVE_ENTRY)       default: 0)(v, cap)
-#   define zvec_is_empty(v)           _Generic((v), Z_ALL_VECS(IS_EMPTY_ENTRY)      default: 0)(v)
-#   define zvec_at(v, idx)            _Generic((v), Z_ALL_VECS(AT_ENTRY)            default: (void *)0)(v, idx)
-#   define zvec_data(v)               _Generic((v), Z_ALL_VECS(DATA_ENTRY)          default: (void *)0)(v)
-#   define zvec_last(v)               _Generic((v), Z_ALL_VECS(LAST_ENTRY)          default: (void *)0)(v)
-#   define zvec_free(v)               _Generic((v), Z_ALL_VECS(FREE_ENTRY)          default: (void)0)(v)
-#   define zvec_pop(v)                _Generic((v), Z_ALL_VECS(POP_ENTRY)           default: (void)0)(v)
-#   define zvec_pop_get(v)            _Generic((v), Z_ALL_VECS(POP_GET_ENTRY)       default: (void)0)(v)
-#   define zvec_shrink_to_fit(v)      _Generic((v), Z_ALL_VECS(SHRINK_ENTRY)        default: (void)0)(v)
-#   define zvec_remove(v, i)          _Generic((v), Z_ALL_VECS(REMOVE_ENTRY)        default: (void)0)(v, i)
-#   define zvec_swap_remove(v, i)     _Generic((v), Z_ALL_VECS(SWAP_REM_ENTRY)      default: (void)0)(v, i)
-#   define zvec_clear(v)              _Generic((v), Z_ALL_VECS(CLEAR_ENTRY)         default: (void)0)(v)
-#   define zvec_reverse(v)            _Generic((v), Z_ALL_VECS(REVERSE_ENTRY)       default: (void)0)(v)
-#   define zvec_sort(v, cmp)          _Generic((v), Z_ALL_VECS(SORT_ENTRY)          default: (void)0)(v, cmp)
-#   define zvec_bsearch(v, k, c)      _Generic((v), Z_ALL_VECS(BSEARCH_ENTRY)       default: (void *)0)(v, k, c)
-#   define zvec_lower_bound(v, k, c)  _Generic((v), Z_ALL_VECS(LOWER_BOUND_ENTRY)   default: (void *)0)(v, k, c)
-#endif
+static inline size_t zvec_thread_index_impl(void)
+{
+    if (0 == zvec_thread_index_g)
+    {
+        zvec_thread_index_g = ZVEC_ATOMIC_FETCH_ADD(&zvec_thread_next_g, 1) + 1;
+    }
+    return zvec_thread_index_g - 1;
+}
 
-/* * Explicit declaration macro (portable C99)
- * Usage: zvec_foreach_decl(Int, &vec, it) { ... }
- */
-#define zvec_foreach_decl(Name, v, iter)                                        \
-    for (zvec_T_##Name *iter = (v)->data;                                       \
-         iter < (v)->data + (v)->length;                                        \
-         ++iter)
+typedef void (*zvec_par_body)(void *ctx, size_t begin, size_t end);
 
-// Smart iteration helpers (auto-inference).
-#if defined(__GNUC__) || defined(__clang__)
+typedef struct
+{
+    uint64_t range;
+    char pad[ZVEC_CACHE_LINE - sizeof(uint64_t)];
+} zvec_par_slot;
 
-    #define zvec_foreach(v, iter)                                               \
-        for (__typeof__((v)->data) iter = (v)->data;                            \
-             iter < (v)->data + (v)->length;                                    \
-             ++iter)
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    pthread_mutex_t job_lock;
+    size_t workers;
+    size_t pending;
+    unsigned long generation;
+    zvec_par_slot *slots;
+    zvec_par_body body;
+    void *ctx;
+    size_t n;
+    size_t chunk;
+    size_t skew;
+} zvec_par_pool;
 
-#else
+static zvec_par_pool zvec_par_pool_g = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+                                        PTHREAD_COND_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+                                        0, 0, 0, NULL, NULL, NULL, 0, 0, 0};
+static pthread_once_t zvec_par_once_g = PTHREAD_ONCE_INIT;
+static __thread int zvec_par_inside_g = 0;
 
-    /* Standard C fallback: User must declare 'iter' before loop.
-     * Usage: int *it; zvec_foreach(&vec, it) { ... }
-     */
-    #define zvec_foreach(v, iter)                                               \
-        for ((iter) = (v)->data;                                                \
-             (iter) < (v)->data + (v)->length;                                  \
-             ++(iter))
+// Takes one chunk index from the front (owner) or back (thief) of a slot.
+static inline int zvec_par_take_impl(zvec_par_slot *s, int from_back, size_t *out)
+{
+    uint64_t r = ZVEC_ATOMIC_LOAD(&s->range);
+    for (;;)
+    {
+        uint64_t lo = r & 0xFFFFFFFFu;
+        uint64_t hi = r >> 32;
+        uint64_t next;
+        if (lo >= hi)
+        {
+            return 0;
+        }
+        next = from_back ? ((hi - 1) << 32) | lo : (hi << 32) | (lo + 1);
+        if (ZVEC_ATOMIC_CAS(&s->range, &r, next))
+        {
+            *out = (size_t)(from_back ? hi - 1 : lo);
+            return 1;
+        }
+    }
+}
 
-#endif
+static inline void zvec_par_run_chunk_impl(zvec_par_body body, void *ctx, size_t n,
+                                           size_t chunk, size_t skew, size_t c)
+{
+    size_t begin = c * chunk;
+    size_t end = begin + chunk - skew;
+    begin = begin > skew ? begin - skew : 0;
+    body(ctx, begin, end < n ? end : n);
+}
 
-// Safe API dispatch (zerror.h required).
-#if Z_HAS_ZERROR && !defined(__cplusplus)
-    static inline zres zres_err_dummy(void *v, ...) 
+static inline void zvec_par_participate_impl(zvec_par_pool *p, size_t self)
+{
+    size_t parts = p->workers + 1;
+    size_t c, k;
+    zvec_par_inside_g = 1;
+    while (zvec_par_take_impl(&p->slots[self], 0, &c))
     {
-        (void)v; 
-        return zres_err(zerr_create(-1, "Unknown vector type")); 
+        zvec_par_run_chunk_impl(p->body, p->ctx, p->n, p->chunk, p->skew, c);
+    }
+    for (k = 1; k < parts; ++k)
+    {
+        zvec_par_slot *victim = &p->slots[(self + k) % parts];
+        while (zvec_par_take_impl(victim, 1, &c))
+        {
+            zvec_par_run_chunk_impl(p->body, p->ctx, p->n, p->chunk, p->skew, c);
+        }
     }
+    zvec_par_inside_g = 0;
+}
 
-#   define zvec_reserve_safe(v, cap) \
-        _Generic((v), Z_ALL_VECS(RESERVE_SAFE_ENTRY) default: zres_err_dummy)(v, cap, __FILE__, __LINE__, __func__)
+static void *zvec_par_worker_impl(void *arg)
+{
+    zvec_par_pool *p = &zvec_par_pool_g;
+    size_t self = (size_t)arg;
+    unsigned long seen = 0;
+    for (;;)
+    {
+        pthread_mutex_lock(&p->lock);
+        while (p->generation == seen)
+        {
+            pthread_cond_wait(&p->wake, &p->lock);
+        }
+        seen = p->generation;
+        pthread_mutex_unlock(&p->lock);
 
-#   define zvec_push_safe(v, val) \
-        _Generic((v), Z_ALL_VECS(PUSH_SAFE_ENTRY) default: zres_err_dummy)(v, val, __FILE__, __LINE__, __func__)
+        zvec_par_participate_impl(p, self);
 
-#   define zvec_pop_safe(v) \
-        _Generic((v), Z_ALL_VECS(POP_SAFE_ENTRY) default: zres_err_dummy)(v, __FILE__, __LINE__, __func__)
+        pthread_mutex_lock(&p->lock);
+        if (0 == --p->pending)
+        {
+            pthread_cond_signal(&p->done);
+        }
+        pthread_mutex_unlock(&p->lock);
+    }
+    return NULL;
+}
 
-#   define zvec_at_safe(v, i) \
-        _Generic((v), Z_ALL_VECS(AT_SAFE_ENTRY) default: zres_err_dummy)(v, i, __FILE__, __LINE__, __func__)
+static void zvec_par_start_impl(void)
+{
+    zvec_par_pool *p = &zvec_par_pool_g;
+    long want = ZVEC_PAR_THREADS;
+    size_t i;
+    pthread_attr_t attr;
+    if (want <= 0)
+    {
+        want = (long)zvec_cpu_count_impl() - 1;
+    }
+    if (want <= 0)
+    {
+        return;
+    }
+    p->slots = (zvec_par_slot *)ZVEC_CALLOC((size_t)want + 1, sizeof(zvec_par_slot));
+    if (!p->slots)
+    {
+        return;
+    }
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for (i = 0; i < (size_t)want; ++i)
+    {
+        pthread_t th;
+        if (0 != pthread_create(&th, &attr, zvec_par_worker_impl, (void *)(i + 1)))
+        {
+            break;
+        }
+    }
+    pthread_attr_destroy(&attr);
+    p->workers = i;
+}
 
-#   define zvec_last_safe(v) \
-        _Generic((v), Z_ALL_VECS(LAST_SAFE_ENTRY) default: zres_err_dummy)(v, __FILE__, __LINE__, __func__)
+/*
+ * Picks the chunk length for n elements: about ZVEC_PAR_CHUNKS_PER_THREAD
+ * chunks per participant, at least ZVEC_PAR_GRAIN, and a multiple of 'align'
+ * (elements per cache line) so chunks never share a line.
+ */
+static inline size_t zvec_par_chunk_impl(size_t n, size_t align)
+{
+    size_t parts = 1;
+    size_t chunk;
+    if (n > ZVEC_PAR_GRAIN && !zvec_par_inside_g)
+    {
+        pthread_once(&zvec_par_once_g, zvec_par_start_impl);
+        parts = zvec_par_pool_g.workers + 1;
+    }
+    chunk = (n + parts * ZVEC_PAR_CHUNKS_PER_THREAD - 1) / (parts * ZVEC_PAR_CHUNKS_PER_THREAD);
+    if (chunk < ZVEC_PAR_GRAIN)
+    {
+        chunk = ZVEC_PAR_GRAIN;
+    }
+    if (chunk < n / 0x7FFFFFFFu + 1)
+    {
+        chunk = n / 0x7FFFFFFFu + 1;
+    }
+    return (chunk + align - 1) / align * align;
+}
+
+// Number of chunks zvec_par_run_impl cuts [0, n) into.
+static inline size_t zvec_par_count_impl(size_t n, size_t chunk, size_t skew)
+{
+    return n ? (n + skew + chunk - 1) / chunk : 0;
+}
+
+/*
+ * Runs body(ctx, begin, end) once per chunk. Chunk c covers
+ * [c * chunk - skew, (c + 1) * chunk - skew) clipped to [0, n); 'skew' is how
+ * many elements precede the data in its first cache line. Falls back to the
+ * calling thread for small inputs, nested calls or an empty pool.
+ */
+static inline void zvec_par_run_impl(size_t n, size_t chunk, size_t skew,
+                                     zvec_par_body body, void *ctx)
+{
+    zvec_par_pool *p = &zvec_par_pool_g;
+    size_t nchunks = zvec_par_count_impl(n, chunk, skew);
+    size_t parts, i;
+    if (nchunks > 1 && !zvec_par_inside_g)
+    {
+        pthread_once(&zvec_par_once_g, zvec_par_start_impl);
+    }
+    if (nchunks < 2 || zvec_par_inside_g || 0 == p->workers)
+    {
+        for (i = 0; i < nchunks; ++i)
+        {
+            zvec_par_run_chunk_impl(body, ctx, n, chunk, skew, i);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&p->job_lock);
+    parts = p->workers + 1;
+    for (i = 0; i < parts; ++i)
+    {
+        uint64_t lo = (uint64_t)(nchunks * i / parts);
+        uint64_t hi = (uint64_t)(nchunks * (i + 1) / parts);
+        ZVEC_ATOMIC_STORE(&p->slots[i].range, (hi << 32) | lo);
+    }
+
+    pthread_mutex_lock(&p->lock);
+    p->body = body;
+    p->ctx = ctx;
+    p->n = n;
+    p->chunk = chunk;
+    p->skew = skew;
+    p->pending = p->workers;
+    p->generation++;
+    pthread_cond_broadcast(&p->wake);
+    pthread_mutex_unlock(&p->lock);
+
+    zvec_par_participate_impl(p, 0);
+
+    pthread_mutex_lock(&p->lock);
+    while (p->pending)
+    {
+        pthread_cond_wait(&p->done, &p->lock);
+    }
+    pthread_mutex_unlock(&p->lock);
+    pthread_mutex_unlock(&p->job_lock);
+}
+
+// Elements per cache line and the leading partial line of 'data', for chunking.
+#define ZVEC_PAR_ALIGN(sz)  ((ZVEC_CACHE_LINE % (sz)) == 0 ? ZVEC_CACHE_LINE / (sz) : 1)
+#define ZVEC_PAR_SKEW(data, sz)                                                             \
+    ((ZVEC_CACHE_LINE % (sz)) == 0 ? ((uintptr_t)(data) % ZVEC_CACHE_LINE) / (sz) : 0)
+
+/*
+ * zvec_epoch: epoch-based reclamation domain.
+ *
+ * Readers register once for a slot, then bracket every read section with
+ * enter/exit, which publishes the global epoch they started in. Writers retire
+ * memory they have unlinked; a retired block tagged with epoch E is freed once
+ * every reader inside a section started after E. Entering and exiting is a
+ * store each, so read sections never contend with each other.
+ */
+#ifndef ZVEC_EPOCH_SLOTS
+#   define ZVEC_EPOCH_SLOTS 64   // Maximum concurrently registered reader threads.
+#endif
+
+typedef struct
+{
+    size_t epoch;   // Epoch the current read section started in, 0 when idle.
+    int claimed;
+    char pad[ZVEC_CACHE_LINE - sizeof(size_t) - sizeof(int)];
+} zvec_epoch_slot;
+
+typedef struct
+{
+    void *ptr;
+    void (*reclaim)(void *);
+    size_t epoch;
+} zvec_epoch_retired;
+
+typedef struct
+{
+    size_t global;
+    char pad[ZVEC_CACHE_LINE - sizeof(size_t)];
+    zvec_epoch_slot slots[ZVEC_EPOCH_SLOTS];
+    zvec_epoch_retired *retired;
+    size_t retired_len;
+    size_t retired_cap;
+} zvec_epoch;
+
+static inline void zvec_epoch_init(zvec_epoch *e)
+{
+    memset(e, 0, sizeof(zvec_epoch));
+    e->global = 1;
+}
+
+// Returns a reader slot, or -1 if all ZVEC_EPOCH_SLOTS are taken.
+static inline int zvec_epoch_register(zvec_epoch *e)
+{
+    int i;
+    for (i = 0; i < ZVEC_EPOCH_SLOTS; ++i)
+    {
+        int expected = 0;
+        if (ZVEC_ATOMIC_CAS(&e->slots[i].claimed, &expected, 1))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static inline void zvec_epoch_unregister(zvec_epoch *e, int slot)
+{
+    ZVEC_ATOMIC_STORE(&e->slots[slot].epoch, (size_t)0);
+    ZVEC_ATOMIC_STORE(&e->slots[slot].claimed, 0);
+}
+
+static inline void zvec_epoch_enter(zvec_epoch *e, int slot)
+{
+    __atomic_store_n(&e->slots[slot].epoch, __atomic_load_n(&e->global, __ATOMIC_SEQ_CST),
+                     __ATOMIC_SEQ_CST);
+}
+
+static inline void zvec_epoch_exit(zvec_epoch *e, int slot)
+{
+    ZVEC_ATOMIC_STORE(&e->slots[slot].epoch, (size_t)0);
+}
+
+// Oldest epoch a reader is still in, or the current one if nobody is reading.
+static inline size_t zvec_epoch_min_impl(zvec_epoch *e)
+{
+    size_t min = __atomic_load_n(&e->global, __ATOMIC_SEQ_CST);
+    int i;
+    for (i = 0; i < ZVEC_EPOCH_SLOTS; ++i)
+    {
+        size_t s = __atomic_load_n(&e->slots[i].epoch, __ATOMIC_SEQ_CST);
+        if (s && s < min)
+        {
+            min = s;
+        }
+    }
+    return min;
+}
+
+/*
+ * Writer side: advances the epoch and frees every retired block no reader can
+ * still see. Returns how many blocks are still pending.
+ */
+static inline size_t zvec_epoch_collect(zvec_epoch *e)
+{
+    size_t min, i, kept = 0;
+    __atomic_fetch_add(&e->global, 1, __ATOMIC_SEQ_CST);
+    min = zvec_epoch_min_impl(e);
+    for (i = 0; i < e->retired_len; ++i)
+    {
+        zvec_epoch_retired *r = &e->retired[i];
+        if (r->epoch < min)
+        {
+            r->reclaim(r->ptr);
+        }
+        else
+        {
+            e->retired[kept++] = *r;
+        }
+    }
+    e->retired_len = kept;
+    return kept;
+}
+
+// Writer side: waits until no reader is still inside a section from epoch <= 'tag'.
+static inline void zvec_epoch_wait_impl(zvec_epoch *e, size_t tag)
+{
+    __atomic_fetch_add(&e->global, 1, __ATOMIC_SEQ_CST);
+    while (zvec_epoch_min_impl(e) <= tag)
+    {
+        sched_yield();
+    }
+}
+
+/*
+ * Writer side: hands 'ptr' to reclaim() once no reader can reach it. Call only
+ * after the last shared reference to 'ptr' has been replaced.
+ */
+static inline void zvec_epoch_retire(zvec_epoch *e, void *ptr, void (*reclaim)(void *))
+{
+    size_t tag = __atomic_load_n(&e->global, __ATOMIC_SEQ_CST);
+    if (e->retired_len == e->retired_cap)
+    {
+        size_t cap = e->retired_cap ? e->retired_cap * 2 : 8;
+        zvec_epoch_retired *r = (zvec_epoch_retired *)ZVEC_REALLOC(
+            e->retired, cap * sizeof(zvec_epoch_retired));
+        if (!r)
+        {
+            // No room to defer it: wait out the readers and free it now.
+            zvec_epoch_wait_impl(e, tag);
+            reclaim(ptr);
+            return;
+        }
+        e->retired = r;
+        e->retired_cap = cap;
+    }
+    e->retired[e->retired_len].ptr = ptr;
+    e->retired[e->retired_len].reclaim = reclaim;
+    e->retired[e->retired_len].epoch = tag;
+    e->retired_len++;
+    zvec_epoch_collect(e);
+}
+
+// Writer side: blocks until every retired block has been freed.
+static inline void zvec_epoch_synchronize(zvec_epoch *e)
+{
+    while (zvec_epoch_collect(e))
+    {
+        sched_yield();
+    }
+}
+
+// Reclaim callback for buffers from ZVEC_MALLOC.
+static inline void zvec_epoch_free_impl(void *p)
+{
+    ZVEC_FREE(p);
+}
+
+// Frees everything still retired. Only valid once no reader is left.
+static inline void zvec_epoch_free(zvec_epoch *e)
+{
+    size_t i;
+    for (i = 0; i < e->retired_len; ++i)
+    {
+        e->retired[i].reclaim(e->retired[i].ptr);
+    }
+    ZVEC_FREE(e->retired);
+    memset(e, 0, sizeof(zvec_epoch));
+}
+
+/*
+ * zvec_conc_##Name: lock-free multi-producer append vector.
+ *
+ * Producers claim indices with one atomic fetch-add (a whole range for extend)
+ * and write into segmented storage: segment k holds ZVEC_CONC_FIRST << k slots
+ * and is installed once with CAS, so claimed slots never move. Each slot has a
+ * ready flag set with release semantics after it is written; readers use
+ * zvec_conc_at (NULL until published) or zvec_conc_watermark, the length of the
+ * fully published prefix. Slots claimed by a push that failed with Z_ENOMEM are
+ * never published, so reserve up front when the watermark matters.
+ */
+#ifndef ZVEC_CONC_FIRST
+#   define ZVEC_CONC_FIRST      64  // Slots in the first segment (power of two).
+#endif
+#define ZVEC_CONC_SEGMENTS      48
+
+static inline void zvec_conc_locate_impl(size_t i, unsigned *seg, size_t *off)
+{
+    size_t x = i + ZVEC_CONC_FIRST;
+    unsigned h = 63u - (unsigned)__builtin_clzll((unsigned long long)x);
+    *seg = h - (unsigned)__builtin_ctzll((unsigned long long)ZVEC_CONC_FIRST);
+    *off = x - ((size_t)1 << h);
+}
+
+#define ZVEC_GEN_CONC_IMPL(T, Name)                                                         \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        T *segs[ZVEC_CONC_SEGMENTS];                                                        \
+        char pad0[ZVEC_CACHE_LINE];                                                         \
+        size_t claimed;                                                                     \
+        char pad1[ZVEC_CACHE_LINE - sizeof(size_t)];                                        \
+        size_t watermark;                                                                   \
+        char pad2[ZVEC_CACHE_LINE - sizeof(size_t)];                                        \
+    } zvec_conc_##Name;                                                                     \
+                                                                                            \
+    static inline zvec_conc_##Name zvec_conc_init_##Name(void)                              \
+    {                                                                                       \
+        zvec_conc_##Name c;                                                                 \
+        memset(&c, 0, sizeof(zvec_conc_##Name));                                            \
+        return c;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_conc_free_##Name(zvec_conc_##Name *c)                           \
+    {                                                                                       \
+        size_t k;                                                                           \
+        for (k = 0; k < ZVEC_CONC_SEGMENTS; ++k)                                            \
+        {                                                                                   \
+            ZVEC_FREE(c->segs[k]);                                                          \
+        }                                                                                   \
+        memset(c, 0, sizeof(zvec_conc_##Name));                                             \
+    }                                                                                       \
+                                                                                            \
+    /* Segment k holds (ZVEC_CONC_FIRST << k) slots followed by their ready flags. */       \
+    static inline T *zvec_conc_seg_impl_##Name(zvec_conc_##Name *c, unsigned k)             \
+    {                                                                                       \
+        T *seg = ZVEC_ATOMIC_LOAD(&c->segs[k]);                                             \
+        if (!seg)                                                                           \
+        {                                                                                   \
+            size_t n = (size_t)ZVEC_CONC_FIRST << k;                                        \
+            T *expected = NULL;                                                             \
+            T *fresh = (T *)ZVEC_CALLOC(1, n * sizeof(T) + n);                              \
+            if (!fresh)                                                                     \
+            {                                                                               \
+                return NULL;                                                                \
+            }                                                                               \
+            if (ZVEC_ATOMIC_CAS(&c->segs[k], &expected, fresh))                             \
+            {                                                                               \
+                return fresh;                                                               \
+            }                                                                               \
+            ZVEC_FREE(fresh);                                                               \
+            seg = expected;                                                                 \
+        }                                                                                   \
+        return seg;                                                                         \
+    }                                                                                       \
+                                                                                            \
+    static inline unsigned char *zvec_conc_flag_impl_##Name(T *seg, unsigned k, size_t off) \
+    {                                                                                       \
+        return (unsigned char *)(seg + ((size_t)ZVEC_CONC_FIRST << k)) + off;               \
+    }                                                                                       \
+                                                                                            \
+    /* Claims one slot; *index receives its position. Publish it when filled. */            \
+    static inline T *zvec_conc_push_slot_##Name(zvec_conc_##Name *c, size_t *index)         \
+    {                                                                                       \
+        size_t i = ZVEC_ATOMIC_FETCH_ADD(&c->claimed, 1);                                   \
+        unsigned k;                                                                         \
+        size_t off;                                                                         \
+        T *seg;                                                                             \
+        zvec_conc_locate_impl(i, &k, &off);                                                 \
+        seg = zvec_conc_seg_impl_##Name(c, k);                                              \
+        if (!seg)                                                                           \
+        {                                                                                   \
+            return NULL;                                                                    \
+        }                                                                                   \
+        *index = i;                                                                         \
+        return &seg[off];                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_conc_publish_##Name(zvec_conc_##Name *c, size_t index)          \
+    {                                                                                       \
+        unsigned k;                                                                         \
+        size_t off;                                                                         \
+        T *seg;                                                                             \
+        zvec_conc_locate_impl(index, &k, &off);                                             \
+        seg = ZVEC_ATOMIC_LOAD(&c->segs[k]);                                                \
+        ZVEC_ATOMIC_STORE(zvec_conc_flag_impl_##Name(seg, k, off), (unsigned char)1);       \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_conc_push_##Name(zvec_conc_##Name *c, T value)                   \
+    {                                                                                       \
+        size_t i;                                                                           \
+        T *slot = zvec_conc_push_slot_##Name(c, &i);                                        \
+        if (!slot)                                                                          \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        *slot = value;                                                                      \
+        zvec_conc_publish_##Name(c, i);                                                     \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Claims 'count' contiguous indices with a single fetch-add. */                        \
+    static inline int zvec_conc_extend_##Name(zvec_conc_##Name *c, const T *items,          \
+                                              size_t count)                                 \
+    {                                                                                       \
+        size_t base = ZVEC_ATOMIC_FETCH_ADD(&c->claimed, count);                            \
+        size_t done = 0;                                                                    \
+        while (done < count)                                                                \
+        {                                                                                   \
+            unsigned k;                                                                     \
+            size_t off, n, j;                                                               \
+            T *seg;                                                                         \
+            zvec_conc_locate_impl(base + done, &k, &off);                                   \
+            seg = zvec_conc_seg_impl_##Name(c, k);                                          \
+            if (!seg)                                                                       \
+            {                                                                               \
+                return Z_ENOMEM;                                                            \
+            }                                                                               \
+            n = ((size_t)ZVEC_CONC_FIRST << k) - off;                                       \
+            if (n > count - done)                                                           \
+            {                                                                               \
+                n = count - done;                                                           \
+            }                                                                               \
+            for (j = 0; j < n; ++j)                                                         \
+            {                                                                               \
+                seg[off + j] = items[done + j];                                             \
+            }                                                                               \
+            for (j = 0; j < n; ++j)                                                         \
+            {                                                                               \
+                ZVEC_ATOMIC_STORE(zvec_conc_flag_impl_##Name(seg, k, off + j),              \
+                                  (unsigned char)1);                                        \
+            }                                                                               \
+            done += n;                                                                      \
+        }                                                                                   \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Preallocates segments so that the first 'cap' slots never hit the allocator. */      \
+    static inline int zvec_conc_reserve_##Name(zvec_conc_##Name *c, size_t cap)             \
+    {                                                                                       \
+        unsigned k, last;                                                                   \
+        size_t off;                                                                         \
+        if (0 == cap)                                                                       \
+        {                                                                                   \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+        zvec_conc_locate_impl(cap - 1, &last, &off);                                        \
+        for (k = 0; k <= last; ++k)                                                         \
+        {                                                                                   \
+            if (!zvec_conc_seg_impl_##Name(c, k))                                           \
+            {                                                                               \
+                return Z_ENOMEM;                                                            \
+            }                                                                               \
+        }                                                                                   \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Number of claimed slots (some may not be published yet). */                          \
+    static inline size_t zvec_conc_size_##Name(zvec_conc_##Name *c)                         \
+    {                                                                                       \
+        return ZVEC_ATOMIC_LOAD(&c->claimed);                                               \
+    }                                                                                       \
+                                                                                            \
+    /* Published element at 'index', or NULL if unclaimed or still being written. */        \
+    static inline T *zvec_conc_at_##Name(zvec_conc_##Name *c, size_t index)                 \
+    {                                                                                       \
+        unsigned k;                                                                         \
+        size_t off;                                                                         \
+        T *seg;                                                                             \
+        if (index >= ZVEC_ATOMIC_LOAD(&c->claimed))                                         \
+        {                                                                                   \
+            return NULL;                                                                    \
+        }                                                                                   \
+        zvec_conc_locate_impl(index, &k, &off);                                             \
+        seg = ZVEC_ATOMIC_LOAD(&c->segs[k]);                                                \
+        if (!seg || !ZVEC_ATOMIC_LOAD(zvec_conc_flag_impl_##Name(seg, k, off)))             \
+        {                                                                                   \
+            return NULL;                                                                    \
+        }                                                                                   \
+        return &seg[off];                                                                   \
+    }                                                                                       \
+                                                                                            \
+    /* Advances and returns the commit watermark: every index below it is published. */     \
+    static inline size_t zvec_conc_watermark_##Name(zvec_conc_##Name *c)                    \
+    {                                                                                       \
+        size_t start = ZVEC_ATOMIC_LOAD(&c->watermark);                                     \
+        size_t w = start;                                                                   \
+        while (zvec_conc_at_##Name(c, w))                                                   \
+        {                                                                                   \
+            w++;                                                                            \
+        }                                                                                   \
+        while (start < w && !ZVEC_ATOMIC_CAS(&c->watermark, &start, w))                     \
+        {                                                                                   \
+        }                                                                                   \
+        return start > w ? start : w;                                                       \
+    }                                                                                       \
+                                                                                            \
+    /* Appends the published prefix [0, watermark) to a regular vector. */                  \
+    static inline int zvec_conc_to_vec_##Name(zvec_conc_##Name *c, zvec_##Name *out)        \
+    {                                                                                       \
+        size_t end = zvec_conc_watermark_##Name(c);                                         \
+        size_t done = 0;                                                                    \
+        if (Z_OK != zvec_reserve_##Name(out, out->length + end))                            \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        while (done < end)                                                                  \
+        {                                                                                   \
+            unsigned k;                                                                     \
+            size_t off, n;                                                                  \
+            zvec_conc_locate_impl(done, &k, &off);                                          \
+            n = ((size_t)ZVEC_CONC_FIRST << k) - off;                                       \
+            if (n > end - done)                                                             \
+            {                                                                               \
+                n = end - done;                                                             \
+            }                                                                               \
+            zvec_extend_##Name(out, c->segs[k] + off, n);                                   \
+            done += n;                                                                      \
+        }                                                                                   \
+        return Z_OK;                                                                        \
+    }
+
+/*
+ * zvec_spsc_##Name: bounded single-producer / single-consumer ring.
+ *
+ * Storage is a regular zvec_##Name with power-of-two capacity. Head and tail are
+ * free-running counters on separate cache lines; each side also caches the
+ * other side's counter and only reloads it (acquire) when the cached value says
+ * the ring is full / empty. reserve_slot + commit and front + release give
+ * zero-copy access in the spirit of zvec_push_slot.
+ */
+#define ZVEC_GEN_SPSC_IMPL(T, Name)                                                         \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        zvec_##Name buf;                                                                    \
+        size_t mask;                                                                        \
+        char pad0[ZVEC_CACHE_LINE];                                                         \
+        size_t tail;                                                                        \
+        size_t head_cache;                                                                  \
+        char pad1[ZVEC_CACHE_LINE - 2 * sizeof(size_t)];                                    \
+        size_t head;                                                                        \
+        size_t tail_cache;                                                                  \
+        char pad2[ZVEC_CACHE_LINE - 2 * sizeof(size_t)];                                    \
+    } zvec_spsc_##Name;                                                                     \
+                                                                                            \
+    /* Capacity is rounded up to a power of two. */                                         \
+    static inline int zvec_spsc_init_##Name(zvec_spsc_##Name *q, size_t capacity)           \
+    {                                                                                       \
+        size_t cap = 2;                                                                     \
+        memset(q, 0, sizeof(zvec_spsc_##Name));                                             \
+        while (cap < capacity)                                                              \
+        {                                                                                   \
+            cap <<= 1;                                                                      \
+        }                                                                                   \
+        if (Z_OK != zvec_reserve_##Name(&q->buf, cap))                                      \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        q->mask = cap - 1;                                                                  \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_spsc_free_##Name(zvec_spsc_##Name *q)                           \
+    {                                                                                       \
+        zvec_free_##Name(&q->buf);                                                          \
+        memset(q, 0, sizeof(zvec_spsc_##Name));                                             \
+    }                                                                                       \
+                                                                                            \
+    /* Free slots as seen by the producer, refreshing the cached head if needed. */         \
+    static inline size_t zvec_spsc_space_impl_##Name(zvec_spsc_##Name *q, size_t t,         \
+                                                     size_t want)                           \
+    {                                                                                       \
+        size_t cap = q->mask + 1;                                                           \
+        if (cap - (t - q->head_cache) < want)                                               \
+        {                                                                                   \
+            q->head_cache = ZVEC_ATOMIC_LOAD(&q->head);                                     \
+        }                                                                                   \
+        return cap - (t - q->head_cache);                                                   \
+    }                                                                                       \
+                                                                                            \
+    /* Filled slots as seen by the consumer, refreshing the cached tail if needed. */       \
+    static inline size_t zvec_spsc_avail_impl_##Name(zvec_spsc_##Name *q, size_t h,         \
+                                                     size_t want)                           \
+    {                                                                                       \
+        if (q->tail_cache - h < want)                                                       \
+        {                                                                                   \
+            q->tail_cache = ZVEC_ATOMIC_LOAD(&q->tail);                                     \
+        }                                                                                   \
+        return q->tail_cache - h;                                                           \
+    }                                                                                       \
+                                                                                            \
+    /* Producer: returns 1 if pushed, 0 if the ring is full. */                             \
+    static inline int zvec_spsc_push_##Name(zvec_spsc_##Name *q, T value)                   \
+    {                                                                                       \
+        size_t t = ZVEC_ATOMIC_LOAD_RELAXED(&q->tail);                                      \
+        if (0 == zvec_spsc_space_impl_##Name(q, t, 1))                                      \
+        {                                                                                   \
+            return 0;                                                                       \
+        }                                                                                   \
+        q->buf.data[t & q->mask] = value;                                                   \
+        ZVEC_ATOMIC_STORE(&q->tail, t + 1);                                                 \
+        return 1;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    /* Producer: zero-copy slot for the next element, or NULL if full. */                   \
+    static inline T *zvec_spsc_reserve_slot_##Name(zvec_spsc_##Name *q)                     \
+    {                                                                                       \
+        size_t t = ZVEC_ATOMIC_LOAD_RELAXED(&q->tail);                                      \
+        if (0 == zvec_spsc_space_impl_##Name(q, t, 1))                                      \
+        {                                                                                   \
+            return NULL;                                                                    \
+        }                                                                                   \
+        return &q->buf.data[t & q->mask];                                                   \
+    }                                                                                       \
+                                                                                            \
+    /* Producer: publishes the slot returned by zvec_spsc_reserve_slot. */                  \
+    static inline void zvec_spsc_commit_##Name(zvec_spsc_##Name *q)                         \
+    {                                                                                       \
+        ZVEC_ATOMIC_STORE(&q->tail, ZVEC_ATOMIC_LOAD_RELAXED(&q->tail) + 1);                \
+    }                                                                                       \
+                                                                                            \
+    /* Producer: pushes up to 'count' items; returns how many fit. */                       \
+    static inline size_t zvec_spsc_push_n_##Name(zvec_spsc_##Name *q, const T *items,       \
+                                                 size_t count)                              \
+    {                                                                                       \
+        size_t t = ZVEC_ATOMIC_LOAD_RELAXED(&q->tail);                                      \
+        size_t n = zvec_spsc_space_impl_##Name(q, t, count);                                \
+        size_t i;                                                                           \
+        if (n > count)                                                                      \
+        {                                                                                   \
+            n = count;                                                                      \
+        }                                                                                   \
+        for (i = 0; i < n; ++i)                                                             \
+        {                                                                                   \
+            q->buf.data[(t + i) & q->mask] = items[i];                                      \
+        }                                                                                   \
+        ZVEC_ATOMIC_STORE(&q->tail, t + n);                                                 \
+        return n;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    /* Consumer: returns 1 and copies the oldest element to *out, or 0 if empty. */         \
+    static inline int zvec_spsc_pop_##Name(zvec_spsc_##Name *q, T *out)                     \
+    {                                                                                       \
+        size_t h = ZVEC_ATOMIC_LOAD_RELAXED(&q->head);                                      \
+        if (0 == zvec_spsc_avail_impl_##Name(q, h, 1))                                      \
+        {                                                                                   \
+            return 0;                                                                       \
+        }                                                                                   \
+        *out = q->buf.data[h & q->mask];                                                    \
+        ZVEC_ATOMIC_STORE(&q->head, h + 1);                                                 \
+        return 1;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    /* Consumer: zero-copy pointer to the oldest element, or NULL if empty. */              \
+    static inline T *zvec_spsc_front_##Name(zvec_spsc_##Name *q)                            \
+    {                                                                                       \
+        size_t h = ZVEC_ATOMIC_LOAD_RELAXED(&q->head);                                      \
+        if (0 == zvec_spsc_avail_impl_##Name(q, h, 1))                                      \
+        {                                                                                   \
+            return NULL;                                                                    \
+        }                                                                                   \
+        return &q->buf.data[h & q->mask];                                                   \
+    }                                                                                       \
+                                                                                            \
+    /* Consumer: drops the element returned by zvec_spsc_front. */                          \
+    static inline void zvec_spsc_release_##Name(zvec_spsc_##Name *q)                        \
+    {                                                                                       \
+        ZVEC_ATOMIC_STORE(&q->head, ZVEC_ATOMIC_LOAD_RELAXED(&q->head) + 1);                \
+    }                                                                                       \
+                                                                                            \
+    /* Consumer: pops up to 'count' items into 'out'; returns how many. */                  \
+    static inline size_t zvec_spsc_pop_n_##Name(zvec_spsc_##Name *q, T *out, size_t count)  \
+    {                                                                                       \
+        size_t h = ZVEC_ATOMIC_LOAD_RELAXED(&q->head);                                      \
+        size_t n = zvec_spsc_avail_impl_##Name(q, h, count);                                \
+        size_t i;                                                                           \
+        if (n > count)                                                                      \
+        {                                                                                   \
+            n = count;                                                                      \
+        }                                                                                   \
+        for (i = 0; i < n; ++i)                                                             \
+        {                                                                                   \
+            out[i] = q->buf.data[(h + i) & q->mask];                                        \
+        }                                                                                   \
+        ZVEC_ATOMIC_STORE(&q->head, h + n);                                                 \
+        return n;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    /* Approximate number of queued elements (exact when both sides are idle). */           \
+    static inline size_t zvec_spsc_size_##Name(zvec_spsc_##Name *q)                         \
+    {                                                                                       \
+        size_t h = ZVEC_ATOMIC_LOAD(&q->head);                                              \
+        return ZVEC_ATOMIC_LOAD(&q->tail) - h;                                              \
+    }
+
+
+/*
+ * zvec_mpmc_##Name: bounded multi-producer / multi-consumer queue.
+ *
+ * Vyukov-style ring: every slot of the zvec_##Name storage has a sequence number
+ * telling whether it is ready for the next push (seq == pos) or pop
+ * (seq == pos + 1). Producers and consumers claim positions with a CAS on their
+ * own padded counter, so neither side takes a lock. The blocking variants spin
+ * ZVEC_SPIN_LIMIT times, then sleep on a condition variable that the try
+ * variants only signal when someone is actually waiting.
+ */
+#define ZVEC_GEN_MPMC_IMPL(T, Name)                                                         \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        zvec_##Name buf;                                                                    \
+        size_t *seq;                                                                        \
+        size_t mask;                                                                        \
+        char pad0[ZVEC_CACHE_LINE];                                                         \
+        size_t enqueue_pos;                                                                 \
+        char pad1[ZVEC_CACHE_LINE - sizeof(size_t)];                                        \
+        size_t dequeue_pos;                                                                 \
+        char pad2[ZVEC_CACHE_LINE - sizeof(size_t)];                                        \
+        pthread_mutex_t lock;                                                               \
+        pthread_cond_t not_empty;                                                           \
+        pthread_cond_t not_full;                                                            \
+        int pop_waiters;                                                                    \
+        int push_waiters;                                                                   \
+        int closed;                                                                         \
+    } zvec_mpmc_##Name;                                                                     \
+                                                                                            \
+    /* Capacity is rounded up to a power of two. */                                         \
+    static inline int zvec_mpmc_init_##Name(zvec_mpmc_##Name *q, size_t capacity)           \
+    {                                                                                       \
+        size_t i, cap = 2;                                                                  \
+        memset(q, 0, sizeof(zvec_mpmc_##Name));                                             \
+        while (cap < capacity)                                                              \
+        {                                                                                   \
+            cap <<= 1;                                                                      \
+        }                                                                                   \
+        q->seq = (size_t *)ZVEC_MALLOC(cap * sizeof(size_t));                               \
+        if (!q->seq || Z_OK != zvec_reserve_##Name(&q->buf, cap))                           \
+        {                                                                                   \
+            ZVEC_FREE(q->seq);                                                              \
+            q->seq = NULL;                                                                  \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        for (i = 0; i < cap; ++i)                                                           \
+        {                                                                                   \
+            q->seq[i] = i;                                                                  \
+        }                                                                                   \
+        q->mask = cap - 1;                                                                  \
+        pthread_mutex_init(&q->lock, NULL);                                                 \
+        pthread_cond_init(&q->not_empty, NULL);                                             \
+        pthread_cond_init(&q->not_full, NULL);                                              \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_mpmc_free_##Name(zvec_mpmc_##Name *q)                           \
+    {                                                                                       \
+        pthread_mutex_destroy(&q->lock);                                                    \
+        pthread_cond_destroy(&q->not_empty);                                                \
+        pthread_cond_destroy(&q->not_full);                                                 \
+        zvec_free_##Name(&q->buf);                                                          \
+        ZVEC_FREE(q->seq);                                                                  \
+        memset(q, 0, sizeof(zvec_mpmc_##Name));                                             \
+    }                                                                                       \
+                                                                                            \
+    /* Wakes threads sleeping on 'cond' if the matching waiter count is non-zero. */        \
+    static inline void zvec_mpmc_wake_impl_##Name(zvec_mpmc_##Name *q, int *waiters,        \
+                                                  pthread_cond_t *cond)                     \
+    {                                                                                       \
+        ZVEC_ATOMIC_FENCE();                                                                \
+        if (ZVEC_ATOMIC_LOAD_RELAXED(waiters) > 0)                                          \
+        {                                                                                   \
+            pthread_mutex_lock(&q->lock);                                                   \
+            pthread_cond_broadcast(cond);                                                   \
+            pthread_mutex_unlock(&q->lock);                                                 \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_mpmc_enqueue_impl_##Name(zvec_mpmc_##Name *q, T value)           \
+    {                                                                                       \
+        size_t pos = ZVEC_ATOMIC_LOAD_RELAXED(&q->enqueue_pos);                             \
+        for (;;)                                                                            \
+        {                                                                                   \
+            size_t seq = ZVEC_ATOMIC_LOAD(&q->seq[pos & q->mask]);                          \
+            ptrdiff_t diff = (ptrdiff_t)(seq - pos);                                        \
+            if (0 == diff)                                                                  \
+            {                                                                               \
+                if (ZVEC_ATOMIC_CAS(&q->enqueue_pos, &pos, pos + 1))                        \
+                {                                                                           \
+                    break;                                                                  \
+                }                                                                           \
+            }                                                                               \
+            else if (diff < 0)                                                              \
+            {                                                                               \
+                return 0;                                                                   \
+            }                                                                               \
+            else                                                                            \
+            {                                                                               \
+                pos = ZVEC_ATOMIC_LOAD_RELAXED(&q->enqueue_pos);                            \
+            }                                                                               \
+        }                                                                                   \
+        q->buf.data[pos & q->mask] = value;                                                 \
+        ZVEC_ATOMIC_STORE(&q->seq[pos & q->mask], pos + 1);                                 \
+        return 1;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_mpmc_dequeue_impl_##Name(zvec_mpmc_##Name *q, T *out)            \
+    {                                                                                       \
+        size_t pos = ZVEC_ATOMIC_LOAD_RELAXED(&q->dequeue_pos);                             \
+        for (;;)                                                                            \
+        {                                                                                   \
+            size_t seq = ZVEC_ATOMIC_LOAD(&q->seq[pos & q->mask]);                          \
+            ptrdiff_t diff = (ptrdiff_t)(seq - (pos + 1));                                  \
+            if (0 == diff)                                                                  \
+            {                                                                               \
+                if (ZVEC_ATOMIC_CAS(&q->dequeue_pos, &pos, pos + 1))                        \
+                {                                                                           \
+                    break;                                                                  \
+                }                                                                           \
+            }                                                                               \
+            else if (diff < 0)                                                              \
+            {                                                                               \
+                return 0;                                                                   \
+            }                                                                               \
+            else                                                                            \
+            {                                                                               \
+                pos = ZVEC_ATOMIC_LOAD_RELAXED(&q->dequeue_pos);                            \
+            }                                                                               \
+        }                                                                                   \
+        *out = q->buf.data[pos & q->mask];                                                  \
+        ZVEC_ATOMIC_STORE(&q->seq[pos & q->mask], pos + q->mask + 1);                       \
+        return 1;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    /* Returns 1 if pushed, 0 if the queue is full. Never blocks. */                        \
+    static inline int zvec_mpmc_try_push_##Name(zvec_mpmc_##Name *q, T value)               \
+    {                                                                                       \
+        if (!zvec_mpmc_enqueue_impl_##Name(q, value))                                       \
+        {                                                                                   \
+            return 0;                                                                       \
+        }                                                                                   \
+        zvec_mpmc_wake_impl_##Name(q, &q->pop_waiters, &q->not_empty);                      \
+        return 1;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    /* Returns 1 and stores the oldest element in *out, or 0 if empty. Never blocks. */     \
+    static inline int zvec_mpmc_try_pop_##Name(zvec_mpmc_##Name *q, T *out)                 \
+    {                                                                                       \
+        if (!zvec_mpmc_dequeue_impl_##Name(q, out))                                         \
+        {                                                                                   \
+            return 0;                                                                       \
+        }                                                                                   \
+        zvec_mpmc_wake_impl_##Name(q, &q->push_waiters, &q->not_full);                      \
+        return 1;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    /* Pushes items in order until the queue is full; returns how many were pushed. */      \
+    static inline size_t zvec_mpmc_try_push_n_##Name(zvec_mpmc_##Name *q, const T *items,   \
+                                                     size_t count)                          \
+    {                                                                                       \
+        size_t n = 0;                                                                       \
+        while (n < count && zvec_mpmc_try_push_##Name(q, items[n]))                         \
+        {                                                                                   \
+            n++;                                                                            \
+        }                                                                                   \
+        return n;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    /* Pops up to 'count' items into 'out' without blocking; returns how many. */           \
+    static inline size_t zvec_mpmc_try_pop_n_##Name(zvec_mpmc_##Name *q, T *out,            \
+                                                    size_t count)                           \
+    {                                                                                       \
+        size_t n = 0;                                                                       \
+        while (n < count && zvec_mpmc_try_pop_##Name(q, &out[n]))                           \
+        {                                                                                   \
+            n++;                                                                            \
+        }                                                                                   \
+        return n;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    /* Blocks while full. Returns 1 once pushed, 0 if the queue was closed. */              \
+    static inline int zvec_mpmc_push_##Name(zvec_mpmc_##Name *q, T value)                   \
+    {                                                                                       \
+        int spins;                                                                          \
+        for (spins = 0; spins < ZVEC_SPIN_LIMIT; ++spins)                                   \
+        {                                                                                   \
+            if (ZVEC_ATOMIC_LOAD(&q->closed))                                               \
+            {                                                                               \
+                return 0;                                                                   \
+            }                                                                               \
+            if (zvec_mpmc_try_push_##Name(q, value))                                        \
+            {                                                                               \
+                return 1;                                                                   \
+            }                                                                               \
+            ZVEC_CPU_RELAX();                                                               \
+        }                                                                                   \
+        pthread_mutex_lock(&q->lock);                                                       \
+        __atomic_fetch_add(&q->push_waiters, 1, __ATOMIC_SEQ_CST);                          \
+        for (;;)                                                                            \
+        {                                                                                   \
+            if (ZVEC_ATOMIC_LOAD(&q->closed))                                               \
+            {                                                                               \
+                break;                                                                      \
+            }                                                                               \
+            if (zvec_mpmc_enqueue_impl_##Name(q, value))                                    \
+            {                                                                               \
+                __atomic_fetch_sub(&q->push_waiters, 1, __ATOMIC_SEQ_CST);                  \
+                pthread_mutex_unlock(&q->lock);                                             \
+                zvec_mpmc_wake_impl_##Name(q, &q->pop_waiters, &q->not_empty);              \
+                return 1;                                                                   \
+            }                                                                               \
+            pthread_cond_wait(&q->not_full, &q->lock);                                      \
+        }                                                                                   \
+        __atomic_fetch_sub(&q->push_waiters, 1, __ATOMIC_SEQ_CST);                          \
+        pthread_mutex_unlock(&q->lock);                                                     \
+        return 0;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    /* Blocks while empty. Returns 1 with *out set, or 0 once closed and drained. */        \
+    static inline int zvec_mpmc_pop_##Name(zvec_mpmc_##Name *q, T *out)                     \
+    {                                                                                       \
+        int spins;                                                                          \
+        for (spins = 0; spins < ZVEC_SPIN_LIMIT; ++spins)                                   \
+        {                                                                                   \
+            if (zvec_mpmc_try_pop_##Name(q, out))                                           \
+            {                                                                               \
+                return 1;                                                                   \
+            }                                                                               \
+            ZVEC_CPU_RELAX();                                                               \
+        }                                                                                   \
+        pthread_mutex_lock(&q->lock);                                                       \
+        __atomic_fetch_add(&q->pop_waiters, 1, __ATOMIC_SEQ_CST);                           \
+        for (;;)                                                                            \
+        {                                                                                   \
+            if (zvec_mpmc_dequeue_impl_##Name(q, out))                                      \
+            {                                                                               \
+                __atomic_fetch_sub(&q->pop_waiters, 1, __ATOMIC_SEQ_CST);                   \
+                pthread_mutex_unlock(&q->lock);                                             \
+                zvec_mpmc_wake_impl_##Name(q, &q->push_waiters, &q->not_full);              \
+                return 1;                                                                   \
+            }                                                                               \
+            if (ZVEC_ATOMIC_LOAD(&q->closed))                                               \
+            {                                                                               \
+                break;                                                                      \
+            }                                                                               \
+            pthread_cond_wait(&q->not_empty, &q->lock);                                     \
+        }                                                                                   \
+        __atomic_fetch_sub(&q->pop_waiters, 1, __ATOMIC_SEQ_CST);                           \
+        pthread_mutex_unlock(&q->lock);                                                     \
+        return 0;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    /* Blocks until at least one item is available, then pops up to 'count'. */             \
+    static inline size_t zvec_mpmc_pop_n_##Name(zvec_mpmc_##Name *q, T *out, size_t count)  \
+    {                                                                                       \
+        if (0 == count || !zvec_mpmc_pop_##Name(q, out))                                    \
+        {                                                                                   \
+            return 0;                                                                       \
+        }                                                                                   \
+        return 1 + zvec_mpmc_try_pop_n_##Name(q, out + 1, count - 1);                       \
+    }                                                                                       \
+                                                                                            \
+    /* Wakes every blocked thread; later blocking pushes fail and pops drain. */            \
+    static inline void zvec_mpmc_close_##Name(zvec_mpmc_##Name *q)                          \
+    {                                                                                       \
+        pthread_mutex_lock(&q->lock);                                                       \
+        ZVEC_ATOMIC_STORE(&q->closed, 1);                                                   \
+        pthread_cond_broadcast(&q->not_empty);                                              \
+        pthread_cond_broadcast(&q->not_full);                                               \
+        pthread_mutex_unlock(&q->lock);                                                     \
+    }                                                                                       \
+                                                                                            \
+    /* Approximate number of queued elements. */                                            \
+    static inline size_t zvec_mpmc_size_##Name(zvec_mpmc_##Name *q)                         \
+    {                                                                                       \
+        size_t d = ZVEC_ATOMIC_LOAD(&q->dequeue_pos);                                       \
+        size_t e = ZVEC_ATOMIC_LOAD(&q->enqueue_pos);                                       \
+        return e > d ? e - d : 0;                                                           \
+    }
+
+
+/*
+ * zvec_deque_##Name: growable Chase-Lev work-stealing deque.
+ *
+ * The owner pushes and pops at the bottom without atomics on the fast path;
+ * thieves take from the top with a CAS, and only the last element is raced.
+ * The ring is a zvec_##Name reserved through zvec_reserve_##Name. Growing
+ * copies the live range into a buffer twice as large; the old one is retired
+ * and freed once no thief is inside steal(), or at zvec_deque_free.
+ *
+ * As in every Chase-Lev deque, a slow thief may copy a slot the owner is
+ * overwriting; it then loses the CAS on 'top' and discards the copy.
+ */
+#define ZVEC_GEN_DEQUE_IMPL(T, Name)                                                        \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        zvec_##Name *buf;                                                                   \
+        zvec_##Name **retired;                                                              \
+        size_t retired_len;                                                                 \
+        size_t retired_cap;                                                                 \
+        char pad0[ZVEC_CACHE_LINE];                                                         \
+        ptrdiff_t top;                                                                      \
+        char pad1[ZVEC_CACHE_LINE - sizeof(ptrdiff_t)];                                     \
+        ptrdiff_t bottom;                                                                   \
+        char pad2[ZVEC_CACHE_LINE - sizeof(ptrdiff_t)];                                     \
+        int thieves;                                                                        \
+        char pad3[ZVEC_CACHE_LINE - sizeof(int)];                                           \
+    } zvec_deque_##Name;                                                                    \
+                                                                                            \
+    static inline zvec_##Name *zvec_deque_buf_new_impl_##Name(size_t cap)                   \
+    {                                                                                       \
+        zvec_##Name *b = (zvec_##Name *)ZVEC_MALLOC(sizeof(zvec_##Name));                   \
+        if (!b)                                                                             \
+        {                                                                                   \
+            return NULL;                                                                    \
+        }                                                                                   \
+        memset(b, 0, sizeof(zvec_##Name));                                                  \
+        if (Z_OK != zvec_reserve_##Name(b, cap))                                            \
+        {                                                                                   \
+            ZVEC_FREE(b);                                                                   \
+            return NULL;                                                                    \
+        }                                                                                   \
+        return b;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_deque_buf_free_impl_##Name(zvec_##Name *b)                      \
+    {                                                                                       \
+        zvec_free_##Name(b);                                                                \
+        ZVEC_FREE(b);                                                                       \
+    }                                                                                       \
+                                                                                            \
+    /* Capacity is rounded up to a power of two; the deque grows on demand. */              \
+    static inline int zvec_deque_init_##Name(zvec_deque_##Name *d, size_t capacity)         \
+    {                                                                                       \
+        size_t cap = 2;                                                                     \
+        memset(d, 0, sizeof(zvec_deque_##Name));                                            \
+        while (cap < capacity)                                                              \
+        {                                                                                   \
+            cap <<= 1;                                                                      \
+        }                                                                                   \
+        d->buf = zvec_deque_buf_new_impl_##Name(cap);                                       \
+        return d->buf ? Z_OK : Z_ENOMEM;                                                    \
+    }                                                                                       \
+                                                                                            \
+    /* Must only be called once every thread is done with the deque. */                     \
+    static inline void zvec_deque_free_##Name(zvec_deque_##Name *d)                         \
+    {                                                                                       \
+        size_t i;                                                                           \
+        for (i = 0; i < d->retired_len; ++i)                                                \
+        {                                                                                   \
+            zvec_deque_buf_free_impl_##Name(d->retired[i]);                                 \
+        }                                                                                   \
+        ZVEC_FREE(d->retired);                                                              \
+        if (d->buf)                                                                         \
+        {                                                                                   \
+            zvec_deque_buf_free_impl_##Name(d->buf);                                        \
+        }                                                                                   \
+        memset(d, 0, sizeof(zvec_deque_##Name));                                            \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Frees retired buffers if no thief is inside steal(). A thief registers               \
+     * before loading 'buf', so once the owner has published the new buffer and             \
+     * then sees zero thieves, nobody can still be reading an old one.                      \
+     */                                                                                     \
+    static inline void zvec_deque_reclaim_impl_##Name(zvec_deque_##Name *d)                 \
+    {                                                                                       \
+        size_t i;                                                                           \
+        if (0 == d->retired_len || __atomic_load_n(&d->thieves, __ATOMIC_SEQ_CST) != 0)     \
+        {                                                                                   \
+            return;                                                                         \
+        }                                                                                   \
+        for (i = 0; i < d->retired_len; ++i)                                                \
+        {                                                                                   \
+            zvec_deque_buf_free_impl_##Name(d->retired[i]);                                 \
+        }                                                                                   \
+        d->retired_len = 0;                                                                 \
+    }                                                                                       \
+                                                                                            \
+    /* Owner only: doubles the ring, copying the live range [t, b). */                      \
+    static inline int zvec_deque_grow_impl_##Name(zvec_deque_##Name *d, ptrdiff_t t,        \
+                                                  ptrdiff_t b)                              \
+    {                                                                                       \
+        zvec_##Name *old = d->buf;                                                          \
+        zvec_##Name *fresh;                                                                 \
+        size_t old_mask = old->capacity - 1;                                                \
+        size_t new_mask;                                                                    \
+        ptrdiff_t i;                                                                        \
+        if (d->retired_len == d->retired_cap)                                               \
+        {                                                                                   \
+            size_t cap = d->retired_cap ? d->retired_cap * 2 : 8;                           \
+            zvec_##Name **r = (zvec_##Name **)ZVEC_REALLOC(d->retired,                      \
+                                                           cap * sizeof(zvec_##Name *));    \
+            if (!r)                                                                         \
+            {                                                                               \
+                return Z_ENOMEM;                                                            \
+            }                                                                               \
+            d->retired = r;                                                                 \
+            d->retired_cap = cap;                                                           \
+        }                                                                                   \
+        fresh = zvec_deque_buf_new_impl_##Name(old->capacity * 2);                          \
+        if (!fresh)                                                                         \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        new_mask = fresh->capacity - 1;                                                     \
+        for (i = t; i < b; ++i)                                                             \
+        {                                                                                   \
+            fresh->data[(size_t)i & new_mask] = old->data[(size_t)i & old_mask];            \
+        }                                                                                   \
+        __atomic_store_n(&d->buf, fresh, __ATOMIC_SEQ_CST);                                 \
+        d->retired[d->retired_len++] = old;                                                 \
+        zvec_deque_reclaim_impl_##Name(d);                                                  \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Owner only: pushes at the bottom. Returns Z_OK or Z_ENOMEM. */                       \
+    static inline int zvec_deque_push_##Name(zvec_deque_##Name *d, T value)                 \
+    {                                                                                       \
+        ptrdiff_t b = ZVEC_ATOMIC_LOAD_RELAXED(&d->bottom);                                 \
+        ptrdiff_t t = ZVEC_ATOMIC_LOAD(&d->top);                                            \
+        zvec_##Name *buf = d->buf;                                                          \
+        if ((size_t)(b - t) >= buf->capacity)                                               \
+        {                                                                                   \
+            if (Z_OK != zvec_deque_grow_impl_##Name(d, t, b))                               \
+            {                                                                               \
+                return Z_ENOMEM;                                                            \
+            }                                                                               \
+            buf = d->buf;                                                                   \
+        }                                                                                   \
+        else if (d->retired_len)                                                            \
+        {                                                                                   \
+            zvec_deque_reclaim_impl_##Name(d);                                              \
+        }                                                                                   \
+        buf->data[(size_t)b & (buf->capacity - 1)] = value;                                 \
+        ZVEC_ATOMIC_STORE(&d->bottom, b + 1);                                               \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Owner only: pops the most recently pushed element (LIFO). Returns 1 or 0. */         \
+    static inline int zvec_deque_pop_##Name(zvec_deque_##Name *d, T *out)                   \
+    {                                                                                       \
+        ptrdiff_t b = ZVEC_ATOMIC_LOAD_RELAXED(&d->bottom) - 1;                             \
+        zvec_##Name *buf = d->buf;                                                          \
+        ptrdiff_t t;                                                                        \
+        int ok = 1;                                                                         \
+        __atomic_store_n(&d->bottom, b, __ATOMIC_SEQ_CST);                                  \
+        t = __atomic_load_n(&d->top, __ATOMIC_SEQ_CST);                                     \
+        if (t > b)                                                                          \
+        {                                                                                   \
+            ZVEC_ATOMIC_STORE(&d->bottom, b + 1);                                           \
+            return 0;                                                                       \
+        }                                                                                   \
+        *out = buf->data[(size_t)b & (buf->capacity - 1)];                                  \
+        if (t == b)                                                                         \
+        {                                                                                   \
+            /* Last element: race the thieves for it. */                                    \
+            ok = __atomic_compare_exchange_n(&d->top, &t, t + 1, 0, __ATOMIC_SEQ_CST,       \
+                                             __ATOMIC_RELAXED);                             \
+            ZVEC_ATOMIC_STORE(&d->bottom, b + 1);                                           \
+        }                                                                                   \
+        return ok;                                                                          \
+    }                                                                                       \
+                                                                                            \
+    /* Any thread: steals the oldest element (FIFO). Returns 1, or 0 if empty. */           \
+    static inline int zvec_deque_steal_##Name(zvec_deque_##Name *d, T *out)                 \
+    {                                                                                       \
+        int ok = 0;                                                                         \
+        __atomic_fetch_add(&d->thieves, 1, __ATOMIC_SEQ_CST);                               \
+        for (;;)                                                                            \
+        {                                                                                   \
+            ptrdiff_t t = __atomic_load_n(&d->top, __ATOMIC_SEQ_CST);                       \
+            ptrdiff_t b = __atomic_load_n(&d->bottom, __ATOMIC_SEQ_CST);                    \
+            zvec_##Name *buf;                                                               \
+            T value;                                                                        \
+            if (t >= b)                                                                     \
+            {                                                                               \
+                break;                                                                      \
+            }                                                                               \
+            buf = __atomic_load_n(&d->buf, __ATOMIC_SEQ_CST);                               \
+            value = buf->data[(size_t)t & (buf->capacity - 1)];                             \
+            if (__atomic_compare_exchange_n(&d->top, &t, t + 1, 0, __ATOMIC_SEQ_CST,        \
+                                            __ATOMIC_RELAXED))                              \
+            {                                                                               \
+                *out = value;                                                               \
+                ok = 1;                                                                     \
+                break;                                                                      \
+            }                                                                               \
+            ZVEC_CPU_RELAX();                                                               \
+        }                                                                                   \
+        __atomic_fetch_sub(&d->thieves, 1, __ATOMIC_RELEASE);                               \
+        return ok;                                                                          \
+    }                                                                                       \
+                                                                                            \
+    /* Approximate number of queued elements. */                                            \
+    static inline size_t zvec_deque_size_##Name(zvec_deque_##Name *d)                       \
+    {                                                                                       \
+        ptrdiff_t b = ZVEC_ATOMIC_LOAD(&d->bottom);                                         \
+        ptrdiff_t t = ZVEC_ATOMIC_LOAD(&d->top);                                            \
+        return b > t ? (size_t)(b - t) : 0;                                                 \
+    }
+
+
+/*
+ * zvec_par_*_##Name: parallel for-each / transform / reduce on the shared pool.
+ */
+#define ZVEC_GEN_PAR_IMPL(T, Name)                                                          \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        T *data;                                                                            \
+        const T *src;                                                                       \
+        void (*each)(T *, void *);                                                          \
+        void (*xform)(T *, const T *);                                                      \
+        T (*map)(const T *);                                                                \
+        T (*combine)(T, T);                                                                 \
+        void *user;                                                                         \
+        T *partials;                                                                        \
+        size_t chunk;                                                                       \
+        size_t skew;                                                                        \
+    } zvec_par_ctx_##Name;                                                                  \
+                                                                                            \
+    static inline void zvec_par_foreach_body_##Name(void *ctx, size_t begin, size_t end)    \
+    {                                                                                       \
+        zvec_par_ctx_##Name *c = (zvec_par_ctx_##Name *)ctx;                                \
+        size_t i;                                                                           \
+        for (i = begin; i < end; ++i)                                                       \
+        {                                                                                   \
+            c->each(&c->data[i], c->user);                                                  \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_par_transform_body_##Name(void *ctx, size_t begin, size_t end)  \
+    {                                                                                       \
+        zvec_par_ctx_##Name *c = (zvec_par_ctx_##Name *)ctx;                                \
+        size_t i;                                                                           \
+        for (i = begin; i < end; ++i)                                                       \
+        {                                                                                   \
+            c->xform(&c->data[i], &c->src[i]);                                              \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_par_reduce_body_##Name(void *ctx, size_t begin, size_t end)     \
+    {                                                                                       \
+        zvec_par_ctx_##Name *c = (zvec_par_ctx_##Name *)ctx;                                \
+        T acc = c->map(&c->src[begin]);                                                     \
+        size_t i;                                                                           \
+        for (i = begin + 1; i < end; ++i)                                                   \
+        {                                                                                   \
+            acc = c->combine(acc, c->map(&c->src[i]));                                      \
+        }                                                                                   \
+        c->partials[(begin + c->skew) / c->chunk] = acc;                                    \
+    }                                                                                       \
+                                                                                            \
+    /* Calls fn(&elem, ctx) for every element, in parallel and in no particular order. */   \
+    static inline void zvec_par_foreach_##Name(zvec_##Name *v, void (*fn)(T *, void *),     \
+                                               void *ctx)                                   \
+    {                                                                                       \
+        zvec_par_ctx_##Name c;                                                              \
+        memset(&c, 0, sizeof(c));                                                           \
+        c.data = v->data;                                                                   \
+        c.each = fn;                                                                        \
+        c.user = ctx;                                                                       \
+        c.skew = ZVEC_PAR_SKEW(v->data, sizeof(T));                                         \
+        c.chunk = zvec_par_chunk_impl(v->length, ZVEC_PAR_ALIGN(sizeof(T)));                \
+        zvec_par_run_impl(v->length, c.chunk, c.skew, zvec_par_foreach_body_##Name, &c);    \
+    }                                                                                       \
+                                                                                            \
+    /* Resizes dst to src's length and sets dst[i] via fn(&dst[i], &src[i]). */             \
+    static inline int zvec_par_transform_##Name(zvec_##Name *dst, const zvec_##Name *src,   \
+                                                void (*fn)(T *, const T *))                 \
+    {                                                                                       \
+        zvec_par_ctx_##Name c;                                                              \
+        assert(dst != src);                                                                 \
+        if (Z_OK != zvec_reserve_##Name(dst, src->length))                                  \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        dst->length = src->length;                                                          \
+        memset(&c, 0, sizeof(c));                                                           \
+        c.data = dst->data;                                                                 \
+        c.src = src->data;                                                                  \
+        c.xform = fn;                                                                       \
+        c.skew = ZVEC_PAR_SKEW(dst->data, sizeof(T));                                       \
+        c.chunk = zvec_par_chunk_impl(src->length, ZVEC_PAR_ALIGN(sizeof(T)));              \
+        zvec_par_run_impl(src->length, c.chunk, c.skew, zvec_par_transform_body_##Name,     \
+                          &c);                                                              \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Returns combine(...combine(init, map(&v[0]))..., map(&v[n - 1])). Chunk              \
+     * results are combined left to right, so 'combine' must be associative but             \
+     * need not be commutative.                                                             \
+     */                                                                                     \
+    static inline T zvec_par_reduce_##Name(const zvec_##Name *v, T init,                    \
+                                           T (*map)(const T *), T (*combine)(T, T))         \
+    {                                                                                       \
+        zvec_par_ctx_##Name c;                                                              \
+        size_t i, count;                                                                    \
+        memset(&c, 0, sizeof(c));                                                           \
+        c.src = v->data;                                                                    \
+        c.map = map;                                                                        \
+        c.combine = combine;                                                                \
+        c.skew = ZVEC_PAR_SKEW(v->data, sizeof(T));                                         \
+        c.chunk = zvec_par_chunk_impl(v->length, ZVEC_PAR_ALIGN(sizeof(T)));                \
+        count = zvec_par_count_impl(v->length, c.chunk, c.skew);                            \
+        c.partials = count > 1 ? (T *)ZVEC_MALLOC(count * sizeof(T)) : NULL;                \
+        if (!c.partials)                                                                    \
+        {                                                                                   \
+            for (i = 0; i < v->length; ++i)                                                 \
+            {                                                                               \
+                init = combine(init, map(&v->data[i]));                                     \
+            }                                                                               \
+            return init;                                                                    \
+        }                                                                                   \
+        zvec_par_run_impl(v->length, c.chunk, c.skew, zvec_par_reduce_body_##Name, &c);     \
+        for (i = 0; i < count; ++i)                                                         \
+        {                                                                                   \
+            init = combine(init, c.partials[i]);                                            \
+        }                                                                                   \
+        ZVEC_FREE(c.partials);                                                              \
+        return init;                                                                        \
+    }
+
+
+/*
+ * zvec_rcu_##Name: read-copy-update vector.
+ *
+ * Readers take a (data, length) snapshot inside an epoch read section and
+ * never block. One writer appends in place or edits a private draft and
+ * publishes it with a single pointer store; replaced versions are retired to
+ * the embedded zvec_epoch and freed once no reader can hold them.
+ */
+#define ZVEC_GEN_RCU_IMPL(T, Name)                                                          \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        const T *data;                                                                      \
+        size_t length;                                                                      \
+    } zvec_rcu_snap_##Name;                                                                 \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        zvec_##Name *cur;                                                                   \
+        zvec_##Name draft;                                                                  \
+        int editing;                                                                        \
+        zvec_epoch epoch;                                                                   \
+    } zvec_rcu_##Name;                                                                      \
+                                                                                            \
+    static inline void zvec_rcu_ver_free_##Name(void *p)                                    \
+    {                                                                                       \
+        zvec_free_##Name((zvec_##Name *)p);                                                 \
+        ZVEC_FREE(p);                                                                       \
+    }                                                                                       \
+                                                                                            \
+    static inline zvec_##Name *zvec_rcu_ver_new_impl_##Name(size_t cap)                     \
+    {                                                                                       \
+        zvec_##Name *v = (zvec_##Name *)ZVEC_MALLOC(sizeof(zvec_##Name));                   \
+        if (!v)                                                                             \
+        {                                                                                   \
+            return NULL;                                                                    \
+        }                                                                                   \
+        memset(v, 0, sizeof(zvec_##Name));                                                  \
+        if (cap && Z_OK != zvec_reserve_##Name(v, cap))                                     \
+        {                                                                                   \
+            ZVEC_FREE(v);                                                                   \
+            return NULL;                                                                    \
+        }                                                                                   \
+        return v;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_rcu_init_##Name(zvec_rcu_##Name *r)                              \
+    {                                                                                       \
+        memset(r, 0, sizeof(zvec_rcu_##Name));                                              \
+        zvec_epoch_init(&r->epoch);                                                         \
+        r->cur = zvec_rcu_ver_new_impl_##Name(0);                                           \
+        return r->cur ? Z_OK : Z_ENOMEM;                                                    \
+    }                                                                                       \
+                                                                                            \
+    /* Must only be called once every reader has unregistered. */                           \
+    static inline void zvec_rcu_free_##Name(zvec_rcu_##Name *r)                             \
+    {                                                                                       \
+        zvec_epoch_free(&r->epoch);                                                         \
+        if (r->cur)                                                                         \
+        {                                                                                   \
+            zvec_rcu_ver_free_##Name(r->cur);                                               \
+        }                                                                                   \
+        zvec_free_##Name(&r->draft);                                                        \
+        memset(r, 0, sizeof(zvec_rcu_##Name));                                              \
+    }                                                                                       \
+                                                                                            \
+    /* Reader: returns a slot for read_lock / read_unlock, or -1 if none is free. */        \
+    static inline int zvec_rcu_register_##Name(zvec_rcu_##Name *r)                          \
+    {                                                                                       \
+        return zvec_epoch_register(&r->epoch);                                              \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_rcu_unregister_##Name(zvec_rcu_##Name *r, int slot)             \
+    {                                                                                       \
+        zvec_epoch_unregister(&r->epoch, slot);                                             \
+    }                                                                                       \
+                                                                                            \
+    /* Reader: returns an immutable snapshot that stays valid until read_unlock. */         \
+    static inline zvec_rcu_snap_##Name zvec_rcu_read_lock_##Name(zvec_rcu_##Name *r,        \
+                                                                 int slot)                  \
+    {                                                                                       \
+        zvec_rcu_snap_##Name s;                                                             \
+        zvec_##Name *v;                                                                     \
+        zvec_epoch_enter(&r->epoch, slot);                                                  \
+        v = __atomic_load_n(&r->cur, __ATOMIC_SEQ_CST);                                     \
+        s.data = v->data;                                                                   \
+        s.length = ZVEC_ATOMIC_LOAD(&v->length);                                            \
+        return s;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_rcu_read_unlock_##Name(zvec_rcu_##Name *r, int slot)            \
+    {                                                                                       \
+        zvec_epoch_exit(&r->epoch, slot);                                                   \
+    }                                                                                       \
+                                                                                            \
+    /* Writer: swaps in 'next' and retires the version readers may still hold. */           \
+    static inline void zvec_rcu_swap_impl_##Name(zvec_rcu_##Name *r, zvec_##Name *next)     \
+    {                                                                                       \
+        zvec_##Name *old = r->cur;                                                          \
+        __atomic_store_n(&r->cur, next, __ATOMIC_SEQ_CST);                                  \
+        zvec_epoch_retire(&r->epoch, old, zvec_rcu_ver_free_##Name);                        \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Writer: appends 'count' items. While the open draft is unused and the                \
+     * published buffer has room, elements are written past the published                   \
+     * length (no reader looks there) and then made visible with one release                \
+     * store, so appends never copy. Otherwise the buffer is regrown into a new             \
+     * version.                                                                             \
+     */                                                                                     \
+    static inline int zvec_rcu_extend_##Name(zvec_rcu_##Name *r, const T *items,            \
+                                             size_t count)                                  \
+    {                                                                                       \
+        zvec_##Name *cur = r->cur;                                                          \
+        zvec_##Name *next;                                                                  \
+        size_t i, new_cap, len = cur->length;                                               \
+        if (r->editing)                                                                     \
+        {                                                                                   \
+            return zvec_extend_##Name(&r->draft, items, count);                             \
+        }                                                                                   \
+        if (count <= cur->capacity - len)                                                   \
+        {                                                                                   \
+            for (i = 0; i < count; ++i)                                                     \
+            {                                                                               \
+                cur->data[len + i] = items[i];                                              \
+            }                                                                               \
+            ZVEC_ATOMIC_STORE(&cur->length, len + count);                                   \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+        new_cap = cur->capacity ? cur->capacity : Z_GROWTH_FACTOR(0);                       \
+        while (new_cap < len + count)                                                       \
+        {                                                                                   \
+            new_cap = Z_GROWTH_FACTOR(new_cap);                                             \
+        }                                                                                   \
+        next = zvec_rcu_ver_new_impl_##Name(new_cap);                                       \
+        if (!next)                                                                          \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        zvec_extend_##Name(next, cur->data, len);                                           \
+        zvec_extend_##Name(next, items, count);                                             \
+        zvec_rcu_swap_impl_##Name(r, next);                                                 \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_rcu_push_##Name(zvec_rcu_##Name *r, T value)                     \
+    {                                                                                       \
+        return zvec_rcu_extend_##Name(r, &value, 1);                                        \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Writer: returns a private copy of the current contents to mutate with                \
+     * the regular zvec API. Readers keep seeing the old version until                      \
+     * zvec_rcu_publish. Returns NULL on allocation failure.                                \
+     */                                                                                     \
+    static inline zvec_##Name *zvec_rcu_edit_##Name(zvec_rcu_##Name *r)                     \
+    {                                                                                       \
+        if (!r->editing)                                                                    \
+        {                                                                                   \
+            r->draft.length = 0;                                                            \
+            if (Z_OK != zvec_extend_##Name(&r->draft, r->cur->data, r->cur->length))        \
+            {                                                                               \
+                return NULL;                                                                \
+            }                                                                               \
+            r->editing = 1;                                                                 \
+        }                                                                                   \
+        return &r->draft;                                                                   \
+    }                                                                                       \
+                                                                                            \
+    /* Writer: publishes the draft (adopting its buffer) and retires the old version. */    \
+    static inline int zvec_rcu_publish_##Name(zvec_rcu_##Name *r)                           \
+    {                                                                                       \
+        zvec_##Name *next;                                                                  \
+        if (!r->editing)                                                                    \
+        {                                                                                   \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+        next = zvec_rcu_ver_new_impl_##Name(0);                                             \
+        if (!next)                                                                          \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        *next = r->draft;                                                                   \
+        memset(&r->draft, 0, sizeof(zvec_##Name));                                          \
+        r->editing = 0;                                                                     \
+        zvec_rcu_swap_impl_##Name(r, next);                                                 \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Writer: drops the draft without publishing it. */                                    \
+    static inline void zvec_rcu_discard_##Name(zvec_rcu_##Name *r)                          \
+    {                                                                                       \
+        r->draft.length = 0;                                                                \
+        r->editing = 0;                                                                     \
+    }                                                                                       \
+                                                                                            \
+    /* Writer: blocks until every retired version has been freed. */                        \
+    static inline void zvec_rcu_synchronize_##Name(zvec_rcu_##Name *r)                      \
+    {                                                                                       \
+        zvec_epoch_synchronize(&r->epoch);                                                  \
+    }
+
+
+/*
+ * zvec_local_##Name / zvec_combine_into_##Name: thread-local staging buffers.
+ *
+ * Each thread appends to its own zvec_##Name (found through a __thread pointer,
+ * registered once on a lock-free list) with no synchronization at all. A
+ * collective combine concatenates them into a shared vector. Buffers of exited
+ * threads keep their contents and are handed to the next thread that asks.
+ */
+#define ZVEC_GEN_LOCAL_IMPL(T, Name)                                                        \
+                                                                                            \
+    typedef struct zvec_local_node_##Name                                                   \
+    {                                                                                       \
+        zvec_##Name buf;                                                                    \
+        struct zvec_local_node_##Name *next;                                                \
+        int owned;                                                                          \
+        char pad[ZVEC_CACHE_LINE];                                                          \
+    } zvec_local_node_##Name;                                                               \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        const T *src;                                                                       \
+        size_t start;                                                                       \
+    } zvec_local_piece_##Name;                                                              \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        T *dst;                                                                             \
+        const zvec_local_piece_##Name *pieces;                                              \
+        size_t count;                                                                       \
+    } zvec_local_copy_##Name;                                                               \
+                                                                                            \
+    static zvec_local_node_##Name *zvec_local_head_##Name = NULL;                           \
+    static __thread zvec_local_node_##Name *zvec_local_self_##Name = NULL;                  \
+    static pthread_key_t zvec_local_key_##Name;                                             \
+    static pthread_once_t zvec_local_once_##Name = PTHREAD_ONCE_INIT;                       \
+                                                                                            \
+    /* Thread exit: the buffer keeps its data but can be adopted by a new thread. */        \
+    static void zvec_local_exit_impl_##Name(void *p)                                        \
+    {                                                                                       \
+        ZVEC_ATOMIC_STORE(&((zvec_local_node_##Name *)p)->owned, 0);                        \
+    }                                                                                       \
+                                                                                            \
+    static void zvec_local_key_impl_##Name(void)                                            \
+    {                                                                                       \
+        pthread_key_create(&zvec_local_key_##Name, zvec_local_exit_impl_##Name);            \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Returns the calling thread's staging buffer, or NULL on allocation                   \
+     * failure. Appending to it needs no synchronization.                                   \
+     */                                                                                     \
+    static inline zvec_##Name *zvec_local_##Name(void)                                      \
+    {                                                                                       \
+        zvec_local_node_##Name *n = zvec_local_self_##Name;                                 \
+        if (n)                                                                              \
+        {                                                                                   \
+            return &n->buf;                                                                 \
+        }                                                                                   \
+        pthread_once(&zvec_local_once_##Name, zvec_local_key_impl_##Name);                  \
+        for (n = ZVEC_ATOMIC_LOAD(&zvec_local_head_##Name); n; n = n->next)                 \
+        {                                                                                   \
+            int expected = 0;                                                               \
+            if (ZVEC_ATOMIC_CAS(&n->owned, &expected, 1))                                   \
+            {                                                                               \
+                break;                                                                      \
+            }                                                                               \
+        }                                                                                   \
+        if (!n)                                                                             \
+        {                                                                                   \
+            n = (zvec_local_node_##Name *)ZVEC_CALLOC(1, sizeof(zvec_local_node_##Name));   \
+            if (!n)                                                                         \
+            {                                                                               \
+                return NULL;                                                                \
+            }                                                                               \
+            n->owned = 1;                                                                   \
+            n->next = ZVEC_ATOMIC_LOAD(&zvec_local_head_##Name);                            \
+            while (!ZVEC_ATOMIC_CAS(&zvec_local_head_##Name, &n->next, n))                  \
+            {                                                                               \
+            }                                                                               \
+        }                                                                                   \
+        pthread_setspecific(zvec_local_key_##Name, n);                                      \
+        zvec_local_self_##Name = n;                                                         \
+        return &n->buf;                                                                     \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_local_copy_body_##Name(void *ctx, size_t begin, size_t end)     \
+    {                                                                                       \
+        zvec_local_copy_##Name *c = (zvec_local_copy_##Name *)ctx;                          \
+        size_t lo = 0, hi = c->count;                                                       \
+        /* Last piece starting at or before 'begin'. */                                     \
+        while (hi - lo > 1)                                                                 \
+        {                                                                                   \
+            size_t mid = lo + (hi - lo) / 2;                                                \
+            if (c->pieces[mid].start <= begin)                                              \
+            {                                                                               \
+                lo = mid;                                                                   \
+            }                                                                               \
+            else                                                                            \
+            {                                                                               \
+                hi = mid;                                                                   \
+            }                                                                               \
+        }                                                                                   \
+        while (begin < end)                                                                 \
+        {                                                                                   \
+            const zvec_local_piece_##Name *p = &c->pieces[lo];                              \
+            size_t stop = (lo + 1 < c->count) ? c->pieces[lo + 1].start : end;              \
+            if (stop > end)                                                                 \
+            {                                                                               \
+                stop = end;                                                                 \
+            }                                                                               \
+            memcpy(c->dst + begin, p->src + (begin - p->start),                             \
+                   (stop - begin) * sizeof(T));                                             \
+            begin = stop;                                                                   \
+            lo++;                                                                           \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Appends every thread's staged elements to 'dst' and empties the staging              \
+     * buffers. Call it once producers are done (e.g. after a join or barrier).             \
+     * A single producer's buffer is adopted without copying when 'dst' is                  \
+     * empty; otherwise 'dst' is reserved once and filled by a parallel copy.               \
+     */                                                                                     \
+    static inline int zvec_combine_into_##Name(zvec_##Name *dst)                            \
+    {                                                                                       \
+        zvec_local_node_##Name *head = ZVEC_ATOMIC_LOAD(&zvec_local_head_##Name);           \
+        zvec_local_node_##Name *n, *only = NULL;                                            \
+        zvec_local_piece_##Name *pieces;                                                    \
+        zvec_local_copy_##Name c;                                                           \
+        size_t total = 0, count = 0, at;                                                    \
+        for (n = head; n; n = n->next)                                                      \
+        {                                                                                   \
+            if (n->buf.length)                                                              \
+            {                                                                               \
+                total += n->buf.length;                                                     \
+                count++;                                                                    \
+                only = n;                                                                   \
+            }                                                                               \
+        }                                                                                   \
+        if (0 == count)                                                                     \
+        {                                                                                   \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+        if (1 == count && 0 == dst->length)                                                 \
+        {                                                                                   \
+            zvec_##Name tmp = *dst;                                                         \
+            *dst = only->buf;                                                               \
+            only->buf = tmp;                                                                \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+        if (Z_OK != zvec_reserve_##Name(dst, dst->length + total))                          \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        pieces = (zvec_local_piece_##Name *)ZVEC_MALLOC(count * sizeof(*pieces));           \
+        at = 0;                                                                             \
+        count = 0;                                                                          \
+        for (n = head; n; n = n->next)                                                      \
+        {                                                                                   \
+            if (!n->buf.length)                                                             \
+            {                                                                               \
+                continue;                                                                   \
+            }                                                                               \
+            if (pieces)                                                                     \
+            {                                                                               \
+                pieces[count].src = n->buf.data;                                            \
+                pieces[count].start = at;                                                   \
+            }                                                                               \
+            else                                                                            \
+            {                                                                               \
+                memcpy(dst->data + dst->length + at, n->buf.data,                           \
+                       n->buf.length * sizeof(T));                                          \
+            }                                                                               \
+            at += n->buf.length;                                                            \
+            count++;                                                                        \
+        }                                                                                   \
+        if (pieces)                                                                         \
+        {                                                                                   \
+            size_t chunk = zvec_par_chunk_impl(total, ZVEC_PAR_ALIGN(sizeof(T)));           \
+            c.dst = dst->data + dst->length;                                                \
+            c.pieces = pieces;                                                              \
+            c.count = count;                                                                \
+            zvec_par_run_impl(total, chunk, ZVEC_PAR_SKEW(c.dst, sizeof(T)),                \
+                              zvec_local_copy_body_##Name, &c);                             \
+            ZVEC_FREE(pieces);                                                              \
+        }                                                                                   \
+        dst->length += total;                                                               \
+        for (n = head; n; n = n->next)                                                      \
+        {                                                                                   \
+            n->buf.length = 0;                                                              \
+        }                                                                                   \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Frees the storage of every staging buffer. Producers must be idle. */                \
+    static inline void zvec_local_release_##Name(void)                                      \
+    {                                                                                       \
+        zvec_local_node_##Name *n;                                                          \
+        for (n = ZVEC_ATOMIC_LOAD(&zvec_local_head_##Name); n; n = n->next)                 \
+        {                                                                                   \
+            zvec_free_##Name(&n->buf);                                                      \
+        }                                                                                   \
+    }
+
+
+/*
+ * zvec_shard_##Name: one zvec_##Name per shard (CPU or hash partition), each
+ * padded onto its own cache lines. A shard is mutated only by the thread that
+ * owns it, so pushes and removals take no locks; size, visit and gather read
+ * across all shards.
+ */
+#define ZVEC_GEN_SHARD_IMPL(T, Name)                                                        \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        zvec_##Name vec;                                                                    \
+        char pad[ZVEC_CACHE_LINE - sizeof(zvec_##Name) % ZVEC_CACHE_LINE];                  \
+    } zvec_shard_slot_##Name;                                                               \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        zvec_shard_slot_##Name *shards;                                                     \
+        void *raw;                                                                          \
+        size_t count;                                                                       \
+    } zvec_shard_##Name;                                                                    \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        zvec_shard_##Name *s;                                                               \
+        void (*fn)(size_t, zvec_##Name *, void *);                                          \
+        void *user;                                                                         \
+    } zvec_shard_visit_ctx_##Name;                                                          \
+                                                                                            \
+    /* Creates 'count' shards (0 = one per online CPU), each on its own cache lines. */     \
+    static inline int zvec_shard_init_##Name(zvec_shard_##Name *s, size_t count)            \
+    {                                                                                       \
+        memset(s, 0, sizeof(zvec_shard_##Name));                                            \
+        if (0 == count)                                                                     \
+        {                                                                                   \
+            count = zvec_cpu_count_impl();                                                  \
+        }                                                                                   \
+        s->raw = ZVEC_MALLOC(count * sizeof(zvec_shard_slot_##Name) + ZVEC_CACHE_LINE);     \
+        if (!s->raw)                                                                        \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        s->shards = (zvec_shard_slot_##Name *)(((uintptr_t)s->raw + ZVEC_CACHE_LINE - 1) &  \
+                                               ~(uintptr_t)(ZVEC_CACHE_LINE - 1));          \
+        memset(s->shards, 0, count * sizeof(zvec_shard_slot_##Name));                       \
+        s->count = count;                                                                   \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_shard_free_##Name(zvec_shard_##Name *s)                         \
+    {                                                                                       \
+        size_t k;                                                                           \
+        for (k = 0; k < s->count; ++k)                                                      \
+        {                                                                                   \
+            zvec_free_##Name(&s->shards[k].vec);                                            \
+        }                                                                                   \
+        ZVEC_FREE(s->raw);                                                                  \
+        memset(s, 0, sizeof(zvec_shard_##Name));                                            \
+    }                                                                                       \
+                                                                                            \
+    /* The calling thread's home shard: stable per thread, spread round-robin. */           \
+    static inline size_t zvec_shard_local_##Name(const zvec_shard_##Name *s)                \
+    {                                                                                       \
+        return zvec_thread_index_impl() % s->count;                                         \
+    }                                                                                       \
+                                                                                            \
+    /* Direct access to one shard for the thread that owns it. */                           \
+    static inline zvec_##Name *zvec_shard_get_##Name(zvec_shard_##Name *s, size_t shard)    \
+    {                                                                                       \
+        assert(shard < s->count);                                                           \
+        return &s->shards[shard].vec;                                                       \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Owner of 'shard' only: appends and publishes the new length (release), so            \
+     * zvec_shard_size may run concurrently.                                                \
+     */                                                                                     \
+    static inline int zvec_shard_push_##Name(zvec_shard_##Name *s, size_t shard, T value)   \
+    {                                                                                       \
+        zvec_##Name *v = zvec_shard_get_##Name(s, shard);                                   \
+        if (v->length == v->capacity &&                                                     \
+            Z_OK != zvec_reserve_##Name(v, v->capacity ? Z_GROWTH_FACTOR(v->capacity)       \
+                                                       : Z_GROWTH_FACTOR(0)))               \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        v->data[v->length] = value;                                                         \
+        ZVEC_ATOMIC_STORE(&v->length, v->length + 1);                                       \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Owner of 'shard' only: O(1) removal by moving the shard's last element. */           \
+    static inline void zvec_shard_swap_remove_##Name(zvec_shard_##Name *s, size_t shard,    \
+                                                     size_t index)                          \
+    {                                                                                       \
+        zvec_##Name *v = zvec_shard_get_##Name(s, shard);                                   \
+        assert(index < v->length);                                                          \
+        v->data[index] = v->data[v->length - 1];                                            \
+        ZVEC_ATOMIC_STORE(&v->length, v->length - 1);                                       \
+    }                                                                                       \
+                                                                                            \
+    /* Total element count (a sum of per-shard snapshots while owners mutate). */           \
+    static inline size_t zvec_shard_size_##Name(zvec_shard_##Name *s)                       \
+    {                                                                                       \
+        size_t k, total = 0;                                                                \
+        for (k = 0; k < s->count; ++k)                                                      \
+        {                                                                                   \
+            total += ZVEC_ATOMIC_LOAD(&s->shards[k].vec.length);                            \
+        }                                                                                   \
+        return total;                                                                       \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_shard_visit_body_##Name(void *ctx, size_t begin, size_t end)    \
+    {                                                                                       \
+        zvec_shard_visit_ctx_##Name *c = (zvec_shard_visit_ctx_##Name *)ctx;                \
+        size_t k;                                                                           \
+        for (k = begin; k < end; ++k)                                                       \
+        {                                                                                   \
+            c->fn(k, &c->s->shards[k].vec, c->user);                                        \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    /* Calls fn(shard, vec, ctx) for every shard in parallel on the zvec_par pool. */       \
+    static inline void zvec_shard_visit_##Name(zvec_shard_##Name *s,                        \
+                                               void (*fn)(size_t, zvec_##Name *, void *),   \
+                                               void *ctx)                                   \
+    {                                                                                       \
+        zvec_shard_visit_ctx_##Name c;                                                      \
+        c.s = s;                                                                            \
+        c.fn = fn;                                                                          \
+        c.user = ctx;                                                                       \
+        zvec_par_run_impl(s->count, 1, 0, zvec_shard_visit_body_##Name, &c);                \
+    }                                                                                       \
+                                                                                            \
+    /* Appends every shard, in shard order, to 'out'. Owners must be idle. */               \
+    static inline int zvec_shard_gather_##Name(zvec_shard_##Name *s, zvec_##Name *out)      \
+    {                                                                                       \
+        size_t k;                                                                           \
+        if (Z_OK != zvec_reserve_##Name(out, out->length + zvec_shard_size_##Name(s)))      \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        for (k = 0; k < s->count; ++k)                                                      \
+        {                                                                                   \
+            zvec_extend_##Name(out, s->shards[k].vec.data, s->shards[k].vec.length);        \
+        }                                                                                   \
+        return Z_OK;                                                                        \
+    }
+
+
+/*
+ * zvec_seq_##Name: single-writer / multi-reader append-only vector.
+ *
+ * The length is published with release stores and read with acquire loads.
+ * Growth runs inside a sequence-counter write section (odd while the buffer
+ * pointer changes), so readers take a consistent (data, length) pair without
+ * locks and retry only when they raced a reallocation. Replaced buffers are
+ * kept until zvec_seq_reclaim; with geometric growth they never add up to
+ * more than the live capacity.
+ */
+#define ZVEC_GEN_SEQ_IMPL(T, Name)                                                          \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        const T *data;                                                                      \
+        size_t length;                                                                      \
+    } zvec_seq_snap_##Name;                                                                 \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        T *data;                                                                            \
+        size_t length;                                                                      \
+        size_t capacity;                                                                    \
+        unsigned long seq;                                                                  \
+        void **retired;                                                                     \
+        size_t retired_len;                                                                 \
+        size_t retired_cap;                                                                 \
+    } zvec_seq_##Name;                                                                      \
+                                                                                            \
+    static inline void zvec_seq_init_##Name(zvec_seq_##Name *v)                             \
+    {                                                                                       \
+        memset(v, 0, sizeof(zvec_seq_##Name));                                              \
+    }                                                                                       \
+                                                                                            \
+    /* Writer: frees buffers replaced by growth. No reader may hold an older snapshot. */   \
+    static inline void zvec_seq_reclaim_##Name(zvec_seq_##Name *v)                          \
+    {                                                                                       \
+        size_t i;                                                                           \
+        for (i = 0; i < v->retired_len; ++i)                                                \
+        {                                                                                   \
+            ZVEC_FREE(v->retired[i]);                                                       \
+        }                                                                                   \
+        v->retired_len = 0;                                                                 \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_seq_free_##Name(zvec_seq_##Name *v)                             \
+    {                                                                                       \
+        zvec_seq_reclaim_##Name(v);                                                         \
+        ZVEC_FREE(v->retired);                                                              \
+        ZVEC_FREE(v->data);                                                                 \
+        memset(v, 0, sizeof(zvec_seq_##Name));                                              \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Writer: moves to a buffer of 'new_cap' elements inside a seqlock write               \
+     * section. The old buffer is retired rather than freed, so a reader that               \
+     * loaded it just before the swap still reads valid memory.                             \
+     */                                                                                     \
+    static inline int zvec_seq_reserve_##Name(zvec_seq_##Name *v, size_t new_cap)           \
+    {                                                                                       \
+        T *fresh;                                                                           \
+        unsigned long s = v->seq;                                                           \
+        if (new_cap <= v->capacity)                                                         \
+        {                                                                                   \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+        if (v->data && v->retired_len == v->retired_cap)                                    \
+        {                                                                                   \
+            size_t cap = v->retired_cap ? v->retired_cap * 2 : 8;                           \
+            void **r = (void **)ZVEC_REALLOC(v->retired, cap * sizeof(void *));             \
+            if (!r)                                                                         \
+            {                                                                               \
+                return Z_ENOMEM;                                                            \
+            }                                                                               \
+            v->retired = r;                                                                 \
+            v->retired_cap = cap;                                                           \
+        }                                                                                   \
+        fresh = (T *)ZVEC_MALLOC(new_cap * sizeof(T));                                      \
+        if (!fresh)                                                                         \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        if (v->length)                                                                      \
+        {                                                                                   \
+            memcpy(fresh, v->data, v->length * sizeof(T));                                  \
+        }                                                                                   \
+        ZVEC_ATOMIC_STORE(&v->seq, s + 1);                                                  \
+        if (v->data)                                                                        \
+        {                                                                                   \
+            v->retired[v->retired_len++] = v->data;                                         \
+        }                                                                                   \
+        ZVEC_ATOMIC_STORE(&v->data, fresh);                                                 \
+        v->capacity = new_cap;                                                              \
+        ZVEC_ATOMIC_STORE(&v->seq, s + 2);                                                  \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Writer: appends, then publishes the new length with a release store. */              \
+    static inline int zvec_seq_extend_##Name(zvec_seq_##Name *v, const T *items,            \
+                                             size_t count)                                  \
+    {                                                                                       \
+        size_t i, len = v->length;                                                          \
+        if (len + count > v->capacity)                                                      \
+        {                                                                                   \
+            size_t new_cap = v->capacity ? v->capacity : Z_GROWTH_FACTOR(0);                \
+            while (new_cap < len + count)                                                   \
+            {                                                                               \
+                new_cap = Z_GROWTH_FACTOR(new_cap);                                         \
+            }                                                                               \
+            if (Z_OK != zvec_seq_reserve_##Name(v, new_cap))                                \
+            {                                                                               \
+                return Z_ENOMEM;                                                            \
+            }                                                                               \
+        }                                                                                   \
+        for (i = 0; i < count; ++i)                                                         \
+        {                                                                                   \
+            v->data[len + i] = items[i];                                                    \
+        }                                                                                   \
+        ZVEC_ATOMIC_STORE(&v->length, len + count);                                         \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_seq_push_##Name(zvec_seq_##Name *v, T value)                     \
+    {                                                                                       \
+        return zvec_seq_extend_##Name(v, &value, 1);                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Reader: lock-free length (acquire); elements below it are published. */              \
+    static inline size_t zvec_seq_length_##Name(zvec_seq_##Name *v)                         \
+    {                                                                                       \
+        return ZVEC_ATOMIC_LOAD(&v->length);                                                \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Reader: returns a consistent (data, length) prefix. Retries only if a                \
+     * reallocation ran while the pair was being read. The prefix stays valid               \
+     * until the writer calls zvec_seq_reclaim.                                             \
+     */                                                                                     \
+    static inline zvec_seq_snap_##Name zvec_seq_snapshot_##Name(zvec_seq_##Name *v)         \
+    {                                                                                       \
+        zvec_seq_snap_##Name snap;                                                          \
+        for (;;)                                                                            \
+        {                                                                                   \
+            unsigned long s = ZVEC_ATOMIC_LOAD(&v->seq);                                    \
+            if (0 == (s & 1))                                                               \
+            {                                                                               \
+                snap.length = ZVEC_ATOMIC_LOAD(&v->length);                                 \
+                snap.data = ZVEC_ATOMIC_LOAD(&v->data);                                     \
+                if (ZVEC_ATOMIC_LOAD(&v->seq) == s)                                         \
+                {                                                                           \
+                    return snap;                                                            \
+                }                                                                           \
+            }                                                                               \
+            ZVEC_CPU_RELAX();                                                               \
+        }                                                                                   \
+    }
+
+
+/*
+ * Epoch growth mode for plain zvec_##Name (opt-in, per call).
+ *
+ * zvec_reserve_##Name reallocs in place, leaving concurrent readers with a
+ * dangling 'data'. These variants copy into a new buffer, publish it and retire
+ * the old one to a zvec_epoch, so one writer can keep appending while readers
+ * scan the vector inside epoch sections.
+ */
+#define ZVEC_GEN_EBR_IMPL(T, Name)                                                          \
+                                                                                            \
+    /*                                                                                      \
+     * Writer: grows like zvec_reserve_##Name but never frees the old buffer in             \
+     * place. It allocates, copies, publishes the new pointer and retires the               \
+     * old one to 'e', so readers inside an epoch section keep valid memory.                \
+     */                                                                                     \
+    static inline int zvec_reserve_epoch_##Name(zvec_##Name *v, size_t new_cap,             \
+                                                zvec_epoch *e)                              \
+    {                                                                                       \
+        T *fresh;                                                                           \
+        T *old = v->data;                                                                   \
+        if (new_cap <= v->capacity)                                                         \
+        {                                                                                   \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+        fresh = (T *)ZVEC_MALLOC(new_cap * sizeof(T));                                      \
+        if (!fresh)                                                                         \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        if (v->length)                                                                      \
+        {                                                                                   \
+            memcpy(fresh, old, v->length * sizeof(T));                                      \
+        }                                                                                   \
+        ZVEC_ATOMIC_STORE(&v->data, fresh);                                                 \
+        v->capacity = new_cap;                                                              \
+        if (old)                                                                            \
+        {                                                                                   \
+            zvec_epoch_retire(e, old, zvec_epoch_free_impl);                                \
+        }                                                                                   \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Writer: appends through zvec_reserve_epoch, then publishes the length. */            \
+    static inline int zvec_extend_epoch_##Name(zvec_##Name *v, const T *items,              \
+                                               size_t count, zvec_epoch *e)                 \
+    {                                                                                       \
+        size_t i, len = v->length;                                                          \
+        if (len + count > v->capacity)                                                      \
+        {                                                                                   \
+            size_t new_cap = v->capacity ? v->capacity : Z_GROWTH_FACTOR(0);                \
+            while (new_cap < len + count)                                                   \
+            {                                                                               \
+                new_cap = Z_GROWTH_FACTOR(new_cap);                                         \
+            }                                                                               \
+            if (Z_OK != zvec_reserve_epoch_##Name(v, new_cap, e))                           \
+            {                                                                               \
+                return Z_ENOMEM;                                                            \
+            }                                                                               \
+        }                                                                                   \
+        for (i = 0; i < count; ++i)                                                         \
+        {                                                                                   \
+            v->data[len + i] = items[i];                                                    \
+        }                                                                                   \
+        ZVEC_ATOMIC_STORE(&v->length, len + count);                                         \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_push_epoch_##Name(zvec_##Name *v, T value, zvec_epoch *e)        \
+    {                                                                                       \
+        return zvec_extend_epoch_##Name(v, &value, 1, e);                                   \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Reader, inside zvec_epoch_enter/exit: returns a read-only view of the                \
+     * published prefix, usable with the regular read APIs until exit. The                  \
+     * length is loaded first; the buffer loaded after it always holds it.                  \
+     */                                                                                     \
+    static inline zvec_##Name zvec_load_epoch_##Name(zvec_##Name *v)                        \
+    {                                                                                       \
+        zvec_##Name view;                                                                   \
+        view.length = ZVEC_ATOMIC_LOAD(&v->length);                                         \
+        view.data = ZVEC_ATOMIC_LOAD(&v->data);                                             \
+        view.capacity = view.length;                                                        \
+        return view;                                                                        \
+    }
+
+#else
+#   define ZVEC_GEN_CONC_IMPL(T, Name)
+#   define ZVEC_GEN_SPSC_IMPL(T, Name)
+#   define ZVEC_GEN_MPMC_IMPL(T, Name)
+#   define ZVEC_GEN_DEQUE_IMPL(T, Name)
+#   define ZVEC_GEN_PAR_IMPL(T, Name)
+#   define ZVEC_GEN_RCU_IMPL(T, Name)
+#   define ZVEC_GEN_LOCAL_IMPL(T, Name)
+#   define ZVEC_GEN_SHARD_IMPL(T, Name)
+#   define ZVEC_GEN_SEQ_IMPL(T, Name)
+#   define ZVEC_GEN_EBR_IMPL(T, Name)
+#endif // ZVEC_HAS_THREADS
+
+/*
+ * File and memory-mapped I/O (requires ZVEC_ENABLE_IO, C only, POSIX).
+ *
+ * Vectors are stored as a fixed 64-byte header followed by the raw elements, so
+ * a saved file can be mapped back and used in place: the element array starts
+ * at a 64-byte aligned offset of a page-aligned mapping. Files use the native
+ * byte order and layout; the header records enough to refuse a mismatch.
+ * Calls return the usual Z_* codes and leave errno set on I/O failure.
+ */
+#if ZVEC_HAS_IO
+
+#ifndef O_CLOEXEC
+#   define O_CLOEXEC 0
+#endif
+
+#define ZVEC_FILE_MAGIC        "ZVECARR"
+#define ZVEC_FILE_VERSION      1u
+#define ZVEC_FILE_ENDIAN       0x01020304u
+#define ZVEC_FILE_HEADER_SIZE  64
+#define ZVEC_CHECKSUM_SEED     0xcbf29ce484222325ULL
+#define ZVEC_FILE_LIVE         1u   // Flag: file-backed vector, checksum not maintained.
+#define ZVEC_FILE_LOG          2u   // Flag: append log, elements follow as framed batches.
+#define ZVEC_FILE_TORN         4u   // Flag: checkpoint being written, contents undefined.
+
+#if defined(__APPLE__)
+#   define ZVEC_FDATASYNC(fd)  fsync(fd)
+#else
+#   define ZVEC_FDATASYNC(fd)  fdatasync(fd)
+#endif
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;        // ZVEC_FILE_ENDIAN as written by the saving machine.
+    uint32_t elem_size;
+    uint32_t elem_align;
+    uint64_t length;        // Element count.
+    uint64_t checksum;      // zvec_checksum_impl() over the element bytes.
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t nonce;         // Checkpoint files: writer's tracker id.
+    uint64_t generation;    // Checkpoint files: checkpoint number (1, 2, ...).
+} zvec_file_header;
+
+typedef char zvec_file_header_size_check[
+    (sizeof(zvec_file_header) == ZVEC_FILE_HEADER_SIZE) ? 1 : -1];
+
+/*
+ * Word-at-a-time FNV-1a variant. Streamable: feed the result back in as 'h'
+ * as long as every chunk but the last is a multiple of 8 bytes.
+ */
+static inline uint64_t zvec_checksum_impl(uint64_t h, const void *buf, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)buf;
+    while (len >= 8)
+    {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        h = (h ^ w) * 0x100000001b3ULL;
+        h ^= h >> 32;
+        p += 8;
+        len -= 8;
+    }
+    while (len--)
+    {
+        h = (h ^ *p++) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static inline int zvec_write_all_impl(int fd, const void *buf, size_t len)
+{
+    const char *p = (const char *)buf;
+    while (len > 0)
+    {
+        ssize_t n = write(fd, p, len);
+        if (n < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return Z_ERR;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return Z_OK;
+}
+
+// Reads exactly len bytes; hitting end of file first is Z_EINVAL.
+static inline int zvec_read_all_impl(int fd, void *buf, size_t len)
+{
+    char *p = (char *)buf;
+    while (len > 0)
+    {
+        ssize_t n = read(fd, p, len);
+        if (n < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return Z_ERR;
+        }
+        if (0 == n)
+        {
+            return Z_EINVAL;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return Z_OK;
+}
+
+static inline void zvec_file_header_init_impl(zvec_file_header *h, size_t elem_size,
+                                              size_t align, size_t length, uint64_t sum)
+{
+    memset(h, 0, sizeof(zvec_file_header));
+    memcpy(h->magic, ZVEC_FILE_MAGIC, sizeof(h->magic));
+    h->version = ZVEC_FILE_VERSION;
+    h->endian = ZVEC_FILE_ENDIAN;
+    h->elem_size = (uint32_t)elem_size;
+    h->elem_align = (uint32_t)align;
+    h->length = length;
+    h->checksum = sum;
+}
+
+/*
+ * Validates a header against the expected element type (elem_size 0 accepts
+ * any type) and the file size. Returns Z_OK or Z_EINVAL.
+ */
+static inline int zvec_file_header_check_impl(const zvec_file_header *h, size_t elem_size,
+                                              size_t align, uint64_t file_size)
+{
+    if (0 != memcmp(h->magic, ZVEC_FILE_MAGIC, sizeof(h->magic)) ||
+        ZVEC_FILE_VERSION != h->version || ZVEC_FILE_ENDIAN != h->endian ||
+        (h->flags & (ZVEC_FILE_LOG | ZVEC_FILE_TORN)) || 0 == h->elem_size ||
+        file_size < ZVEC_FILE_HEADER_SIZE)
+    {
+        return Z_EINVAL;
+    }
+    if (elem_size && (h->elem_size != elem_size || h->elem_align != align))
+    {
+        return Z_EINVAL;
+    }
+    if (h->length > (file_size - ZVEC_FILE_HEADER_SIZE) / h->elem_size ||
+        h->length > SIZE_MAX / h->elem_size)
+    {
+        return Z_EINVAL;
+    }
+    return Z_OK;
+}
+
+/*
+ * Writes header + elements to "<path>.tmp", syncs it and renames it over path,
+ * so readers see either the old file or the complete new one.
+ */
+static inline int zvec_save_impl(const char *path, const void *data, size_t elem_size,
+                                 size_t align, size_t length)
+{
+    zvec_file_header h;
+    size_t plen = strlen(path);
+    size_t bytes = length * elem_size;
+    char *tmp;
+    int fd, rc;
+    if (align > ZVEC_FILE_HEADER_SIZE)
+    {
+        return Z_EINVAL;
+    }
+    tmp = (char *)ZVEC_MALLOC(plen + 5);
+    if (!tmp)
+    {
+        return Z_ENOMEM;
+    }
+    memcpy(tmp, path, plen);
+    memcpy(tmp + plen, ".tmp", 5);
+    zvec_file_header_init_impl(&h, elem_size, align, length,
+                               zvec_checksum_impl(ZVEC_CHECKSUM_SEED, data, bytes));
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        ZVEC_FREE(tmp);
+        return Z_ERR;
+    }
+    rc = zvec_write_all_impl(fd, &h, sizeof(h));
+    if (Z_OK == rc && bytes)
+    {
+        rc = zvec_write_all_impl(fd, data, bytes);
+    }
+    if (Z_OK == rc && 0 != fsync(fd))
+    {
+        rc = Z_ERR;
+    }
+    if (0 != close(fd) && Z_OK == rc)
+    {
+        rc = Z_ERR;
+    }
+    if (Z_OK == rc && 0 != rename(tmp, path))
+    {
+        rc = Z_ERR;
+    }
+    if (Z_OK != rc)
+    {
+        unlink(tmp);
+    }
+    ZVEC_FREE(tmp);
+    return rc;
+}
+
+/*
+ * Maps a saved file read-only and returns its element array, or NULL (errno
+ * is EINVAL for a malformed file or a type mismatch). The checksum is not
+ * checked here, as that would fault in every page; see zvec_verify_file.
+ */
+static inline void *zvec_map_file_impl(const char *path, size_t elem_size, size_t align,
+                                       size_t *length)
+{
+    zvec_file_header h;
+    struct stat st;
+    void *base;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (0 != fstat(fd, &st) || Z_OK != zvec_read_all_impl(fd, &h, sizeof(h)) ||
+        Z_OK != zvec_file_header_check_impl(&h, elem_size, align, (uint64_t)st.st_size))
+    {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+    base = mmap(NULL, ZVEC_FILE_HEADER_SIZE + (size_t)h.length * elem_size, PROT_READ,
+                MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == base)
+    {
+        return NULL;
+    }
+    *length = (size_t)h.length;
+    return (char *)base + ZVEC_FILE_HEADER_SIZE;
+}
+
+static inline void zvec_unmap_impl(void *data, size_t bytes)
+{
+    munmap((char *)data - ZVEC_FILE_HEADER_SIZE, ZVEC_FILE_HEADER_SIZE + bytes);
+}
+
+/*
+ * Streams a saved file and checks its header and checksum (only the header for
+ * a live file-backed vector). Returns Z_OK, Z_EINVAL on a malformed or corrupt
+ * file, or Z_ERR / Z_ENOMEM.
+ */
+static inline int zvec_verify_file(const char *path)
+{
+    enum { CHUNK = 1 << 20 };
+    zvec_file_header h;
+    struct stat st;
+    uint64_t sum = ZVEC_CHECKSUM_SEED;
+    size_t left;
+    char *buf;
+    int rc;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return Z_ERR;
+    }
+    if (0 != fstat(fd, &st))
+    {
+        close(fd);
+        return Z_ERR;
+    }
+    rc = zvec_read_all_impl(fd, &h, sizeof(h));
+    if (Z_OK == rc)
+    {
+        rc = zvec_file_header_check_impl(&h, 0, 0, (uint64_t)st.st_size);
+    }
+    buf = (Z_OK == rc) ? (char *)ZVEC_MALLOC(CHUNK) : NULL;
+    if (Z_OK == rc && !buf)
+    {
+        rc = Z_ENOMEM;
+    }
+    left = (Z_OK == rc) ? (size_t)h.length * h.elem_size : 0;
+    while (Z_OK == rc && left > 0)
+    {
+        size_t n = (left < CHUNK) ? left : CHUNK;
+        rc = zvec_read_all_impl(fd, buf, n);
+        sum = zvec_checksum_impl(sum, buf, n);
+        left -= n;
+    }
+    if (Z_OK == rc && !(h.flags & ZVEC_FILE_LIVE) && sum != h.checksum)
+    {
+        rc = Z_EINVAL;
+    }
+    ZVEC_FREE(buf);
+    close(fd);
+    return rc;
+}
+
+/*
+ * Direct descriptor I/O.
+ *
+ * Reads land straight in the reserved, uninitialized tail of a vector instead
+ * of a bounce buffer, and length only advances by whole elements. A read that
+ * stops inside an element leaves those bytes at data + length: with a
+ * 'partial' counter the next call continues after them (do not modify the
+ * vector in between); with NULL the call keeps reading until the element is
+ * complete, which suits blocking descriptors.
+ */
+#define ZVEC_IOV(v)  ((struct iovec){ (void *)(v)->data, (v)->length * sizeof(*(v)->data) })
+
+/*
+ * read()s into tail[carry, room). Returns the whole elements now in tail, 0 at
+ * end of input, Z_EEMPTY if a non-blocking fd has no data yet, Z_EINVAL if the
+ * input ends inside an element, or Z_ERR.
+ */
+static inline ssize_t zvec_read_fd_impl(int fd, char *tail, size_t room, size_t elem_size,
+                                        size_t *partial)
+{
+    size_t carry = partial ? *partial : 0;
+    for (;;)
+    {
+        ssize_t n = read(fd, tail + carry, room - carry);
+        if (n < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            if ((EAGAIN == errno || EWOULDBLOCK == errno) && (partial || 0 == carry))
+            {
+                return Z_EEMPTY;
+            }
+            return Z_ERR;
+        }
+        if (0 == n)
+        {
+            return carry ? Z_EINVAL : 0;
+        }
+        carry += (size_t)n;
+        if (partial || 0 == carry % elem_size)
+        {
+            break;
+        }
+    }
+    if (partial)
+    {
+        *partial = carry % elem_size;
+    }
+    return (ssize_t)(carry / elem_size);
+}
+
+/*
+ * pread()s up to 'room' bytes at off. Returns whole elements; a trailing
+ * fragment is ignored (the offset tells the caller where to resume).
+ */
+static inline ssize_t zvec_pread_fd_impl(int fd, char *tail, size_t room, size_t elem_size,
+                                         uint64_t off)
+{
+    size_t got = 0;
+    while (got < room)
+    {
+        ssize_t n = pread(fd, tail + got, room - got, (off_t)(off + got));
+        if (n < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return Z_ERR;
+        }
+        if (0 == n)
+        {
+            break;
+        }
+        got += (size_t)n;
+    }
+    return (ssize_t)(got / elem_size);
+}
+
+/*
+ * Gathers iov[0..count) into as few writev() calls as the kernel allows,
+ * resuming after short writes. The iov array is consumed (modified).
+ */
+static inline int zvec_writev_fd(int fd, struct iovec *iov, int count)
+{
+    while (count > 0)
+    {
+        ssize_t n;
+        if (0 == iov->iov_len)
+        {
+            iov++;
+            count--;
+            continue;
+        }
+#ifdef IOV_MAX
+        n = writev(fd, iov, (count < IOV_MAX) ? count : IOV_MAX);
+#else
+        n = writev(fd, iov, count);
+#endif
+        if (n < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return Z_ERR;
+        }
+        while (count > 0 && (size_t)n >= iov->iov_len)
+        {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    return Z_OK;
+}
+
+/*
+ * File-backed vectors.
+ *
+ * The storage of a zvec_file_Name is a shared writable mapping of a file in the
+ * zvec_save format, with spare capacity kept as file slack: growth extends the
+ * file with ftruncate and the mapping with mremap (munmap + mmap where mremap
+ * is unavailable), and the page cache does all the I/O. The header length only
+ * moves on zvec_file_sync, after the elements it covers are on disk, so after a
+ * crash the file reopens at its last checkpoint.
+ */
+static inline int zvec_file_fail_impl(int fd)
+{
+    int err = errno;
+    close(fd);
+    errno = err;
+    return Z_ERR;
+}
+
+/*
+ * Opens or creates path and maps it read-write. Returns the element array, or
+ * NULL (errno is EINVAL if the file holds another type or is malformed).
+ */
+static inline void *zvec_file_open_impl(const char *path, size_t elem_size, size_t align,
+                                        int *fd_out, size_t *cap, size_t *len)
+{
+    zvec_file_header h;
+    struct stat st;
+    char *base;
+    int fd;
+    if (align > ZVEC_FILE_HEADER_SIZE)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (0 != fstat(fd, &st))
+    {
+        zvec_file_fail_impl(fd);
+        return NULL;
+    }
+    if (0 == st.st_size)
+    {
+        zvec_file_header_init_impl(&h, elem_size, align, 0, 0);
+        if (Z_OK != zvec_write_all_impl(fd, &h, sizeof(h)))
+        {
+            zvec_file_fail_impl(fd);
+            return NULL;
+        }
+        st.st_size = ZVEC_FILE_HEADER_SIZE;
+    }
+    else if (Z_OK != zvec_read_all_impl(fd, &h, sizeof(h)) ||
+             Z_OK != zvec_file_header_check_impl(&h, elem_size, align,
+                                                 (uint64_t)st.st_size))
+    {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+    *cap = ((size_t)st.st_size - ZVEC_FILE_HEADER_SIZE) / elem_size;
+    base = (char *)mmap(NULL, ZVEC_FILE_HEADER_SIZE + *cap * elem_size,
+                        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == (void *)base)
+    {
+        zvec_file_fail_impl(fd);
+        return NULL;
+    }
+    ((zvec_file_header *)base)->flags |= ZVEC_FILE_LIVE;
+    *len = (size_t)h.length;
+    *fd_out = fd;
+    return base + ZVEC_FILE_HEADER_SIZE;
+}
+
+// Resizes the file and its mapping; returns the (possibly moved) element array.
+static inline void *zvec_file_remap_impl(int fd, void *data, size_t old_bytes,
+                                         size_t new_bytes)
+{
+    char *base = (char *)data - ZVEC_FILE_HEADER_SIZE;
+    void *fresh;
+    if (0 != ftruncate(fd, (off_t)new_bytes))
+    {
+        return NULL;
+    }
+#ifdef MREMAP_MAYMOVE
+    fresh = mremap(base, old_bytes, new_bytes, MREMAP_MAYMOVE);
+#else
+    fresh = mmap(NULL, new_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (MAP_FAILED != fresh)
+    {
+        munmap(base, old_bytes);
+    }
+#endif
+    return (MAP_FAILED == fresh) ? NULL : (char *)fresh + ZVEC_FILE_HEADER_SIZE;
+}
+
+// Checkpoint: flushes the elements, then commits the length in the header.
+static inline int zvec_file_sync_impl(void *data, size_t length, size_t elem_size)
+{
+    char *base = (char *)data - ZVEC_FILE_HEADER_SIZE;
+    if (0 != msync(base, ZVEC_FILE_HEADER_SIZE + length * elem_size, MS_SYNC))
+    {
+        return Z_ERR;
+    }
+    ((zvec_file_header *)base)->length = length;
+    return (0 == msync(base, ZVEC_FILE_HEADER_SIZE, MS_SYNC)) ? Z_OK : Z_ERR;
+}
+
+// Checkpoints, unmaps and trims the slack so the file matches zvec_save output.
+static inline int zvec_file_close_impl(int fd, void *data, size_t length, size_t cap,
+                                       size_t elem_size)
+{
+    int rc = zvec_file_sync_impl(data, length, elem_size);
+    munmap((char *)data - ZVEC_FILE_HEADER_SIZE, ZVEC_FILE_HEADER_SIZE + cap * elem_size);
+    if (Z_OK == rc &&
+        0 != ftruncate(fd, (off_t)(ZVEC_FILE_HEADER_SIZE + length * elem_size)))
+    {
+        rc = Z_ERR;
+    }
+    if (0 != close(fd) && Z_OK == rc)
+    {
+        rc = Z_ERR;
+    }
+    return rc;
+}
+
+/*
+ * Shared-memory vectors.
+ *
+ * A POSIX shared memory object holds a 64-byte header followed by the element
+ * array. The header stores only sizes and counts, never pointers, so each
+ * process maps the segment wherever it likes. One writer appends: it stores
+ * the elements, then publishes the new length with a release store. Growth
+ * extends the object in place, so existing elements keep their offsets and a
+ * reader only remaps once the published length outruns its mapping.
+ */
+#define ZVEC_SHM_MAGIC  "ZVECSHM"
+
+typedef struct
+{
+    char magic[8];
+    uint32_t elem_size;
+    uint32_t elem_align;
+    uint64_t capacity;      // Elements the object holds (writer-owned).
+    uint64_t length;        // Published element count.
+    uint32_t ready;         // Set last by the creator.
+    unsigned char reserved[28];
+} zvec_shm_header;
+
+typedef char zvec_shm_header_size_check[
+    (sizeof(zvec_shm_header) == ZVEC_FILE_HEADER_SIZE) ? 1 : -1];
+
+static inline zvec_shm_header *zvec_shm_header_impl(void *data)
+{
+    return (zvec_shm_header *)((char *)data - ZVEC_FILE_HEADER_SIZE);
+}
+
+// Writer: creates the object (which must not exist) and maps it read-write.
+static inline void *zvec_shm_create_impl(const char *name, size_t elem_size, size_t align,
+                                         size_t cap, int *fd_out)
+{
+    size_t bytes = ZVEC_FILE_HEADER_SIZE + cap * elem_size;
+    zvec_shm_header *h;
+    int fd;
+    if (align > ZVEC_FILE_HEADER_SIZE)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (0 != ftruncate(fd, (off_t)bytes))
+    {
+        zvec_file_fail_impl(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    h = (zvec_shm_header *)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == (void *)h)
+    {
+        zvec_file_fail_impl(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    memcpy(h->magic, ZVEC_SHM_MAGIC, sizeof(h->magic));
+    h->elem_size = (uint32_t)elem_size;
+    h->elem_align = (uint32_t)align;
+    h->capacity = cap;
+    __atomic_store_n(&h->length, (uint64_t)0, __ATOMIC_RELEASE);
+    __atomic_store_n(&h->ready, 1u, __ATOMIC_RELEASE);
+    *fd_out = fd;
+    return (char *)h + ZVEC_FILE_HEADER_SIZE;
+}
+
+/*
+ * Reader: maps an existing object read-only. Returns NULL with errno EAGAIN
+ * while the creator is still initializing it, or EINVAL on a type mismatch.
+ */
+static inline void *zvec_shm_attach_impl(const char *name, size_t elem_size, size_t align,
+                                         size_t *mapped_cap, int *fd_out)
+{
+    zvec_shm_header *h;
+    struct stat st;
+    uint32_t ready;
+    size_t cap;
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (0 != fstat(fd, &st))
+    {
+        zvec_file_fail_impl(fd);
+        return NULL;
+    }
+    if ((size_t)st.st_size < ZVEC_FILE_HEADER_SIZE)
+    {
+        close(fd);
+        errno = EAGAIN;
+        return NULL;
+    }
+    cap = ((size_t)st.st_size - ZVEC_FILE_HEADER_SIZE) / elem_size;
+    h = (zvec_shm_header *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == (void *)h)
+    {
+        zvec_file_fail_impl(fd);
+        return NULL;
+    }
+    ready = __atomic_load_n(&h->ready, __ATOMIC_ACQUIRE);
+    if (!ready || 0 != memcmp(h->magic, ZVEC_SHM_MAGIC, sizeof(h->magic)) ||
+        h->elem_size != elem_size || h->elem_align != align)
+    {
+        errno = ready ? EINVAL : EAGAIN;
+        munmap(h, (size_t)st.st_size);
+        close(fd);
+        return NULL;
+    }
+    *mapped_cap = cap;
+    *fd_out = fd;
+    return (char *)h + ZVEC_FILE_HEADER_SIZE;
+}
+
+// Writer: grows the object and its mapping to new_cap elements.
+static inline void *zvec_shm_grow_impl(int fd, void *data, size_t elem_size, size_t old_cap,
+                                       size_t new_cap)
+{
+    void *fresh = zvec_file_remap_impl(fd, data,
+                                       ZVEC_FILE_HEADER_SIZE + old_cap * elem_size,
+                                       ZVEC_FILE_HEADER_SIZE + new_cap * elem_size);
+    if (fresh)
+    {
+        zvec_shm_header_impl(fresh)->capacity = new_cap;
+    }
+    return fresh;
+}
+
+// Writer: makes the first len elements visible to readers.
+static inline void zvec_shm_publish_impl(void *data, size_t len)
+{
+    __atomic_store_n(&zvec_shm_header_impl(data)->length, (uint64_t)len, __ATOMIC_RELEASE);
+}
+
+/*
+ * Reader: loads the published length and, when it outruns the mapping,
+ * remaps up to the current object size. Returns the new data pointer (or the
+ * old one on remap failure, with *length clamped to what is mapped).
+ */
+static inline void *zvec_shm_refresh_impl(int fd, void *data, size_t elem_size,
+                                          size_t *mapped_cap, size_t *length)
+{
+    size_t len = (size_t)__atomic_load_n(&zvec_shm_header_impl(data)->length,
+                                         __ATOMIC_ACQUIRE);
+    if (len > *mapped_cap)
+    {
+        struct stat st;
+        void *fresh = MAP_FAILED;
+        if (0 == fstat(fd, &st))
+        {
+            fresh = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        if (MAP_FAILED == fresh)
+        {
+            *length = *mapped_cap;
+            return data;
+        }
+        munmap(zvec_shm_header_impl(data), ZVEC_FILE_HEADER_SIZE + *mapped_cap * elem_size);
+        data = (char *)fresh + ZVEC_FILE_HEADER_SIZE;
+        *mapped_cap = ((size_t)st.st_size - ZVEC_FILE_HEADER_SIZE) / elem_size;
+    }
+    *length = len;
+    return data;
+}
+
+// Removes the object name; mappings stay valid until every process detaches.
+static inline int zvec_shm_unlink(const char *name)
+{
+    return (0 == shm_unlink(name)) ? Z_OK : Z_ERR;
+}
+
+/*
+ * External merge sort.
+ *
+ * Sorts a file of raw fixed-size records that may be far larger than memory.
+ * Pass 1 fills two thirds of mem_budget, sorts that with zvec_stable_sort (the
+ * rest is its merge scratch, reused for every run) and appends it as a run to
+ * one unlinked spill file next to the output. Runs keep input order and the
+ * merge breaks ties by run index, so the whole sort is stable. Runs are then
+ * merged with a loser tree (one comparison per tree level per record), each run
+ * streaming through its own slice of the budget with large sequential preads.
+ * If there are too many runs for the budget, intermediate passes merge groups
+ * of them into a second spill file first. Input that fits in one run skips the
+ * spill.
+ */
+#ifndef ZVEC_XSORT_MIN_BUF
+#   define ZVEC_XSORT_MIN_BUF (64 * 1024)   // Smallest per-run merge buffer, in bytes.
+#endif
+
+typedef struct
+{
+    uint64_t off;       // Byte offset in the spill file.
+    uint64_t count;     // Records.
+} zvec_xsort_run;
+
+typedef struct
+{
+    char *buf;
+    size_t pos;
+    size_t fill;
+    uint64_t off;
+    uint64_t left;      // Records not yet read into buf.
+} zvec_xsort_cursor;
+
+typedef struct
+{
+    int in_fd;
+    int spill_fd;
+    int out_fd;
+    const char *path_out;
+    zvec_xsort_run *runs;
+    size_t nruns;
+    size_t runs_cap;
+    uint64_t spilled;   // Bytes in the spill file.
+} zvec_xsort;
+
+static inline int zvec_pread_all_impl(int fd, void *buf, size_t len, uint64_t off)
+{
+    char *p = (char *)buf;
+    while (len > 0)
+    {
+        ssize_t n = pread(fd, p, len, (off_t)off);
+        if (n < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return Z_ERR;
+        }
+        if (0 == n)
+        {
+            return Z_EINVAL;
+        }
+        p += n;
+        off += (uint64_t)n;
+        len -= (size_t)n;
+    }
+    return Z_OK;
+}
+
+static inline int zvec_pwrite_all_impl(int fd, const void *buf, size_t len, uint64_t off)
+{
+    const char *p = (const char *)buf;
+    while (len > 0)
+    {
+        ssize_t n = pwrite(fd, p, len, (off_t)off);
+        if (n < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return Z_ERR;
+        }
+        p += n;
+        off += (uint64_t)n;
+        len -= (size_t)n;
+    }
+    return Z_OK;
+}
+
+// Creates an unlinked temporary file in the directory of path.
+static inline int zvec_xsort_temp_impl(const char *path)
+{
+    size_t plen = strlen(path);
+    char *tmpl = (char *)ZVEC_MALLOC(plen + 8);
+    int fd;
+    if (!tmpl)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    memcpy(tmpl, path, plen);
+    memcpy(tmpl + plen, ".XXXXXX", 8);
+    fd = mkstemp(tmpl);
+    if (fd >= 0)
+    {
+        unlink(tmpl);
+    }
+    ZVEC_FREE(tmpl);
+    return fd;
+}
+
+static inline int zvec_xsort_begin_impl(zvec_xsort *x, const char *path_in,
+                                        const char *path_out)
+{
+    memset(x, 0, sizeof(zvec_xsort));
+    x->spill_fd = -1;
+    x->out_fd = -1;
+    x->path_out = path_out;
+    x->in_fd = open(path_in, O_RDONLY | O_CLOEXEC);
+    return (x->in_fd < 0) ? Z_ERR : Z_OK;
+}
+
+/*
+ * Reads up to 'bytes' of fixed-size records. Sets *got to the bytes read (short
+ * only at end of input); a trailing partial record is Z_EINVAL.
+ */
+static inline int zvec_read_records_impl(int fd, void *buf, size_t bytes, size_t elem_size,
+                                         size_t *got)
+{
+    char *p = (char *)buf;
+    size_t total = 0;
+    while (total < bytes)
+    {
+        ssize_t n = read(fd, p + total, bytes - total);
+        if (n < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return Z_ERR;
+        }
+        if (0 == n)
+        {
+            break;
+        }
+        total += (size_t)n;
+    }
+    *got = total;
+    return (total % elem_size) ? Z_EINVAL : Z_OK;
+}
+
+static inline int zvec_xsort_open_out_impl(zvec_xsort *x)
+{
+    x->out_fd = open(x->path_out, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    return (x->out_fd < 0) ? Z_ERR : Z_OK;
+}
+
+/*
+ * Stores one sorted run. The first run, when it is also the last, goes
+ * straight to the output instead.
+ */
+static inline int zvec_xsort_spill_impl(zvec_xsort *x, const void *data, size_t bytes,
+                                        size_t elem_size, int last)
+{
+    if (last && 0 == x->nruns)
+    {
+        if (Z_OK != zvec_xsort_open_out_impl(x))
+        {
+            return Z_ERR;
+        }
+        return zvec_write_all_impl(x->out_fd, data, bytes);
+    }
+    if (x->spill_fd < 0 && (x->spill_fd = zvec_xsort_temp_impl(x->path_out)) < 0)
+    {
+        return Z_ERR;
+    }
+    if (x->nruns == x->runs_cap)
+    {
+        size_t new_cap = x->runs_cap ? Z_GROWTH_FACTOR(x->runs_cap) : 16;
+        zvec_xsort_run *fresh;
+        fresh = (zvec_xsort_run *)ZVEC_REALLOC(x->runs, new_cap * sizeof(zvec_xsort_run));
+        if (!fresh)
+        {
+            return Z_ENOMEM;
+        }
+        x->runs = fresh;
+        x->runs_cap = new_cap;
+    }
+    if (Z_OK != zvec_write_all_impl(x->spill_fd, data, bytes))
+    {
+        return Z_ERR;
+    }
+    x->runs[x->nruns].off = x->spilled;
+    x->runs[x->nruns].count = bytes / elem_size;
+    x->nruns++;
+    x->spilled += bytes;
+    return Z_OK;
+}
+
+static inline int zvec_xsort_refill_impl(int fd, zvec_xsort_cursor *c, size_t per,
+                                          size_t elem_size)
+{
+    size_t n = (c->left < per) ? (size_t)c->left : per;
+    c->pos = 0;
+    c->fill = n;
+    if (0 == n)
+    {
+        return Z_OK;
+    }
+    c->left -= n;
+    c->off += (uint64_t)n * elem_size;
+    return zvec_pread_all_impl(fd, c->buf, n * elem_size, c->off - (uint64_t)n * elem_size);
+}
+
+// Loser-tree order: exhausted cursors sort last, ties go to the lower run.
+static inline int zvec_xsort_less_impl(const zvec_xsort_cursor *cur, size_t a, size_t b,
+                                       size_t elem_size,
+                                       int (*cmp)(const void *, const void *))
+{
+    int c;
+    if (cur[a].pos == cur[a].fill)
+    {
+        return 0;
+    }
+    if (cur[b].pos == cur[b].fill)
+    {
+        return 1;
+    }
+    c = cmp(cur[a].buf + cur[a].pos * elem_size, cur[b].buf + cur[b].pos * elem_size);
+    return c < 0 || (0 == c && a < b);
+}
+
+/*
+ * Merges k sorted runs of src into dst (appending at its current offset).
+ * Nodes 1..k-1 of 'tree' hold the loser of each match, tree[0] the winner.
+ */
+static inline int zvec_xsort_merge_impl(int src, const zvec_xsort_run *runs, size_t k,
+                                        int dst, size_t elem_size,
+                                        int (*cmp)(const void *, const void *),
+                                        size_t budget)
+{
+    size_t per = budget / (k + 1) / elem_size;
+    size_t i, out_len = 0;
+    zvec_xsort_cursor *cur;
+    size_t *tree, *win;
+    char *block, *out;
+    int rc = Z_OK;
+    if (0 == per)
+    {
+        per = 1;
+    }
+    cur = (zvec_xsort_cursor *)ZVEC_MALLOC(k * sizeof(zvec_xsort_cursor));
+    tree = (size_t *)ZVEC_MALLOC(3 * k * sizeof(size_t));
+    block = (char *)ZVEC_MALLOC((k + 1) * per * elem_size);
+    if (!cur || !tree || !block)
+    {
+        ZVEC_FREE(cur);
+        ZVEC_FREE(tree);
+        ZVEC_FREE(block);
+        return Z_ENOMEM;
+    }
+    win = tree + k;
+    out = block + k * per * elem_size;
+    for (i = 0; i < k && Z_OK == rc; ++i)
+    {
+        cur[i].buf = block + i * per * elem_size;
+        cur[i].off = runs[i].off;
+        cur[i].left = runs[i].count;
+        rc = zvec_xsort_refill_impl(src, &cur[i], per, elem_size);
+    }
+    if (Z_OK != rc)
+    {
+        ZVEC_FREE(cur);
+        ZVEC_FREE(tree);
+        ZVEC_FREE(block);
+        return rc;
+    }
+    for (i = 0; i < k; ++i)
+    {
+        win[k + i] = i;
+    }
+    for (i = k - 1; i >= 1; --i)
+    {
+        size_t l = win[2 * i], r = win[2 * i + 1];
+        int lw = zvec_xsort_less_impl(cur, l, r, elem_size, cmp);
+        win[i] = lw ? l : r;
+        tree[i] = lw ? r : l;
+    }
+    tree[0] = (k > 1) ? win[1] : 0;
+    while (Z_OK == rc && cur[tree[0]].pos < cur[tree[0]].fill)
+    {
+        size_t s = tree[0], t;
+        zvec_xsort_cursor *c = &cur[s];
+        memcpy(out + out_len * elem_size, c->buf + c->pos * elem_size, elem_size);
+        if (++out_len == per)
+        {
+            rc = zvec_write_all_impl(dst, out, out_len * elem_size);
+            out_len = 0;
+        }
+        if (++c->pos == c->fill && Z_OK == rc)
+        {
+            rc = zvec_xsort_refill_impl(src, c, per, elem_size);
+        }
+        if (Z_OK != rc)
+        {
+            break;
+        }
+        for (t = (s + k) / 2; t >= 1; t /= 2)
+        {
+            if (zvec_xsort_less_impl(cur, tree[t], s, elem_size, cmp))
+            {
+                size_t tmp = tree[t];
+                tree[t] = s;
+                s = tmp;
+            }
+        }
+        tree[0] = s;
+    }
+    if (Z_OK == rc && out_len)
+    {
+        rc = zvec_write_all_impl(dst, out, out_len * elem_size);
+    }
+    ZVEC_FREE(cur);
+    ZVEC_FREE(tree);
+    ZVEC_FREE(block);
+    return rc;
+}
+
+// Merges the spilled runs (in several passes if needed) into the output.
+static inline int zvec_xsort_finish_impl(zvec_xsort *x, size_t elem_size,
+                                         int (*cmp)(const void *, const void *),
+                                         size_t budget)
+{
+    size_t fanin = budget / ZVEC_XSORT_MIN_BUF;
+    int rc = Z_OK;
+    int other = -1;
+    fanin = (fanin > 3) ? fanin - 1 : 2;
+    if (x->out_fd < 0 && 0 == x->nruns)
+    {
+        rc = zvec_xsort_open_out_impl(x);   // Empty input.
+    }
+    while (Z_OK == rc && x->nruns > fanin)
+    {
+        size_t g, merged = 0;
+        uint64_t written = 0;
+        if (other < 0 && (other = zvec_xsort_temp_impl(x->path_out)) < 0)
+        {
+            rc = Z_ERR;
+            break;
+        }
+        for (g = 0; g < x->nruns && Z_OK == rc; g += fanin)
+        {
+            size_t k = (x->nruns - g < fanin) ? x->nruns - g : fanin;
+            uint64_t count = 0;
+            size_t i;
+            for (i = 0; i < k; ++i)
+            {
+                count += x->runs[g + i].count;
+            }
+            rc = zvec_xsort_merge_impl(x->spill_fd, x->runs + g, k, other, elem_size, cmp,
+                                       budget);
+            x->runs[merged].off = written;
+            x->runs[merged].count = count;
+            merged++;
+            written += count * elem_size;
+        }
+        if (Z_OK == rc && 0 != ftruncate(x->spill_fd, 0))
+        {
+            rc = Z_ERR;
+        }
+        if (Z_OK == rc)
+        {
+            int t = x->spill_fd;
+            x->spill_fd = other;
+            other = t;
+            if ((off_t)-1 == lseek(other, 0, SEEK_SET))
+            {
+                rc = Z_ERR;
+            }
+            x->nruns = merged;
+            x->spilled = written;
+        }
+    }
+    if (Z_OK == rc && x->nruns > 0)
+    {
+        rc = zvec_xsort_open_out_impl(x);
+        if (Z_OK == rc)
+        {
+            rc = zvec_xsort_merge_impl(x->spill_fd, x->runs, x->nruns, x->out_fd, elem_size,
+                                       cmp, budget);
+        }
+    }
+    if (other >= 0)
+    {
+        close(other);
+    }
+    return rc;
+}
+
+static inline int zvec_xsort_end_impl(zvec_xsort *x, int rc)
+{
+    if (x->in_fd >= 0)
+    {
+        close(x->in_fd);
+    }
+    if (x->spill_fd >= 0)
+    {
+        close(x->spill_fd);
+    }
+    if (x->out_fd >= 0 && 0 != close(x->out_fd) && Z_OK == rc)
+    {
+        rc = Z_ERR;
+    }
+    ZVEC_FREE(x->runs);
+    return rc;
+}
+
+/*
+ * Out-of-core paged vectors.
+ *
+ * Elements live in a backing file of raw records, split into fixed pages of
+ * whole elements. At most max_pages of them are resident, in frames kept in LRU
+ * order; a miss evicts the coldest frame (writing it back only if it was
+ * modified) and preads the page. Resident memory is therefore bounded by
+ * max_pages * page size no matter how long the vector grows. Scans can ask the
+ * kernel to read ahead with posix_fadvise.
+ */
+#ifndef ZVEC_PAGED_PAGE_BYTES
+#   define ZVEC_PAGED_PAGE_BYTES (64 * 1024)
+#endif
+
+#ifndef ZVEC_PAGED_READAHEAD
+#   define ZVEC_PAGED_READAHEAD 4    // Pages hinted ahead of a sequential scan.
+#endif
+
+#ifndef P_tmpdir
+#   define P_tmpdir "/tmp"
+#endif
+
+#define ZVEC_PAGED_NONE ((size_t)-1)
+
+typedef struct
+{
+    int fd;
+    size_t elem_size;
+    size_t page_elems;
+    size_t page_bytes;
+    size_t length;          // Elements.
+    uint64_t stored;        // Bytes of the file known to hold data.
+    char *frames;           // max_frames * page_bytes.
+    size_t max_frames;
+    size_t nframes;
+    size_t *frame_page;     // Page held by each frame.
+    size_t *prev;           // LRU list over frames, most recent first.
+    size_t *next;
+    unsigned char *dirty;
+    size_t head;
+    size_t tail;
+    size_t *page_frame;     // Page table: frame of each page, or ZVEC_PAGED_NONE.
+    size_t page_cap;
+    size_t misses;
+    size_t writebacks;
+} zvec_paged_core;
+
+/*
+ * Opens path (created if missing; its records become the initial contents),
+ * or an unlinked temporary file when path is NULL.
+ */
+static inline int zvec_paged_open_impl(zvec_paged_core *c, const char *path,
+                                       size_t elem_size, size_t max_pages)
+{
+    struct stat st;
+    size_t m = max_pages ? max_pages : 1;
+    memset(c, 0, sizeof(zvec_paged_core));
+    c->fd = path ? open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644)
+                 : zvec_xsort_temp_impl(P_tmpdir "/zvec_paged");
+    if (c->fd < 0)
+    {
+        return Z_ERR;
+    }
+    if (0 != fstat(c->fd, &st))
+    {
+        return zvec_file_fail_impl(c->fd);
+    }
+    c->elem_size = elem_size;
+    c->page_elems = (ZVEC_PAGED_PAGE_BYTES >= elem_size)
+                  ? ZVEC_PAGED_PAGE_BYTES / elem_size : 1;
+    c->page_bytes = c->page_elems * elem_size;
+    c->length = (size_t)st.st_size / elem_size;
+    c->stored = (uint64_t)c->length * elem_size;
+    c->max_frames = m;
+    c->head = c->tail = ZVEC_PAGED_NONE;
+    c->frames = (char *)ZVEC_MALLOC(m * c->page_bytes);
+    c->frame_page = (size_t *)ZVEC_MALLOC(3 * m * sizeof(size_t));
+    c->dirty = (unsigned char *)ZVEC_CALLOC(m, 1);
+    if (!c->frames || !c->frame_page || !c->dirty)
+    {
+        ZVEC_FREE(c->frames);
+        ZVEC_FREE(c->frame_page);
+        ZVEC_FREE(c->dirty);
+        close(c->fd);
+        return Z_ENOMEM;
+    }
+    c->prev = c->frame_page + m;
+    c->next = c->prev + m;
+    return Z_OK;
+}
+
+static inline void zvec_paged_unlink_impl(zvec_paged_core *c, size_t f)
+{
+    if (ZVEC_PAGED_NONE != c->prev[f])
+    {
+        c->next[c->prev[f]] = c->next[f];
+    }
+    else
+    {
+        c->head = c->next[f];
+    }
+    if (ZVEC_PAGED_NONE != c->next[f])
+    {
+        c->prev[c->next[f]] = c->prev[f];
+    }
+    else
+    {
+        c->tail = c->prev[f];
+    }
+}
+
+static inline void zvec_paged_push_front_impl(zvec_paged_core *c, size_t f)
+{
+    c->prev[f] = ZVEC_PAGED_NONE;
+    c->next[f] = c->head;
+    if (ZVEC_PAGED_NONE != c->head)
+    {
+        c->prev[c->head] = f;
+    }
+    c->head = f;
+    if (ZVEC_PAGED_NONE == c->tail)
+    {
+        c->tail = f;
+    }
+}
+
+// Writes the valid prefix of a dirty frame back to its page.
+static inline int zvec_paged_writeback_impl(zvec_paged_core *c, size_t f)
+{
+    size_t page = c->frame_page[f];
+    size_t first = page * c->page_elems;
+    size_t n = (c->length - first < c->page_elems) ? c->length - first : c->page_elems;
+    uint64_t off = (uint64_t)page * c->page_bytes;
+    const char *p = c->frames + f * c->page_bytes;
+    if (Z_OK != zvec_pwrite_all_impl(c->fd, p, n * c->elem_size, off))
+    {
+        return Z_ERR;
+    }
+    off += (uint64_t)n * c->elem_size;
+    if (off > c->stored)
+    {
+        c->stored = off;
+    }
+    c->dirty[f] = 0;
+    c->writebacks++;
+    return Z_OK;
+}
+
+/*
+ * Returns the frame holding 'page', loading it (and evicting the least
+ * recently used frame) on a miss, or NULL on I/O failure.
+ */
+static inline char *zvec_paged_fetch_impl(zvec_paged_core *c, size_t page, int write)
+{
+    size_t f;
+    char *frame;
+    if (page >= c->page_cap)
+    {
+        size_t new_cap = c->page_cap ? c->page_cap : 16;
+        size_t *fresh;
+        while (new_cap <= page)
+        {
+            new_cap = Z_GROWTH_FACTOR(new_cap);
+        }
+        fresh = (size_t *)ZVEC_REALLOC(c->page_frame, new_cap * sizeof(size_t));
+        if (!fresh)
+        {
+            return NULL;
+        }
+        for (f = c->page_cap; f < new_cap; ++f)
+        {
+            fresh[f] = ZVEC_PAGED_NONE;
+        }
+        c->page_frame = fresh;
+        c->page_cap = new_cap;
+    }
+    f = c->page_frame[page];
+    if (ZVEC_PAGED_NONE != f)
+    {
+        if (c->head != f)
+        {
+            zvec_paged_unlink_impl(c, f);
+            zvec_paged_push_front_impl(c, f);
+        }
+    }
+    else
+    {
+        uint64_t off = (uint64_t)page * c->page_bytes;
+        if (c->nframes < c->max_frames)
+        {
+            f = c->nframes++;
+        }
+        else
+        {
+            f = c->tail;
+            if (c->dirty[f] && Z_OK != zvec_paged_writeback_impl(c, f))
+            {
+                return NULL;
+            }
+            if (ZVEC_PAGED_NONE != c->frame_page[f])
+            {
+                c->page_frame[c->frame_page[f]] = ZVEC_PAGED_NONE;
+            }
+            zvec_paged_unlink_impl(c, f);
+        }
+        frame = c->frames + f * c->page_bytes;
+        if (off < c->stored)
+        {
+            size_t want = (c->stored - off < c->page_bytes) ? (size_t)(c->stored - off)
+                                                            : c->page_bytes;
+            if (Z_OK != zvec_pread_all_impl(c->fd, frame, want, off))
+            {
+                // Park the frame (unmapped, clean) so it is simply reused.
+                c->frame_page[f] = ZVEC_PAGED_NONE;
+                c->dirty[f] = 0;
+                zvec_paged_push_front_impl(c, f);
+                return NULL;
+            }
+            memset(frame + want, 0, c->page_bytes - want);
+        }
+        else
+        {
+            memset(frame, 0, c->page_bytes);
+        }
+        c->frame_page[f] = page;
+        c->page_frame[page] = f;
+        c->dirty[f] = 0;
+        zvec_paged_push_front_impl(c, f);
+        c->misses++;
+    }
+    if (write)
+    {
+        c->dirty[f] = 1;
+    }
+    return c->frames + f * c->page_bytes;
+}
+
+// Hints the kernel to read elements [first, first + count) ahead of use.
+static inline void zvec_paged_prefetch_impl(zvec_paged_core *c, size_t first, size_t count)
+{
+#ifdef POSIX_FADV_WILLNEED
+    if (first < c->length)
+    {
+        if (count > c->length - first)
+        {
+            count = c->length - first;
+        }
+        posix_fadvise(c->fd, (off_t)((uint64_t)first * c->elem_size),
+                      (off_t)((uint64_t)count * c->elem_size), POSIX_FADV_WILLNEED);
+    }
+#else
+    (void)c;
+    (void)first;
+    (void)count;
+#endif
+}
+
+// Writes back every dirty frame and trims the file to the vector length.
+static inline int zvec_paged_flush_impl(zvec_paged_core *c)
+{
+    size_t f;
+    for (f = 0; f < c->nframes; ++f)
+    {
+        if (c->dirty[f] && Z_OK != zvec_paged_writeback_impl(c, f))
+        {
+            return Z_ERR;
+        }
+    }
+    if (0 != ftruncate(c->fd, (off_t)((uint64_t)c->length * c->elem_size)))
+    {
+        return Z_ERR;
+    }
+    c->stored = (uint64_t)c->length * c->elem_size;
+    return Z_OK;
+}
+
+static inline int zvec_paged_close_impl(zvec_paged_core *c)
+{
+    int rc = zvec_paged_flush_impl(c);
+    if (0 != close(c->fd) && Z_OK == rc)
+    {
+        rc = Z_ERR;
+    }
+    ZVEC_FREE(c->frames);
+    ZVEC_FREE(c->frame_page);
+    ZVEC_FREE(c->dirty);
+    ZVEC_FREE(c->page_frame);
+    memset(c, 0, sizeof(zvec_paged_core));
+    c->fd = -1;
+    return rc;
+}
+
+/*
+ * Incremental checkpoints.
+ *
+ * A tracker keeps one bit per page of ZVEC_CKPT_PAGE_BYTES worth of elements,
+ * set by every tracked write. Checkpoints alternate between two zvec_save-format
+ * files, so the previous one stays loadable while the next is written: the
+ * target is first stamped ZVEC_FILE_TORN (rejected on load), its dirty pages
+ * are rewritten and synced, and only then is its header committed with the
+ * tracker's nonce and the new generation. A file was last written two
+ * checkpoints ago, so it is brought up to date with the pages dirtied in both
+ * intervals since ('prev' and 'bits'). If its header does not carry this
+ * tracker's nonce and the generation the tracker last wrote to it, the file is
+ * rewritten in full. zvec_checkpoint_pick returns the newer valid file.
+ */
+#ifndef ZVEC_CKPT_PAGE_BYTES
+#   define ZVEC_CKPT_PAGE_BYTES 4096
+#endif
+
+typedef struct
+{
+    uint64_t *bits;         // Pages dirtied since the last checkpoint.
+    uint64_t *prev;         // Pages dirtied in the interval before that.
+    size_t words;
+    size_t page_elems;
+    uint64_t nonce;         // Identifies this tracker's files.
+    uint64_t generation;    // Last committed checkpoint.
+    uint64_t slot_gen[2];   // Generation each file holds, 0 if unknown.
+} zvec_dirty;
+
+static inline void zvec_dirty_init_impl(zvec_dirty *d, size_t elem_size)
+{
+    struct timespec ts;
+    uint64_t x;
+    memset(d, 0, sizeof(zvec_dirty));
+    d->page_elems = (ZVEC_CKPT_PAGE_BYTES >= elem_size)
+                  ? ZVEC_CKPT_PAGE_BYTES / elem_size : 1;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    x = ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec) ^
+        ((uint64_t)getpid() << 40) ^ (uint64_t)(uintptr_t)d;
+    x += 0x9E3779B97F4A7C15ULL;     // splitmix64 finalizer.
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    d->nonce = (x ^ (x >> 31)) | 1;
+}
+
+static inline void zvec_dirty_free_impl(zvec_dirty *d)
+{
+    ZVEC_FREE(d->bits);
+    ZVEC_FREE(d->prev);
+    d->bits = d->prev = NULL;
+    d->words = 0;
+}
+
+// Marks the pages overlapping elements [first, end).
+static inline void zvec_dirty_mark_impl(zvec_dirty *d, size_t first, size_t end)
+{
+    size_t p, last;
+    if (first >= end)
+    {
+        return;
+    }
+    p = first / d->page_elems;
+    last = (end - 1) / d->page_elems;
+    if (last / 64 >= d->words)
+    {
+        size_t words = d->words ? d->words : Z_GROWTH_FACTOR(0);
+        uint64_t *bits, *prev;
+        while (words <= last / 64)
+        {
+            words = Z_GROWTH_FACTOR(words);
+        }
+        bits = (uint64_t *)ZVEC_REALLOC(d->bits, words * sizeof(uint64_t));
+        if (bits)
+        {
+            d->bits = bits;
+        }
+        prev = bits ? (uint64_t *)ZVEC_REALLOC(d->prev, words * sizeof(uint64_t)) : NULL;
+        if (!prev)
+        {
+            // The mark is lost: both files need a full rewrite.
+            d->slot_gen[0] = d->slot_gen[1] = 0;
+            return;
+        }
+        d->prev = prev;
+        memset(bits + d->words, 0, (words - d->words) * sizeof(uint64_t));
+        memset(prev + d->words, 0, (words - d->words) * sizeof(uint64_t));
+        d->words = words;
+    }
+    for (; p <= last && (p % 64); ++p)
+    {
+        d->bits[p / 64] |= (uint64_t)1 << (p % 64);
+    }
+    for (; p + 63 <= last; p += 64)
+    {
+        d->bits[p / 64] = ~(uint64_t)0;
+    }
+    for (; p <= last; ++p)
+    {
+        d->bits[p / 64] |= (uint64_t)1 << (p % 64);
+    }
+}
+
+// Dirty pages of word w for an incremental write (both intervals).
+static inline uint64_t zvec_dirty_word_impl(const zvec_dirty *d, size_t w)
+{
+    return (w < d->words) ? d->bits[w] | d->prev[w] : 0;
+}
+
+// Writes the header for 'length' elements with the given flags and syncs it.
+static inline int zvec_checkpoint_header_impl(int fd, size_t elem_size, size_t align,
+                                              size_t length, uint32_t flags,
+                                              uint64_t nonce, uint64_t generation)
+{
+    zvec_file_header h;
+    zvec_file_header_init_impl(&h, elem_size, align, length, 0);
+    h.flags = flags;
+    h.nonce = nonce;
+    h.generation = generation;
+    if (Z_OK != zvec_pwrite_all_impl(fd, &h, sizeof(h), 0))
+    {
+        return Z_ERR;
+    }
+    if (!(flags & ZVEC_FILE_TORN) &&
+        0 != ftruncate(fd, (off_t)(ZVEC_FILE_HEADER_SIZE + (uint64_t)length * elem_size)))
+    {
+        return Z_ERR;
+    }
+    return (0 == ZVEC_FDATASYNC(fd)) ? Z_OK : Z_ERR;
+}
+
+/*
+ * Writes checkpoint generation + 1 of data[0, length) into the next file of
+ * the pair, rewriting only the pages dirtied since that file was written when
+ * it still holds exactly that state. Returns Z_OK once durable; on failure the
+ * other file still holds the previous checkpoint.
+ */
+static inline int zvec_checkpoint_impl(zvec_dirty *d, int fd_a, int fd_b,
+                                       const void *data, size_t length, size_t elem_size,
+                                       size_t align)
+{
+    uint64_t gen = d->generation + 1;
+    int slot = (int)((gen - 1) & 1);
+    int fd = slot ? fd_b : fd_a;
+    size_t pages = (length + d->page_elems - 1) / d->page_elems;
+    size_t p = 0;
+    int full = (0 == d->slot_gen[slot] || d->slot_gen[slot] + 2 != gen);
+    if (!full)
+    {
+        zvec_file_header h;
+        struct stat st;
+        full = (0 != fstat(fd, &st) ||
+                Z_OK != zvec_pread_all_impl(fd, &h, sizeof(h), 0) ||
+                Z_OK != zvec_file_header_check_impl(&h, elem_size, align,
+                                                    (uint64_t)st.st_size) ||
+                h.nonce != d->nonce || h.generation != d->slot_gen[slot]);
+    }
+    d->slot_gen[slot] = 0;
+    if (Z_OK != zvec_checkpoint_header_impl(fd, elem_size, align, length,
+                                            ZVEC_FILE_LIVE | ZVEC_FILE_TORN, d->nonce, 0))
+    {
+        return Z_ERR;
+    }
+    while (p < pages)
+    {
+        size_t q, first, end;
+        if (!full && 0 == (zvec_dirty_word_impl(d, p / 64) >> (p % 64)))
+        {
+            p = (p / 64 + 1) * 64;      // Rest of this word is clean.
+            continue;
+        }
+        if (!full && !((zvec_dirty_word_impl(d, p / 64) >> (p % 64)) & 1))
+        {
+            p++;
+            continue;
+        }
+        q = full ? pages : p + 1;
+        while (q < pages && ((zvec_dirty_word_impl(d, q / 64) >> (q % 64)) & 1))
+        {
+            q++;
+        }
+        first = p * d->page_elems;
+        end = (q * d->page_elems < length) ? q * d->page_elems : length;
+        if (Z_OK != zvec_pwrite_all_impl(fd, (const char *)data + first * elem_size,
+                                         (end - first) * elem_size,
+                                         ZVEC_FILE_HEADER_SIZE + (uint64_t)first * elem_size))
+        {
+            return Z_ERR;
+        }
+        p = q;
+    }
+    if (0 != ZVEC_FDATASYNC(fd) ||
+        Z_OK != zvec_checkpoint_header_impl(fd, elem_size, align, length, ZVEC_FILE_LIVE,
+                                            d->nonce, gen))
+    {
+        return Z_ERR;
+    }
+    if (d->words)
+    {
+        uint64_t *t = d->prev;
+        d->prev = d->bits;
+        d->bits = t;
+        memset(d->bits, 0, d->words * sizeof(uint64_t));
+    }
+    d->slot_gen[slot] = gen;
+    d->generation = gen;
+    return Z_OK;
+}
+
+/*
+ * Returns 0 or 1 for whichever of the two checkpoint files holds the newer
+ * valid checkpoint, or Z_ENOTFOUND if neither does.
+ */
+static inline int zvec_checkpoint_pick(int fd_a, int fd_b)
+{
+    uint64_t best = 0;
+    int i, pick = Z_ENOTFOUND;
+    for (i = 0; i < 2; ++i)
+    {
+        zvec_file_header h;
+        struct stat st;
+        int fd = i ? fd_b : fd_a;
+        if (0 == fstat(fd, &st) && Z_OK == zvec_pread_all_impl(fd, &h, sizeof(h), 0) &&
+            Z_OK == zvec_file_header_check_impl(&h, 0, 0, (uint64_t)st.st_size) &&
+            h.generation > best)
+        {
+            best = h.generation;
+            pick = i;
+        }
+    }
+    return pick;
+}
+
+/*
+ * Durable append log (also requires ZVEC_ENABLE_THREADS).
+ *
+ * After the header (flagged ZVEC_FILE_LOG) every push/extend batch is one frame:
+ * { uint32 count, uint32 check } plus count raw elements. Appenders stage their
+ * frame in a shared buffer and wait until it is durable. The first waiter
+ * becomes the leader: it takes the whole buffer, writes it with one write and
+ * one fdatasync outside the lock, and wakes everyone it covered. Frames staged
+ * meanwhile go out in the next leader's batch, so the fdatasync cost is shared
+ * by every concurrent commit. Recovery keeps the intact prefix of frames and
+ * truncates a torn or corrupt tail.
+ */
+#if ZVEC_HAS_THREADS
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t check;
+} zvec_log_frame;
+
+typedef struct
+{
+    int fd;
+    int flushing;           // A leader is writing outside the lock.
+    int failed;             // Sticky: a write or sync failed, the log is read-only.
+    pthread_mutex_t lock;
+    pthread_cond_t flushed;
+    char *pending;          // Staged frames, not yet handed to a leader.
+    size_t pending_len;
+    size_t pending_cap;
+    char *spare;            // Buffer the leader writes from.
+    size_t spare_cap;
+    uint64_t staged;        // Tickets: frames staged so far.
+    uint64_t durable;       // Frames known to be on disk.
+    uint64_t syncs;         // Number of write + fdatasync rounds.
+} zvec_log_core;
+
+static inline uint32_t zvec_log_check_impl(uint32_t count, const void *payload,
+                                           size_t bytes)
+{
+    uint64_t h = zvec_checksum_impl(ZVEC_CHECKSUM_SEED ^ count, payload, bytes);
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+/*
+ * Reads the frames after the header into one ZVEC_MALLOC'd buffer with the
+ * payloads packed back to back, and truncates the file after the last intact
+ * frame. *out is NULL when the log is empty.
+ */
+static inline int zvec_log_recover_impl(int fd, size_t elem_size, uint64_t file_size,
+                                        void **out, size_t *count)
+{
+    size_t body = (size_t)(file_size - ZVEC_FILE_HEADER_SIZE);
+    size_t rd = 0, wr = 0;
+    char *buf = NULL;
+    *out = NULL;
+    *count = 0;
+    if (0 == body)
+    {
+        return Z_OK;
+    }
+    buf = (char *)ZVEC_MALLOC(body);
+    if (!buf)
+    {
+        return Z_ENOMEM;
+    }
+    if (Z_OK != zvec_read_all_impl(fd, buf, body))
+    {
+        ZVEC_FREE(buf);
+        return Z_ERR;
+    }
+    while (body - rd >= sizeof(zvec_log_frame))
+    {
+        zvec_log_frame fr;
+        size_t bytes;
+        memcpy(&fr, buf + rd, sizeof(fr));
+        if (0 == fr.count || fr.count > (body - rd - sizeof(fr)) / elem_size)
+        {
+            break;
+        }
+        bytes = (size_t)fr.count * elem_size;
+        if (fr.check != zvec_log_check_impl(fr.count, buf + rd + sizeof(fr), bytes))
+        {
+            break;
+        }
+        memmove(buf + wr, buf + rd + sizeof(fr), bytes);
+        rd += sizeof(fr) + bytes;
+        wr += bytes;
+    }
+    if (rd != body && (0 != ftruncate(fd, (off_t)(ZVEC_FILE_HEADER_SIZE + rd)) ||
+                       0 != ZVEC_FDATASYNC(fd)))
+    {
+        ZVEC_FREE(buf);
+        return Z_ERR;
+    }
+    if (0 == wr)
+    {
+        ZVEC_FREE(buf);
+        return Z_OK;
+    }
+    *out = buf;
+    *count = wr / elem_size;
+    return Z_OK;
+}
+
+// Opens or creates a log and recovers its elements (see zvec_log_recover_impl).
+static inline int zvec_log_open_impl(zvec_log_core *c, const char *path, size_t elem_size,
+                                     size_t align, void **out, size_t *count)
+{
+    zvec_file_header h;
+    struct stat st;
+    int rc;
+    memset(c, 0, sizeof(zvec_log_core));
+    c->fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (c->fd < 0)
+    {
+        return Z_ERR;
+    }
+    if (0 != fstat(c->fd, &st))
+    {
+        return zvec_file_fail_impl(c->fd);
+    }
+    if (0 == st.st_size)
+    {
+        zvec_file_header_init_impl(&h, elem_size, align, 0, 0);
+        h.flags = ZVEC_FILE_LOG;
+        if (Z_OK != zvec_write_all_impl(c->fd, &h, sizeof(h)) || 0 != ZVEC_FDATASYNC(c->fd))
+        {
+            return zvec_file_fail_impl(c->fd);
+        }
+        st.st_size = ZVEC_FILE_HEADER_SIZE;
+    }
+    else
+    {
+        rc = zvec_read_all_impl(c->fd, &h, sizeof(h));
+        if (Z_OK == rc)
+        {
+            rc = (h.flags & ZVEC_FILE_LOG) ? Z_OK : Z_EINVAL;
+            h.flags &= ~ZVEC_FILE_LOG;
+        }
+        if (Z_OK == rc)
+        {
+            rc = zvec_file_header_check_impl(&h, elem_size, align, (uint64_t)st.st_size);
+        }
+        if (Z_OK != rc)
+        {
+            close(c->fd);
+            return (Z_ERR == rc) ? Z_ERR : Z_EINVAL;
+        }
+    }
+    rc = zvec_log_recover_impl(c->fd, elem_size, (uint64_t)st.st_size, out, count);
+    if (Z_OK != rc)
+    {
+        close(c->fd);
+        return rc;
+    }
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->flushed, NULL);
+    return Z_OK;
+}
+
+// Appends one frame to the pending buffer (lock held) and returns its ticket.
+static inline int zvec_log_stage_impl(zvec_log_core *c, const void *items, size_t count,
+                                      size_t elem_size, uint64_t *ticket)
+{
+    size_t bytes = count * elem_size;
+    size_t need = c->pending_len + sizeof(zvec_log_frame) + bytes;
+    zvec_log_frame fr;
+    if (c->failed)
+    {
+        return Z_ERR;
+    }
+    if (count > UINT32_MAX)
+    {
+        return Z_EINVAL;
+    }
+    if (need > c->pending_cap)
+    {
+        size_t new_cap = c->pending_cap ? c->pending_cap : 4096;
+        char *fresh;
+        while (new_cap < need)
+        {
+            new_cap = Z_GROWTH_FACTOR(new_cap);
+        }
+        fresh = (char *)ZVEC_REALLOC(c->pending, new_cap);
+        if (!fresh)
+        {
+            return Z_ENOMEM;
+        }
+        c->pending = fresh;
+        c->pending_cap = new_cap;
+    }
+    fr.count = (uint32_t)count;
+    fr.check = zvec_log_check_impl(fr.count, items, bytes);
+    memcpy(c->pending + c->pending_len, &fr, sizeof(fr));
+    memcpy(c->pending + c->pending_len + sizeof(fr), items, bytes);
+    c->pending_len = need;
+    *ticket = ++c->staged;
+    return Z_OK;
+}
+
+// Blocks (lock held) until frame 'ticket' is durable, leading a flush if none runs.
+static inline int zvec_log_wait_impl(zvec_log_core *c, uint64_t ticket)
+{
+    while (c->durable < ticket && !c->failed)
+    {
+        if (c->flushing)
+        {
+            pthread_cond_wait(&c->flushed, &c->lock);
+            continue;
+        }
+        {
+            char *batch = c->pending;
+            size_t batch_cap = c->pending_cap;
+            size_t len = c->pending_len;
+            uint64_t upto = c->staged;
+            int rc;
+            c->pending = c->spare;
+            c->pending_cap = c->spare_cap;
+            c->pending_len = 0;
+            c->spare = NULL;
+            c->spare_cap = 0;
+            c->flushing = 1;
+            pthread_mutex_unlock(&c->lock);
+
+            rc = zvec_write_all_impl(c->fd, batch, len);
+            if (Z_OK == rc && 0 != ZVEC_FDATASYNC(c->fd))
+            {
+                rc = Z_ERR;
+            }
+
+            pthread_mutex_lock(&c->lock);
+            c->spare = batch;
+            c->spare_cap = batch_cap;
+            c->flushing = 0;
+            c->syncs++;
+            if (Z_OK == rc)
+            {
+                c->durable = upto;
+            }
+            else
+            {
+                c->failed = 1;
+            }
+            pthread_cond_broadcast(&c->flushed);
+        }
+    }
+    return (c->durable >= ticket) ? Z_OK : Z_ERR;
+}
+
+static inline void zvec_log_close_impl(zvec_log_core *c)
+{
+    close(c->fd);
+    pthread_mutex_destroy(&c->lock);
+    pthread_cond_destroy(&c->flushed);
+    ZVEC_FREE(c->pending);
+    ZVEC_FREE(c->spare);
+    c->fd = -1;
+}
+
+#define ZVEC_GEN_LOG_IMPL(T, Name)                                                          \
+                                                                                            \
+    /*                                                                                      \
+     * Durable append log. 'vec' holds every element recovered or appended;                 \
+     * read it once appenders are done, or under core.lock.                                 \
+     */                                                                                     \
+    typedef struct                                                                          \
+    {                                                                                       \
+        zvec_##Name vec;                                                                    \
+        zvec_log_core core;                                                                 \
+    } zvec_log_##Name;                                                                      \
+                                                                                            \
+    /* Opens or creates path and rebuilds 'vec' from its intact frames. */                  \
+    static inline int zvec_log_open_##Name(zvec_log_##Name *l, const char *path)            \
+    {                                                                                       \
+        void *buf = NULL;                                                                   \
+        size_t n = 0;                                                                       \
+        int rc;                                                                             \
+        memset(&l->vec, 0, sizeof(zvec_##Name));                                            \
+        rc = zvec_log_open_impl(&l->core, path, sizeof(T), _Alignof(T), &buf, &n);          \
+        if (Z_OK == rc)                                                                     \
+        {                                                                                   \
+            l->vec.data = (T *)buf;                                                         \
+            l->vec.length = n;                                                              \
+            l->vec.capacity = n;                                                            \
+        }                                                                                   \
+        return rc;                                                                          \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Journals the batch as one frame and returns once it is on disk (Z_OK), or            \
+     * an error once the log has failed, leaving 'vec' without the batch.                   \
+     * Thread-safe; concurrent calls share a write + fdatasync.                             \
+     */                                                                                     \
+    static inline int zvec_log_extend_##Name(zvec_log_##Name *l, const T *items,            \
+                                             size_t count)                                  \
+    {                                                                                       \
+        uint64_t ticket = 0;                                                                \
+        size_t i, len;                                                                      \
+        int rc;                                                                             \
+        if (0 == count)                                                                     \
+        {                                                                                   \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+        pthread_mutex_lock(&l->core.lock);                                                  \
+        len = l->vec.length;                                                                \
+        if (len + count > l->vec.capacity)                                                  \
+        {                                                                                   \
+            size_t new_cap = l->vec.capacity ? l->vec.capacity : Z_GROWTH_FACTOR(0);        \
+            while (new_cap < len + count)                                                   \
+            {                                                                               \
+                new_cap = Z_GROWTH_FACTOR(new_cap);                                         \
+            }                                                                               \
+            if (Z_OK != zvec_reserve_##Name(&l->vec, new_cap))                              \
+            {                                                                               \
+                pthread_mutex_unlock(&l->core.lock);                                        \
+                return Z_ENOMEM;                                                            \
+            }                                                                               \
+        }                                                                                   \
+        rc = zvec_log_stage_impl(&l->core, items, count, sizeof(T), &ticket);               \
+        if (Z_OK == rc)                                                                     \
+        {                                                                                   \
+            for (i = 0; i < count; ++i)                                                     \
+            {                                                                               \
+                l->vec.data[len + i] = items[i];                                            \
+            }                                                                               \
+            l->vec.length = len + count;                                                    \
+            rc = zvec_log_wait_impl(&l->core, ticket);                                      \
+            if (Z_OK != rc && l->vec.length > len)                                          \
+            {                                                                               \
+                /* Not journaled: drop it, with any later batches (also failed). */         \
+                l->vec.length = len;                                                        \
+            }                                                                               \
+        }                                                                                   \
+        pthread_mutex_unlock(&l->core.lock);                                                \
+        return rc;                                                                          \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_log_push_##Name(zvec_log_##Name *l, T value)                     \
+    {                                                                                       \
+        return zvec_log_extend_##Name(l, &value, 1);                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Closes the file and frees 'vec'. Call once appenders are done. */                    \
+    static inline void zvec_log_close_##Name(zvec_log_##Name *l)                            \
+    {                                                                                       \
+        zvec_log_close_impl(&l->core);                                                      \
+        zvec_free_##Name(&l->vec);                                                          \
+    }                                                                                       \
+                                                                                            \
+    /* Crash-recovery loader: rebuilds *out from path and closes the log. */                \
+    static inline int zvec_log_load_##Name(const char *path, zvec_##Name *out)              \
+    {                                                                                       \
+        zvec_log_##Name l;                                                                  \
+        int rc = zvec_log_open_##Name(&l, path);                                            \
+        if (Z_OK == rc)                                                                     \
+        {                                                                                   \
+            *out = l.vec;                                                                   \
+            memset(&l.vec, 0, sizeof(zvec_##Name));                                         \
+            zvec_log_close_##Name(&l);                                                      \
+        }                                                                                   \
+        return rc;                                                                          \
+    }
+
+
+/*
+ * Double-buffered streaming loader (also requires ZVEC_ENABLE_THREADS).
+ *
+ * A background thread reads the next chunk of records into one buffer while
+ * the caller works on the other. zvec_stream_next_chunk hands the caller the
+ * filled buffer and gives its previous one back to the loader, so chunks are
+ * never copied and I/O overlaps processing.
+ */
+typedef struct
+{
+    int fd;
+    int stop;
+    int eof;                // The loader has read its last chunk.
+    int error;              // Z_* code of a failed read, or Z_OK.
+    size_t elem_size;
+    size_t chunk_bytes;
+    void *bufs[2];
+    void *target;           // Buffer the loader fills next (NULL: waiting for one).
+    void *filled;           // Completed chunk not yet taken (NULL: none).
+    size_t filled_bytes;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} zvec_stream_core;
+
+static inline void *zvec_stream_loader_impl(void *arg)
+{
+    zvec_stream_core *c = (zvec_stream_core *)arg;
+    pthread_mutex_lock(&c->lock);
+    while (!c->stop && !c->eof && Z_OK == c->error)
+    {
+        void *buf;
+        size_t got = 0;
+        int rc;
+        while (!c->stop && !c->target)
+        {
+            pthread_cond_wait(&c->cond, &c->lock);
+        }
+        if (c->stop)
+        {
+            break;
+        }
+        buf = c->target;
+        c->target = NULL;
+        pthread_mutex_unlock(&c->lock);
+
+        rc = zvec_read_records_impl(c->fd, buf, c->chunk_bytes, c->elem_size, &got);
+
+        pthread_mutex_lock(&c->lock);
+        c->filled = buf;
+        c->filled_bytes = got - got % c->elem_size;
+        c->error = rc;
+        c->eof = (got < c->chunk_bytes);
+        pthread_cond_broadcast(&c->cond);
+    }
+    pthread_mutex_unlock(&c->lock);
+    return NULL;
+}
+
+static inline int zvec_stream_open_impl(zvec_stream_core *c, const char *path,
+                                        size_t elem_size, size_t chunk_elems)
+{
+    memset(c, 0, sizeof(zvec_stream_core));
+    c->elem_size = elem_size;
+    c->chunk_bytes = (chunk_elems ? chunk_elems : 1) * elem_size;
+    c->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (c->fd < 0)
+    {
+        return Z_ERR;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(c->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    c->bufs[0] = ZVEC_MALLOC(c->chunk_bytes);
+    c->bufs[1] = ZVEC_MALLOC(c->chunk_bytes);
+    if (!c->bufs[0] || !c->bufs[1])
+    {
+        ZVEC_FREE(c->bufs[0]);
+        ZVEC_FREE(c->bufs[1]);
+        close(c->fd);
+        return Z_ENOMEM;
+    }
+    c->target = c->bufs[1];
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->cond, NULL);
+    if (0 != pthread_create(&c->thread, NULL, zvec_stream_loader_impl, c))
+    {
+        pthread_mutex_destroy(&c->lock);
+        pthread_cond_destroy(&c->cond);
+        ZVEC_FREE(c->bufs[0]);
+        ZVEC_FREE(c->bufs[1]);
+        close(c->fd);
+        return Z_ERR;
+    }
+    return Z_OK;
+}
+
+/*
+ * Waits for the next chunk and swaps it with 'current' (the buffer the caller
+ * is done with, or NULL the first time it is the spare). Returns the chunk
+ * and its size in *bytes, or NULL at the end (*bytes 0) or on error.
+ */
+static inline void *zvec_stream_next_impl(zvec_stream_core *c, void *current, size_t *bytes)
+{
+    void *chunk = NULL;
+    *bytes = 0;
+    pthread_mutex_lock(&c->lock);
+    while (!c->filled && !c->eof && Z_OK == c->error)
+    {
+        pthread_cond_wait(&c->cond, &c->lock);
+    }
+    if (c->filled && c->filled_bytes)
+    {
+        chunk = c->filled;
+        *bytes = c->filled_bytes;
+        c->filled = NULL;
+        if (!c->eof && Z_OK == c->error)
+        {
+            c->target = current ? current : c->bufs[0];
+            pthread_cond_broadcast(&c->cond);
+        }
+    }
+    else
+    {
+        c->filled = NULL;
+    }
+    pthread_mutex_unlock(&c->lock);
+    return chunk;
+}
+
+static inline void zvec_stream_close_impl(zvec_stream_core *c)
+{
+    pthread_mutex_lock(&c->lock);
+    c->stop = 1;
+    pthread_cond_broadcast(&c->cond);
+    pthread_mutex_unlock(&c->lock);
+    pthread_join(c->thread, NULL);
+    pthread_mutex_destroy(&c->lock);
+    pthread_cond_destroy(&c->cond);
+    ZVEC_FREE(c->bufs[0]);
+    ZVEC_FREE(c->bufs[1]);
+    close(c->fd);
+    c->fd = -1;
+}
+
+#define ZVEC_GEN_STREAM_IMPL(T, Name)                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Streaming loader. 'chunk' is the caller's current chunk: a read-only view            \
+     * (never push to or free it) valid until the next zvec_stream_next_chunk.              \
+     */                                                                                     \
+    typedef struct                                                                          \
+    {                                                                                       \
+        zvec_##Name chunk;                                                                  \
+        zvec_stream_core core;                                                              \
+    } zvec_stream_##Name;                                                                   \
+                                                                                            \
+    /* Starts loading path in chunks of chunk_elems records. */                             \
+    static inline int zvec_stream_open_##Name(zvec_stream_##Name *s, const char *path,      \
+                                              size_t chunk_elems)                           \
+    {                                                                                       \
+        memset(&s->chunk, 0, sizeof(zvec_##Name));                                          \
+        return zvec_stream_open_impl(&s->core, path, sizeof(T), chunk_elems);               \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Hands over the next chunk (recycling the previous one) or returns NULL at            \
+     * the end of the file; core.error is then Z_OK, or the failure (Z_EINVAL:              \
+     * the file ends inside a record).                                                      \
+     */                                                                                     \
+    static inline zvec_##Name *zvec_stream_next_chunk_##Name(zvec_stream_##Name *s)         \
+    {                                                                                       \
+        size_t bytes;                                                                       \
+        T *data = (T *)zvec_stream_next_impl(&s->core, s->chunk.data, &bytes);              \
+        s->chunk.data = data;                                                               \
+        s->chunk.length = bytes / sizeof(T);                                                \
+        s->chunk.capacity = s->chunk.length;                                                \
+        return data ? &s->chunk : NULL;                                                     \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_stream_close_##Name(zvec_stream_##Name *s)                      \
+    {                                                                                       \
+        zvec_stream_close_impl(&s->core);                                                   \
+        memset(&s->chunk, 0, sizeof(zvec_##Name));                                          \
+    }
+
+#else
+#   define ZVEC_GEN_LOG_IMPL(T, Name)
+#   define ZVEC_GEN_STREAM_IMPL(T, Name)
+#endif // ZVEC_HAS_THREADS
+
+#define ZVEC_GEN_IO_IMPL(T, Name)                                                           \
+                                                                                            \
+    /* Writes the vector to path atomically (header + raw elements). */                     \
+    static inline int zvec_save_##Name(zvec_##Name *v, const char *path)                    \
+    {                                                                                       \
+        return zvec_save_impl(path, v->data, sizeof(T), _Alignof(T), v->length);            \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Maps a file written by zvec_save_##Name as a read-only view: a regular               \
+     * vector whose data points into the mapping, usable with zvec_at, the                  \
+     * searches and zvec_foreach. Never push to or free a view; release it with             \
+     * zvec_unmap_##Name. data is NULL on failure.                                          \
+     */                                                                                     \
+    static inline zvec_##Name zvec_view_mmap_##Name(const char *path)                       \
+    {                                                                                       \
+        zvec_##Name view;                                                                   \
+        size_t len = 0;                                                                     \
+        view.data = (T *)zvec_map_file_impl(path, sizeof(T), _Alignof(T), &len);            \
+        view.length = len;                                                                  \
+        view.capacity = len;                                                                \
+        return view;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_unmap_##Name(zvec_##Name *v)                                    \
+    {                                                                                       \
+        if (v->data)                                                                        \
+        {                                                                                   \
+            zvec_unmap_impl(v->data, v->length * sizeof(T));                                \
+        }                                                                                   \
+        memset(v, 0, sizeof(zvec_##Name));                                                  \
+    }
+
+
+#define ZVEC_GEN_FILE_IMPL(T, Name)                                                         \
+                                                                                            \
+    /*                                                                                      \
+     * Persistent vector. 'vec' is a regular vector over the mapping: read and              \
+     * modify it with zvec_at, zvec_foreach, the searches, etc., but grow it                \
+     * only through zvec_file_* (zvec_push(&f->vec) would realloc the mapping).             \
+     */                                                                                     \
+    typedef struct                                                                          \
+    {                                                                                       \
+        zvec_##Name vec;                                                                    \
+        int fd;                                                                             \
+    } zvec_file_##Name;                                                                     \
+                                                                                            \
+    static inline int zvec_file_open_##Name(zvec_file_##Name *f, const char *path)          \
+    {                                                                                       \
+        size_t cap = 0, len = 0;                                                            \
+        T *data = (T *)zvec_file_open_impl(path, sizeof(T), _Alignof(T), &f->fd,            \
+                                           &cap, &len);                                     \
+        if (!data)                                                                          \
+        {                                                                                   \
+            memset(f, 0, sizeof(zvec_file_##Name));                                         \
+            f->fd = -1;                                                                     \
+            return (EINVAL == errno) ? Z_EINVAL : Z_ERR;                                    \
+        }                                                                                   \
+        f->vec.data = data;                                                                 \
+        f->vec.length = len;                                                                \
+        f->vec.capacity = cap;                                                              \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_file_reserve_##Name(zvec_file_##Name *f, size_t new_cap)         \
+    {                                                                                       \
+        size_t old_bytes = ZVEC_FILE_HEADER_SIZE + f->vec.capacity * sizeof(T);             \
+        T *fresh;                                                                           \
+        if (new_cap <= f->vec.capacity)                                                     \
+        {                                                                                   \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+        fresh = (T *)zvec_file_remap_impl(f->fd, f->vec.data, old_bytes,                    \
+                                          ZVEC_FILE_HEADER_SIZE + new_cap * sizeof(T));     \
+        if (!fresh)                                                                         \
+        {                                                                                   \
+            return Z_ERR;                                                                   \
+        }                                                                                   \
+        f->vec.data = fresh;                                                                \
+        f->vec.capacity = new_cap;                                                          \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_file_extend_##Name(zvec_file_##Name *f, const T *items,          \
+                                              size_t count)                                 \
+    {                                                                                       \
+        size_t i, len = f->vec.length;                                                      \
+        if (len + count > f->vec.capacity)                                                  \
+        {                                                                                   \
+            size_t new_cap = f->vec.capacity ? f->vec.capacity : Z_GROWTH_FACTOR(0);        \
+            while (new_cap < len + count)                                                   \
+            {                                                                               \
+                new_cap = Z_GROWTH_FACTOR(new_cap);                                         \
+            }                                                                               \
+            if (Z_OK != zvec_file_reserve_##Name(f, new_cap))                               \
+            {                                                                               \
+                return Z_ERR;                                                               \
+            }                                                                               \
+        }                                                                                   \
+        for (i = 0; i < count; ++i)                                                         \
+        {                                                                                   \
+            f->vec.data[len + i] = items[i];                                                \
+        }                                                                                   \
+        f->vec.length = len + count;                                                        \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_file_push_##Name(zvec_file_##Name *f, T value)                   \
+    {                                                                                       \
+        return zvec_file_extend_##Name(f, &value, 1);                                       \
+    }                                                                                       \
+                                                                                            \
+    /* Checkpoint: everything pushed so far survives a crash once this returns. */          \
+    static inline int zvec_file_sync_##Name(zvec_file_##Name *f)                            \
+    {                                                                                       \
+        return zvec_file_sync_impl(f->vec.data, f->vec.length, sizeof(T));                  \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_file_close_##Name(zvec_file_##Name *f)                           \
+    {                                                                                       \
+        int rc = Z_OK;                                                                      \
+        if (f->vec.data)                                                                    \
+        {                                                                                   \
+            rc = zvec_file_close_impl(f->fd, f->vec.data, f->vec.length, f->vec.capacity,   \
+                                      sizeof(T));                                           \
+        }                                                                                   \
+        memset(f, 0, sizeof(zvec_file_##Name));                                             \
+        f->fd = -1;                                                                         \
+        return rc;                                                                          \
+    }
+
+#define ZVEC_GEN_SHM_IMPL(T, Name)                                                          \
+                                                                                            \
+    /*                                                                                      \
+     * Shared-memory vector handle. 'vec' views this process's mapping: the                 \
+     * writer's is always current, a reader's as of its last zvec_shm_refresh.              \
+     */                                                                                     \
+    typedef struct                                                                          \
+    {                                                                                       \
+        zvec_##Name vec;                                                                    \
+        int fd;                                                                             \
+        int writer;                                                                         \
+    } zvec_shm_##Name;                                                                      \
+                                                                                            \
+    /* Writer: creates the named object with room for cap elements. */                      \
+    static inline int zvec_shm_create_##Name(zvec_shm_##Name *s, const char *name,          \
+                                             size_t cap)                                    \
+    {                                                                                       \
+        T *data = (T *)zvec_shm_create_impl(name, sizeof(T), _Alignof(T), cap, &s->fd);     \
+        memset(&s->vec, 0, sizeof(zvec_##Name));                                            \
+        s->writer = 1;                                                                      \
+        if (!data)                                                                          \
+        {                                                                                   \
+            s->fd = -1;                                                                     \
+            return (EINVAL == errno) ? Z_EINVAL : (EEXIST == errno) ? Z_EEXIST : Z_ERR;     \
+        }                                                                                   \
+        s->vec.data = data;                                                                 \
+        s->vec.capacity = cap;                                                              \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Reader: picks up elements published since the last call; returns the length. */      \
+    static inline size_t zvec_shm_refresh_##Name(zvec_shm_##Name *s)                        \
+    {                                                                                       \
+        s->vec.data = (T *)zvec_shm_refresh_impl(s->fd, s->vec.data, sizeof(T),             \
+                                                 &s->vec.capacity, &s->vec.length);         \
+        return s->vec.length;                                                               \
+    }                                                                                       \
+                                                                                            \
+    /* Reader: maps the named object. Z_EEMPTY while it is still being created. */          \
+    static inline int zvec_shm_attach_##Name(zvec_shm_##Name *s, const char *name)          \
+    {                                                                                       \
+        size_t cap = 0;                                                                     \
+        T *data = (T *)zvec_shm_attach_impl(name, sizeof(T), _Alignof(T), &cap, &s->fd);    \
+        memset(&s->vec, 0, sizeof(zvec_##Name));                                            \
+        s->writer = 0;                                                                      \
+        if (!data)                                                                          \
+        {                                                                                   \
+            s->fd = -1;                                                                     \
+            return (EAGAIN == errno) ? Z_EEMPTY : (EINVAL == errno) ? Z_EINVAL              \
+                 : (ENOENT == errno) ? Z_ENOTFOUND : Z_ERR;                                 \
+        }                                                                                   \
+        s->vec.data = data;                                                                 \
+        s->vec.capacity = cap;                                                              \
+        zvec_shm_refresh_##Name(s);                                                         \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Writer: appends and publishes the batch (release store of the length). */            \
+    static inline int zvec_shm_extend_##Name(zvec_shm_##Name *s, const T *items,            \
+                                             size_t count)                                  \
+    {                                                                                       \
+        size_t i, len = s->vec.length;                                                      \
+        assert(s->writer && "Only the creating process may append");                        \
+        if (len + count > s->vec.capacity)                                                  \
+        {                                                                                   \
+            size_t new_cap = s->vec.capacity ? s->vec.capacity : Z_GROWTH_FACTOR(0);        \
+            T *fresh;                                                                       \
+            while (new_cap < len + count)                                                   \
+            {                                                                               \
+                new_cap = Z_GROWTH_FACTOR(new_cap);                                         \
+            }                                                                               \
+            fresh = (T *)zvec_shm_grow_impl(s->fd, s->vec.data, sizeof(T),                  \
+                                            s->vec.capacity, new_cap);                      \
+            if (!fresh)                                                                     \
+            {                                                                               \
+                return Z_ERR;                                                               \
+            }                                                                               \
+            s->vec.data = fresh;                                                            \
+            s->vec.capacity = new_cap;                                                      \
+        }                                                                                   \
+        for (i = 0; i < count; ++i)                                                         \
+        {                                                                                   \
+            s->vec.data[len + i] = items[i];                                                \
+        }                                                                                   \
+        s->vec.length = len + count;                                                        \
+        zvec_shm_publish_impl(s->vec.data, len + count);                                    \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_shm_push_##Name(zvec_shm_##Name *s, T value)                     \
+    {                                                                                       \
+        return zvec_shm_extend_##Name(s, &value, 1);                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Unmaps and closes (either role). The object lives on until zvec_shm_unlink. */       \
+    static inline void zvec_shm_detach_##Name(zvec_shm_##Name *s)                           \
+    {                                                                                       \
+        if (s->vec.data)                                                                    \
+        {                                                                                   \
+            munmap(zvec_shm_header_impl(s->vec.data),                                       \
+                   ZVEC_FILE_HEADER_SIZE + s->vec.capacity * sizeof(T));                    \
+            close(s->fd);                                                                   \
+        }                                                                                   \
+        memset(&s->vec, 0, sizeof(zvec_##Name));                                            \
+        s->fd = -1;                                                                         \
+    }
+
+#define ZVEC_GEN_XSORT_IMPL(T, Name)                                                        \
+                                                                                            \
+    /*                                                                                      \
+     * Stably sorts the raw T records of path_in into path_out using about                  \
+     * mem_budget bytes of memory. Returns Z_OK, Z_EINVAL if the input is not a             \
+     * whole number of records, or Z_ERR / Z_ENOMEM.                                        \
+     */                                                                                     \
+    static inline int zvec_external_sort_##Name(const char *path_in, const char *path_out,  \
+                                                int (*cmp)(const T *, const T *),           \
+                                                size_t mem_budget)                          \
+    {                                                                                       \
+        size_t cap = mem_budget / sizeof(T) / 3 * 2;   /* A third is merge scratch. */      \
+        zvec_##Name run, scratch;                                                           \
+        zvec_xsort x;                                                                       \
+        int rc = zvec_xsort_begin_impl(&x, path_in, path_out);                              \
+        memset(&run, 0, sizeof(zvec_##Name));                                               \
+        memset(&scratch, 0, sizeof(zvec_##Name));                                           \
+        if (Z_OK == rc && Z_OK != zvec_reserve_##Name(&run, cap ? cap : 1))                 \
+        {                                                                                   \
+            rc = Z_ENOMEM;                                                                  \
+        }                                                                                   \
+        while (Z_OK == rc)                                                                  \
+        {                                                                                   \
+            size_t got = 0;                                                                 \
+            rc = zvec_read_records_impl(x.in_fd, run.data, run.capacity * sizeof(T),        \
+                                        sizeof(T), &got);                                   \
+            if (Z_OK != rc || 0 == got)                                                     \
+            {                                                                               \
+                break;                                                                      \
+            }                                                                               \
+            run.length = got / sizeof(T);                                                   \
+            rc = zvec_stable_sort_##Name(&run, cmp, &scratch);                              \
+            if (Z_OK != rc)                                                                 \
+            {                                                                               \
+                break;                                                                      \
+            }                                                                               \
+            rc = zvec_xsort_spill_impl(&x, run.data, got, sizeof(T),                        \
+                                       got < run.capacity * sizeof(T));                     \
+            if (got < run.capacity * sizeof(T))                                             \
+            {                                                                               \
+                break;                                                                      \
+            }                                                                               \
+        }                                                                                   \
+        zvec_free_##Name(&run);                                                             \
+        zvec_free_##Name(&scratch);                                                         \
+        if (Z_OK == rc)                                                                     \
+        {                                                                                   \
+            rc = zvec_xsort_finish_impl(&x, sizeof(T),                                      \
+                                        (int (*)(const void *, const void *))cmp,           \
+                                        mem_budget);                                        \
+        }                                                                                   \
+        return zvec_xsort_end_impl(&x, rc);                                                 \
+    }
+
+#define ZVEC_GEN_PAGED_IMPL(T, Name)                                                        \
+                                                                                            \
+    /*                                                                                      \
+     * Paged vector. Element pointers returned below stay valid only until the              \
+     * next call on the same vector (it may evict their page).                              \
+     */                                                                                     \
+    typedef struct                                                                          \
+    {                                                                                       \
+        zvec_paged_core core;                                                               \
+    } zvec_paged_##Name;                                                                    \
+                                                                                            \
+    /* Backs the vector with path (NULL: a temporary file), max_pages resident. */          \
+    static inline int zvec_paged_open_##Name(zvec_paged_##Name *p, const char *path,        \
+                                             size_t max_pages)                              \
+    {                                                                                       \
+        return zvec_paged_open_impl(&p->core, path, sizeof(T), max_pages);                  \
+    }                                                                                       \
+                                                                                            \
+    static inline size_t zvec_paged_size_##Name(zvec_paged_##Name *p)                       \
+    {                                                                                       \
+        return p->core.length;                                                              \
+    }                                                                                       \
+                                                                                            \
+    /* Writable element (its page is written back on eviction), or NULL. */                 \
+    static inline T *zvec_paged_at_##Name(zvec_paged_##Name *p, size_t index)               \
+    {                                                                                       \
+        size_t pe = p->core.page_elems;                                                     \
+        T *page;                                                                            \
+        if (index >= p->core.length)                                                        \
+        {                                                                                   \
+            return NULL;                                                                    \
+        }                                                                                   \
+        page = (T *)zvec_paged_fetch_impl(&p->core, index / pe, 1);                         \
+        return page ? page + index % pe : NULL;                                             \
+    }                                                                                       \
+                                                                                            \
+    /* Read-only element; never dirties its page. */                                        \
+    static inline const T *zvec_paged_peek_##Name(zvec_paged_##Name *p, size_t index)       \
+    {                                                                                       \
+        size_t pe = p->core.page_elems;                                                     \
+        const T *page;                                                                      \
+        if (index >= p->core.length)                                                        \
+        {                                                                                   \
+            return NULL;                                                                    \
+        }                                                                                   \
+        page = (const T *)zvec_paged_fetch_impl(&p->core, index / pe, 0);                   \
+        return page ? page + index % pe : NULL;                                             \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_paged_extend_##Name(zvec_paged_##Name *p, const T *items,        \
+                                               size_t count)                                \
+    {                                                                                       \
+        size_t pe = p->core.page_elems;                                                     \
+        while (count > 0)                                                                   \
+        {                                                                                   \
+            size_t at = p->core.length % pe;                                                \
+            size_t n = (count < pe - at) ? count : pe - at;                                 \
+            size_t i;                                                                       \
+            T *page = (T *)zvec_paged_fetch_impl(&p->core, p->core.length / pe, 1);         \
+            if (!page)                                                                      \
+            {                                                                               \
+                return Z_ERR;                                                               \
+            }                                                                               \
+            for (i = 0; i < n; ++i)                                                         \
+            {                                                                               \
+                page[at + i] = items[i];                                                    \
+            }                                                                               \
+            p->core.length += n;                                                            \
+            items += n;                                                                     \
+            count -= n;                                                                     \
+        }                                                                                   \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_paged_push_##Name(zvec_paged_##Name *p, T value)                 \
+    {                                                                                       \
+        return zvec_paged_extend_##Name(p, &value, 1);                                      \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Read-only page 'page' and its element count in *count (used by                       \
+     * zvec_paged_foreach). Hints the next ZVEC_PAGED_READAHEAD pages.                      \
+     */                                                                                     \
+    static inline const T *zvec_paged_page_##Name(zvec_paged_##Name *p, size_t page,        \
+                                                  size_t *count)                            \
+    {                                                                                       \
+        size_t pe = p->core.page_elems;                                                     \
+        size_t first = page * pe;                                                           \
+        const T *data;                                                                      \
+        *count = 0;                                                                         \
+        if (first >= p->core.length)                                                        \
+        {                                                                                   \
+            return NULL;                                                                    \
+        }                                                                                   \
+        zvec_paged_prefetch_impl(&p->core, first + pe, ZVEC_PAGED_READAHEAD * pe);          \
+        data = (const T *)zvec_paged_fetch_impl(&p->core, page, 0);                         \
+        if (data)                                                                           \
+        {                                                                                   \
+            *count = (p->core.length - first < pe) ? p->core.length - first : pe;           \
+        }                                                                                   \
+        return data;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Hints that elements [first, first + count) will be read soon. */                     \
+    static inline void zvec_paged_prefetch_##Name(zvec_paged_##Name *p, size_t first,       \
+                                                  size_t count)                             \
+    {                                                                                       \
+        zvec_paged_prefetch_impl(&p->core, first, count);                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_paged_flush_##Name(zvec_paged_##Name *p)                         \
+    {                                                                                       \
+        return zvec_paged_flush_impl(&p->core);                                             \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_paged_close_##Name(zvec_paged_##Name *p)                         \
+    {                                                                                       \
+        return zvec_paged_close_impl(&p->core);                                             \
+    }
+
+#define ZVEC_GEN_FDIO_IMPL(T, Name)                                                         \
+                                                                                            \
+    /* Reserves room for 'extra' more elements, growing geometrically. */                   \
+    static inline int zvec_fd_reserve_##Name(zvec_##Name *v, size_t extra)                  \
+    {                                                                                       \
+        size_t need = v->length + extra;                                                    \
+        size_t new_cap;                                                                     \
+        if (need <= v->capacity)                                                            \
+        {                                                                                   \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+        new_cap = v->capacity ? v->capacity : Z_GROWTH_FACTOR(0);                           \
+        while (new_cap < need)                                                              \
+        {                                                                                   \
+            new_cap = Z_GROWTH_FACTOR(new_cap);                                             \
+        }                                                                                   \
+        return zvec_reserve_##Name(v, new_cap);                                             \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Appends up to max_elems elements read from fd with one read() (more only             \
+     * to finish an element when partial is NULL). Returns the number appended,             \
+     * 0 at end of input, or a negative Z_* code (Z_EEMPTY: would block).                   \
+     */                                                                                     \
+    static inline ssize_t zvec_read_fd_##Name(zvec_##Name *v, int fd, size_t max_elems,     \
+                                              size_t *partial)                              \
+    {                                                                                       \
+        ssize_t got;                                                                        \
+        if (0 == max_elems)                                                                 \
+        {                                                                                   \
+            return 0;                                                                       \
+        }                                                                                   \
+        if (Z_OK != zvec_fd_reserve_##Name(v, max_elems))                                   \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        got = zvec_read_fd_impl(fd, (char *)(v->data + v->length), max_elems * sizeof(T),   \
+                                sizeof(T), partial);                                        \
+        if (got > 0)                                                                        \
+        {                                                                                   \
+            v->length += (size_t)got;                                                       \
+        }                                                                                   \
+        return got;                                                                         \
+    }                                                                                       \
+                                                                                            \
+    /* Appends up to max_elems elements read at byte 'offset' (file position untouched). */ \
+    static inline ssize_t zvec_pread_fd_##Name(zvec_##Name *v, int fd, size_t max_elems,    \
+                                               uint64_t offset)                             \
+    {                                                                                       \
+        ssize_t got;                                                                        \
+        if (0 == max_elems)                                                                 \
+        {                                                                                   \
+            return 0;                                                                       \
+        }                                                                                   \
+        if (Z_OK != zvec_fd_reserve_##Name(v, max_elems))                                   \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        got = zvec_pread_fd_impl(fd, (char *)(v->data + v->length), max_elems * sizeof(T),  \
+                                 sizeof(T), offset);                                        \
+        if (got > 0)                                                                        \
+        {                                                                                   \
+            v->length += (size_t)got;                                                       \
+        }                                                                                   \
+        return got;                                                                         \
+    }                                                                                       \
+                                                                                            \
+    /* Writes every element to fd, resuming after short writes. */                          \
+    static inline int zvec_write_fd_##Name(zvec_##Name *v, int fd)                          \
+    {                                                                                       \
+        return zvec_write_all_impl(fd, v->data, v->length * sizeof(T));                     \
+    }
+
+#define ZVEC_GEN_CKPT_IMPL(T, Name)                                                         \
+                                                                                            \
+    /*                                                                                      \
+     * Vector with dirty-page tracking for zvec_checkpoint_##Name. Modify it                \
+     * through zvec_track_*, or call zvec_track_mark_##Name after changing                  \
+     * t->vec directly (sort, extend, ...): untracked writes are not saved.                 \
+     */                                                                                     \
+    typedef struct                                                                          \
+    {                                                                                       \
+        zvec_##Name vec;                                                                    \
+        zvec_dirty dirty;                                                                   \
+    } zvec_track_##Name;                                                                    \
+                                                                                            \
+    /* Starts empty; assigning an existing vector to t->vec afterwards is fine. */          \
+    static inline void zvec_track_init_##Name(zvec_track_##Name *t)                         \
+    {                                                                                       \
+        memset(&t->vec, 0, sizeof(zvec_##Name));                                            \
+        zvec_dirty_init_impl(&t->dirty, sizeof(T));                                         \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_track_free_##Name(zvec_track_##Name *t)                         \
+    {                                                                                       \
+        zvec_free_##Name(&t->vec);                                                          \
+        zvec_dirty_free_impl(&t->dirty);                                                    \
+        zvec_dirty_init_impl(&t->dirty, sizeof(T));                                         \
+    }                                                                                       \
+                                                                                            \
+    /* Marks elements [first, first + count) as modified. */                                \
+    static inline void zvec_track_mark_##Name(zvec_track_##Name *t, size_t first,           \
+                                              size_t count)                                 \
+    {                                                                                       \
+        zvec_dirty_mark_impl(&t->dirty, first, first + count);                              \
+    }                                                                                       \
+                                                                                            \
+    /* Writable element pointer (NULL out of range); marks its page dirty. */               \
+    static inline T *zvec_track_at_##Name(zvec_track_##Name *t, size_t index)               \
+    {                                                                                       \
+        T *e = zvec_at_##Name(&t->vec, index);                                              \
+        if (e)                                                                              \
+        {                                                                                   \
+            zvec_dirty_mark_impl(&t->dirty, index, index + 1);                              \
+        }                                                                                   \
+        return e;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    static inline T *zvec_track_push_slot_##Name(zvec_track_##Name *t)                      \
+    {                                                                                       \
+        T *slot = zvec_push_slot_##Name(&t->vec);                                           \
+        if (slot)                                                                           \
+        {                                                                                   \
+            zvec_dirty_mark_impl(&t->dirty, t->vec.length - 1, t->vec.length);              \
+        }                                                                                   \
+        return slot;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_track_push_##Name(zvec_track_##Name *t, T value)                 \
+    {                                                                                       \
+        T *slot = zvec_track_push_slot_##Name(t);                                           \
+        if (!slot)                                                                          \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        *slot = value;                                                                      \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Removes an element; every page from 'index' to the end shifts and is marked. */      \
+    static inline void zvec_track_remove_##Name(zvec_track_##Name *t, size_t index)         \
+    {                                                                                       \
+        if (index < t->vec.length)                                                          \
+        {                                                                                   \
+            zvec_dirty_mark_impl(&t->dirty, index, t->vec.length);                          \
+            zvec_remove_##Name(&t->vec, index);                                             \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    /*                                                                                      \
+     * Saves t->vec into fd_a and fd_b in turn (both opened read-write) as files            \
+     * zvec_view_mmap_##Name can load, writing only the pages modified since                \
+     * that file's last checkpoint. The other file keeps the previous one.                  \
+     */                                                                                     \
+    static inline int zvec_checkpoint_##Name(zvec_track_##Name *t, int fd_a, int fd_b)      \
+    {                                                                                       \
+        return zvec_checkpoint_impl(&t->dirty, fd_a, fd_b, t->vec.data, t->vec.length,      \
+                                    sizeof(T), _Alignof(T));                                \
+    }
+#else
+#   define ZVEC_GEN_IO_IMPL(T, Name)
+#   define ZVEC_GEN_FILE_IMPL(T, Name)
+#   define ZVEC_GEN_LOG_IMPL(T, Name)
+#   define ZVEC_GEN_SHM_IMPL(T, Name)
+#   define ZVEC_GEN_XSORT_IMPL(T, Name)
+#   define ZVEC_GEN_PAGED_IMPL(T, Name)
+#   define ZVEC_GEN_FDIO_IMPL(T, Name)
+#   define ZVEC_GEN_STREAM_IMPL(T, Name)
+#   define ZVEC_GEN_CKPT_IMPL(T, Name)
+#endif // ZVEC_HAS_IO
+
+/*
+ * ZVEC_GENERATE_IMPL(T, Name)
+ *
+ * Primary generation macro.
+ *
+ * Use manually via:
+ * #define REGISTER_ZVEC_TYPES(X)   \
+ * X(int, Int)                      \
+ * X(float, Float)                  \
+ * X(MyType, MyType)
+ * #include "zvec.h"
+ *
+ * This creates:
+ * • struct zvec_Int / zvec_Float, etc.
+ * • All functions: zvec_push_Int, zvec_reserve_Float, etc.
+ * • Full _Generic dispatch.
+ * • C++ traits specialization for z_vec::vector<T>
+ *
+ * Fast path: returns int (Z_OK / Z_ENOMEM), asserts on logic errors.
+ * Safe path (when zerror.h present): returns zres / zresult<T>.
+ */
+#define ZVEC_GENERATE_IMPL(T, Name)                                                         \
+                                                                                            \
+    typedef T zvec_T_##Name;                                                                \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        T *data;                                                                            \
+        size_t length;                                                                      \
+        size_t capacity;                                                                    \
+    } zvec_##Name;                                                                          \
+                                                                                            \
+    /* Forward declaration for C++ allocators to see. */                                    \
+    static inline int zvec_reserve_##Name(zvec_##Name *v, size_t new_cap);                  \
+                                                                                            \
+    ZVEC_IMPL_ALLOC(T, Name)                                                                \
+                                                                                            \
+    static inline zvec_##Name zvec_init_capacity_##Name(size_t cap)                         \
+    {                                                                                       \
+        zvec_##Name v;                                                                      \
+        memset(&v, 0, sizeof(zvec_##Name));                                                 \
+        if (cap > 0)                                                                        \
+        {                                                                                   \
+            zvec_reserve_##Name(&v, cap);                                                   \
+        }                                                                                   \
+        return v;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    static inline zvec_##Name zvec_from_array_##Name(const T *arr, size_t count)            \
+    {                                                                                       \
+        zvec_##Name v = zvec_init_capacity_##Name(count);                                   \
+        if (v.data)                                                                         \
+        {                                                                                   \
+            size_t i;                                                                       \
+            for(i = 0; i<count; ++i)                                                        \
+            {                                                                               \
+                v.data[i] = arr[i];                                                         \
+            }                                                                               \
+            v.length = count;                                                               \
+        }                                                                                   \
+        return v;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_is_empty_##Name(zvec_##Name *v)                                  \
+    {                                                                                       \
+        return 0 == v->length;                                                              \
+    }                                                                                       \
+                                                                                            \
+    static inline T *zvec_push_slot_##Name(zvec_##Name *v)                                  \
+    {                                                                                       \
+        if (v->length >= v->capacity)                                                       \
+        {                                                                                   \
+            size_t new_cap = Z_GROWTH_FACTOR(v->capacity);                                  \
+            if (Z_OK != zvec_reserve_##Name(v, new_cap))                                    \
+            {                                                                               \
+                return NULL;                                                                \
+            }                                                                               \
+        }                                                                                   \
+        return &v->data[v->length++];                                                       \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_push_##Name(zvec_##Name *v, T value)                             \
+    {                                                                                       \
+        T *slot = zvec_push_slot_##Name(v);                                                 \
+        if (!slot)                                                                          \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        *slot = value;                                                                      \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_extend_##Name(zvec_##Name *v, const T *items, size_t count)      \
+    {                                                                                       \
+        if (v->length + count > v->capacity)                                                \
+        {                                                                                   \
+            size_t new_cap = v->capacity ? v->capacity : Z_GROWTH_FACTOR(0);                \
+            while (new_cap < v->length + count)                                             \
+            {                                                                               \
+                new_cap = Z_GROWTH_FACTOR(new_cap);                                         \
+            }                                                                               \
+            if (Z_OK != zvec_reserve_##Name(v, new_cap))                                    \
+            {                                                                               \
+                return Z_ENOMEM;                                                            \
+            }                                                                               \
+        }                                                                                   \
+        size_t i;                                                                           \
+        for( i = 0; i<count; ++i)                                                           \
+        {                                                                                   \
+            v->data[v->length + i] = items[i];                                              \
+        }                                                                                   \
+        v->length += count;                                                                 \
+        return Z_OK;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_pop_##Name(zvec_##Name *v)                                      \
+       {                                                                                    \
+        assert(v->length > 0 && "Popping empty vector");                                    \
+        v->length--;                                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline T zvec_pop_get_##Name(zvec_##Name *v)                                     \
+    {                                                                                       \
+        assert(v->length > 0 && "Vector is empty");                                         \
+        return v->data[--v->length];                                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline T *zvec_at_##Name(zvec_##Name *v, size_t index)                           \
+    {                                                                                       \
+        return (index < v->length) ? &v->data[index] : NULL;                                \
+    }                                                                                       \
+                                                                                            \
+    static inline T *zvec_data_##Name(zvec_##Name *v)                                       \
+    {                                                                                       \
+        return v->data;                                                                     \
+    }                                                                                       \
+                                                                                            \
+    static inline T *zvec_last_##Name(zvec_##Name *v)                                       \
+    {                                                                                       \
+        return (v->length > 0) ? &v->data[v->length - 1] : NULL;                            \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_swap_remove_##Name(zvec_##Name *v, size_t index)                \
+    {                                                                                       \
+        if (index >= v->length) return;                                                     \
+        v->data[index] = v->data[--v->length];                                              \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_clear_##Name(zvec_##Name *v)                                    \
+    {                                                                                       \
+        v->length = 0;                                                                      \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_reverse_##Name(zvec_##Name *v)                                  \
+    {                                                                                       \
+        if (v->length < 2)                                                                  \
+        {                                                                                   \
+            return;                                                                         \
+        }                                                                                   \
+        size_t i = 0;                                                                       \
+        size_t j = v->length - 1;                                                           \
+        while (i < j)                                                                       \
+        {                                                                                   \
+            T temp = v->data[i];                                                            \
+            v->data[i] = v->data[j];                                                        \
+            v->data[j] = temp;                                                              \
+            i++;                                                                            \
+            j--;                                                                            \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline void zvec_sort_##Name(zvec_##Name *v,                                     \
+                                        int (*compar)(const T *, const T *))                \
+    {                                                                                       \
+        if (v->length > 1)                                                                  \
+        {                                                                                   \
+            qsort(v->data, v->length, sizeof(T),                                            \
+                (int(*)(const void *, const void *))compar);                                \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline T *zvec_bsearch_##Name(zvec_##Name *v, const T *key,                      \
+                                         int (*compar)(const T *, const T *))               \
+    {                                                                                       \
+        if (0 == v->length)                                                                 \
+        {                                                                                   \
+            return NULL;                                                                    \
+        }                                                                                   \
+        return (T *)bsearch(key, v->data, v->length, sizeof(T),                             \
+                            (int(*)(const void *, const void *))compar);                    \
+    }                                                                                       \
+                                                                                            \
+    static inline T *zvec_lower_bound_##Name(zvec_##Name *v, const T *key,                  \
+                                             int (*compar)(const T *, const T *))           \
+    {                                                                                       \
+        size_t l = 0;                                                                       \
+        size_t r = v->length;                                                               \
+        while (l < r)                                                                       \
+        {                                                                                   \
+            size_t mid = l + (r - l) / 2;                                                   \
+            if (compar((const T *)&v->data[mid], key) < 0)                                  \
+            {                                                                               \
+                l = mid + 1;                                                                \
+            }                                                                               \
+            else                                                                            \
+            {                                                                               \
+                r = mid;                                                                    \
+            }                                                                               \
+        }                                                                                   \
+        return (l < v->length) ? &v->data[l] : NULL;                                        \
+    }                                                                                       \
+                                                                                            \
+    /* Inject stable sort. */                                                               \
+    ZVEC_GEN_STABLE_SORT_IMPL(T, Name)                                                      \
+                                                                                            \
+    /* Inject sorted set algebra. */                                                        \
+    ZVEC_GEN_SET_OPS_IMPL(T, Name)                                                          \
+                                                                                            \
+    /* Inject concurrent containers (ZVEC_ENABLE_THREADS). */                               \
+    ZVEC_GEN_CONC_IMPL(T, Name)                                                             \
+    ZVEC_GEN_SPSC_IMPL(T, Name)                                                             \
+    ZVEC_GEN_MPMC_IMPL(T, Name)                                                             \
+    ZVEC_GEN_DEQUE_IMPL(T, Name)                                                            \
+    ZVEC_GEN_PAR_IMPL(T, Name)                                                              \
+    ZVEC_GEN_RCU_IMPL(T, Name)                                                              \
+    ZVEC_GEN_LOCAL_IMPL(T, Name)                                                            \
+    ZVEC_GEN_SHARD_IMPL(T, Name)                                                            \
+    ZVEC_GEN_SEQ_IMPL(T, Name)                                                              \
+    ZVEC_GEN_EBR_IMPL(T, Name)                                                              \
+                                                                                            \
+    /* Inject file and memory-mapped I/O (ZVEC_ENABLE_IO). */                               \
+    ZVEC_GEN_IO_IMPL(T, Name)                                                               \
+    ZVEC_GEN_FILE_IMPL(T, Name)                                                             \
+    ZVEC_GEN_LOG_IMPL(T, Name)                                                              \
+    ZVEC_GEN_SHM_IMPL(T, Name)                                                              \
+    ZVEC_GEN_XSORT_IMPL(T, Name)                                                            \
+    ZVEC_GEN_PAGED_IMPL(T, Name)                                                            \
+    ZVEC_GEN_FDIO_IMPL(T, Name)                                                             \
+    ZVEC_GEN_STREAM_IMPL(T, Name)                                                           \
+    ZVEC_GEN_CKPT_IMPL(T, Name)                                                             \
+                                                                                            \
+    /* Inject safe API. */                                                                  \
+    ZVEC_GEN_SAFE_IMPL(T, Name)
+
+// Dispatch table entries for _Generic.
+#define PUSH_ENTRY(T, Name)         zvec_##Name *: zvec_push_##Name,
+#define PUSH_SLOT_ENTRY(T, Name)    zvec_##Name *: zvec_push_slot_##Name,
+#define EXTEND_ENTRY(T, Name)       zvec_##Name *: zvec_extend_##Name,
+#define RESERVE_ENTRY(T, Name)      zvec_##Name *: zvec_reserve_##Name,
+#define IS_EMPTY_ENTRY(T, Name)     zvec_##Name *: zvec_is_empty_##Name,
+#define AT_ENTRY(T, Name)           zvec_##Name *: zvec_at_##Name,
+#define DATA_ENTRY(T, Name)         zvec_##Name *: zvec_data_##Name,
+#define LAST_ENTRY(T, Name)         zvec_##Name *: zvec_last_##Name,
+#define FREE_ENTRY(T, Name)         zvec_##Name *: zvec_free_##Name,
+#define POP_ENTRY(T, Name)          zvec_##Name *: zvec_pop_##Name,
+#define POP_GET_ENTRY(T, Name)      zvec_##Name *: zvec_pop_get_##Name,
+#define SHRINK_ENTRY(T, Name)       zvec_##Name *: zvec_shrink_to_fit_##Name,
+#define REMOVE_ENTRY(T, Name)       zvec_##Name *: zvec_remove_##Name,
+#define SWAP_REM_ENTRY(T, Name)     zvec_##Name *: zvec_swap_remove_##Name,
+#define CLEAR_ENTRY(T, Name)        zvec_##Name *: zvec_clear_##Name,
+#define REVERSE_ENTRY(T, Name)      zvec_##Name *: zvec_reverse_##Name,
+#define SORT_ENTRY(T, Name)         zvec_##Name *: zvec_sort_##Name,
+#define STABLE_SORT_ENTRY(T, Name)  zvec_##Name *: zvec_stable_sort_##Name,
+#define BSEARCH_ENTRY(T, Name)      zvec_##Name *: zvec_bsearch_##Name,
+#define LOWER_BOUND_ENTRY(T, Name)  zvec_##Name *: zvec_lower_bound_##Name,
+#define MERGE_ENTRY(T, Name)        zvec_##Name *: zvec_merge_##Name,
+#define UNION_ENTRY(T, Name)        zvec_##Name *: zvec_union_##Name,
+#define INTERSECT_ENTRY(T, Name)    zvec_##Name *: zvec_intersect_##Name,
+#define DIFFERENCE_ENTRY(T, Name)   zvec_##Name *: zvec_difference_##Name,
+#define UNIQUE_ENTRY(T, Name)       zvec_##Name *: zvec_unique_##Name,
+
+#if Z_HAS_ZERROR
+#   define RESERVE_SAFE_ENTRY(T, Name) zvec_##Name *: zvec_reserve_safe_##Name,
+#   define PUSH_SAFE_ENTRY(T, Name)    zvec_##Name *: zvec_push_safe_##Name,
+#   define POP_SAFE_ENTRY(T, Name)     zvec_##Name *: zvec_pop_safe_##Name,
+#   define AT_SAFE_ENTRY(T, Name)      zvec_##Name *: zvec_at_safe_##Name,
+#   define LAST_SAFE_ENTRY(T, Name)    zvec_##Name *: zvec_last_safe_##Name,
+#endif
+
+#ifndef REGISTER_ZVEC_TYPES
+#   if defined(__has_include) && __has_include("z_registry.h")
+#       include "z_registry.h"
+#   endif
+#endif
+
+#ifndef REGISTER_ZVEC_TYPES
+#   define REGISTER_ZVEC_TYPES(X)
+#endif
+
+#ifndef Z_AUTOGEN_VECS
+#   define Z_AUTOGEN_VECS(X)
+#endif
+
+#define Z_ALL_VECS(X)       \
+    Z_AUTOGEN_VECS(X)       \
+    REGISTER_ZVEC_TYPES(X)
+
+Z_ALL_VECS(ZVEC_GENERATE_IMPL)
+
+// Public convenience macros.
+
+#define zvec_from(Name, ...)                                                                \
+    zvec_from_array_##Name((zvec_T_##Name[]){__VA_ARGS__},                                  \
+                           sizeof((zvec_T_##Name[]){__VA_ARGS__}) / sizeof(zvec_T_##Name))
+
+#define zvec_init(Name)           zvec_init_capacity_##Name(0)
+#define zvec_init_with_cap(Name, cap) zvec_init_capacity_##Name(cap)
+
+#if Z_HAS_CLEANUP
+#   define zvec_autofree(Name)  Z_CLEANUP(zvec_free_##Name) zvec_##Name
+#endif
+
+// Generic dispatch using _Generic.
+
+#ifdef __cplusplus
+    // C++ Overload Dispatch
+#   define zvec_push(v, val)          zvec_push_dispatch(v, val)
+#   define zvec_push_slot(v)          zvec_push_slot_dispatch(v)
+#   define zvec_extend(v, arr, count) zvec_extend_dispatch(v, arr, count)
+#   define zvec_reserve(v, cap)       zvec_reserve_dispatch(v, cap)
+#   define zvec_is_empty(v)           zvec_is_empty_dispatch(v)
+#   define zvec_at(v, idx)            zvec_at_dispatch(v, idx)
+#   define zvec_data(v)               zvec_data_dispatch(v)
+#   define zvec_last(v)               zvec_last_dispatch(v)
+#   define zvec_free(v)               zvec_free_dispatch(v)
+#   define zvec_pop(v)                zvec_pop_dispatch(v)
+#   define zvec_pop_get(v)            zvec_pop_get_dispatch(v)
+#   define zvec_shrink_to_fit(v)      zvec_shrink_to_fit_dispatch(v)
+#   define zvec_remove(v, i)          zvec_remove_dispatch(v, i)
+#   define zvec_swap_remove(v, i)     zvec_swap_remove_dispatch(v, i)
+#   define zvec_clear(v)              zvec_clear_dispatch(v)
+#   define zvec_reverse(v)            zvec_reverse_dispatch(v)
+#   define zvec_sort(v, cmp)          zvec_sort_dispatch(v, cmp)
+#   define zvec_stable_sort(v, cmp, s) zvec_stable_sort_dispatch(v, cmp, s)
+#   define zvec_bsearch(v, k, c)      zvec_bsearch_dispatch(v, k, c)
+#   define zvec_lower_bound(v, k, c)  zvec_lower_bound_dispatch(v, k, c)
+#   define zvec_merge(d, a, b, c)     zvec_merge_dispatch(d, a, b, c)
+#   define zvec_union(d, a, b, c)     zvec_union_dispatch(d, a, b, c)
+#   define zvec_intersect(d, a, b, c) zvec_intersect_dispatch(d, a, b, c)
+#   define zvec_difference(d, a, b, c) zvec_difference_dispatch(d, a, b, c)
+#   define zvec_unique(v, c)          zvec_unique_dispatch(v, c)
+#else
+    // C _Generic Dispatch
+#   define zvec_push(v, val)          _Generic((v), Z_ALL_VECS(PUSH_ENTRY)          default: 0)(v, val)
+#   define zvec_push_slot(v)          _Generic((v), Z_ALL_VECS(PUSH_SLOT_ENTRY)     default: (void *)0)(v)
+#   define zvec_extend(v, arr, count) _Generic((v), Z_ALL_VECS(EXTEND_ENTRY)        default: 0)(v, arr, count)
+#   define zvec_reserve(v, cap)       _Generic((v), Z_ALL_VECS(RESERVE_ENTRY)       default: 0)(v, cap)
+#   define zvec_is_empty(v)           _Generic((v), Z_ALL_VECS(IS_EMPTY_ENTRY)      default: 0)(v)
+#   define zvec_at(v, idx)            _Generic((v), Z_ALL_VECS(AT_ENTRY)            default: (void *)0)(v, idx)
+#   define zvec_data(v)               _Generic((v), Z_ALL_VECS(DATA_ENTRY)          default: (void *)0)(v)
+#   define zvec_last(v)               _Generic((v), Z_ALL_VECS(LAST_ENTRY)          default: (void *)0)(v)
+#   define zvec_free(v)               _Generic((v), Z_ALL_VECS(FREE_ENTRY)          default: (void)0)(v)
+#   define zvec_pop(v)                _Generic((v), Z_ALL_VECS(POP_ENTRY)           default: (void)0)(v)
+#   define zvec_pop_get(v)            _Generic((v), Z_ALL_VECS(POP_GET_ENTRY)       default: (void)0)(v)
+#   define zvec_shrink_to_fit(v)      _Generic((v), Z_ALL_VECS(SHRINK_ENTRY)        default: (void)0)(v)
+#   define zvec_remove(v, i)          _Generic((v), Z_ALL_VECS(REMOVE_ENTRY)        default: (void)0)(v, i)
+#   define zvec_swap_remove(v, i)     _Generic((v), Z_ALL_VECS(SWAP_REM_ENTRY)      default: (void)0)(v, i)
+#   define zvec_clear(v)              _Generic((v), Z_ALL_VECS(CLEAR_ENTRY)         default: (void)0)(v)
+#   define zvec_reverse(v)            _Generic((v), Z_ALL_VECS(REVERSE_ENTRY)       default: (void)0)(v)
+#   define zvec_sort(v, cmp)          _Generic((v), Z_ALL_VECS(SORT_ENTRY)          default: (void)0)(v, cmp)
+#   define zvec_stable_sort(v, cmp, s) _Generic((v), Z_ALL_VECS(STABLE_SORT_ENTRY)  default: 0)(v, cmp, s)
+#   define zvec_bsearch(v, k, c)      _Generic((v), Z_ALL_VECS(BSEARCH_ENTRY)       default: (void *)0)(v, k, c)
+#   define zvec_lower_bound(v, k, c)  _Generic((v), Z_ALL_VECS(LOWER_BOUND_ENTRY)   default: (void *)0)(v, k, c)
+#   define zvec_merge(d, a, b, c)     _Generic((d), Z_ALL_VECS(MERGE_ENTRY)         default: 0)(d, a, b, c)
+#   define zvec_union(d, a, b, c)     _Generic((d), Z_ALL_VECS(UNION_ENTRY)         default: 0)(d, a, b, c)
+#   define zvec_intersect(d, a, b, c) _Generic((d), Z_ALL_VECS(INTERSECT_ENTRY)     default: 0)(d, a, b, c)
+#   define zvec_difference(d, a, b, c) _Generic((d), Z_ALL_VECS(DIFFERENCE_ENTRY)   default: 0)(d, a, b, c)
+#   define zvec_unique(v, c)          _Generic((v), Z_ALL_VECS(UNIQUE_ENTRY)        default: 0)(v, c)
+#endif
+
+/* * Explicit declaration macro (portable C99)
+ * Usage: zvec_foreach_decl(Int, &vec, it) { ... }
+ */
+#define zvec_foreach_decl(Name, v, iter)                                        \
+    for (zvec_T_##Name *iter = (v)->data;                                       \
+         iter < (v)->data + (v)->length;                                        \
+         ++iter)
+
+// Smart iteration helpers (auto-inference).
+#if defined(__GNUC__) || defined(__clang__)
+
+    #define zvec_foreach(v, iter)                                               \
+        for (__typeof__((v)->data) iter = (v)->data;                            \
+             iter < (v)->data + (v)->length;                                    \
+             ++iter)
+
+#else
+
+    /* Standard C fallback: User must declare 'iter' before loop.
+     * Usage: int *it; zvec_foreach(&vec, it) { ... }
+     */
+    #define zvec_foreach(v, iter)                                               \
+        for ((iter) = (v)->data;                                                \
+             (iter) < (v)->data + (v)->length;                                  \
+             ++(iter))
+
+#endif
+
+// Safe API dispatch (zerror.h required).
+#if Z_HAS_ZERROR && !defined(__cplusplus)
+    static inline zres zres_err_dummy(void *v, ...) 
+    {
+        (void)v; 
+        return zres_err(zerr_create(-1, "Unknown vector type")); 
+    }
+
+#   define zvec_reserve_safe(v, cap) \
+        _Generic((v), Z_ALL_VECS(RESERVE_SAFE_ENTRY) default: zres_err_dummy)(v, cap, __FILE__, __LINE__, __func__)
+
+#   define zvec_push_safe(v, val) \
+        _Generic((v), Z_ALL_VECS(PUSH_SAFE_ENTRY) default: zres_err_dummy)(v, val, __FILE__, __LINE__, __func__)
+
+#   define zvec_pop_safe(v) \
+        _Generic((v), Z_ALL_VECS(POP_SAFE_ENTRY) default: zres_err_dummy)(v, __FILE__, __LINE__, __func__)
+
+#   define zvec_at_safe(v, i) \
+        _Generic((v), Z_ALL_VECS(AT_SAFE_ENTRY) default: zres_err_dummy)(v, i, __FILE__, __LINE__, __func__)
+
+#   define zvec_last_safe(v) \
+        _Generic((v), Z_ALL_VECS(LAST_SAFE_ENTRY) default: zres_err_dummy)(v, __FILE__, __LINE__, __func__)
+#endif
+
+// Concurrent API dispatch (ZVEC_ENABLE_THREADS).
+#if ZVEC_HAS_THREADS
+#   define CONC_FREE_ENTRY(T, Name)        zvec_conc_##Name *: zvec_conc_free_##Name,
+#   define CONC_PUSH_ENTRY(T, Name)        zvec_conc_##Name *: zvec_conc_push_##Name,
+#   define CONC_PUSH_SLOT_ENTRY(T, Name)   zvec_conc_##Name *: zvec_conc_push_slot_##Name,
+#   define CONC_PUBLISH_ENTRY(T, Name)     zvec_conc_##Name *: zvec_conc_publish_##Name,
+#   define CONC_EXTEND_ENTRY(T, Name)      zvec_conc_##Name *: zvec_conc_extend_##Name,
+#   define CONC_RESERVE_ENTRY(T, Name)     zvec_conc_##Name *: zvec_conc_reserve_##Name,
+#   define CONC_SIZE_ENTRY(T, Name)        zvec_conc_##Name *: zvec_conc_size_##Name,
+#   define CONC_AT_ENTRY(T, Name)          zvec_conc_##Name *: zvec_conc_at_##Name,
+#   define CONC_WATERMARK_ENTRY(T, Name)   zvec_conc_##Name *: zvec_conc_watermark_##Name,
+#   define CONC_TO_VEC_ENTRY(T, Name)      zvec_conc_##Name *: zvec_conc_to_vec_##Name,
+#   define SPSC_INIT_ENTRY(T, Name)        zvec_spsc_##Name *: zvec_spsc_init_##Name,
+#   define SPSC_FREE_ENTRY(T, Name)        zvec_spsc_##Name *: zvec_spsc_free_##Name,
+#   define SPSC_PUSH_ENTRY(T, Name)        zvec_spsc_##Name *: zvec_spsc_push_##Name,
+#   define SPSC_PUSH_N_ENTRY(T, Name)      zvec_spsc_##Name *: zvec_spsc_push_n_##Name,
+#   define SPSC_RESERVE_ENTRY(T, Name)     zvec_spsc_##Name *: zvec_spsc_reserve_slot_##Name,
+#   define SPSC_COMMIT_ENTRY(T, Name)      zvec_spsc_##Name *: zvec_spsc_commit_##Name,
+#   define SPSC_POP_ENTRY(T, Name)         zvec_spsc_##Name *: zvec_spsc_pop_##Name,
+#   define SPSC_POP_N_ENTRY(T, Name)       zvec_spsc_##Name *: zvec_spsc_pop_n_##Name,
+#   define SPSC_FRONT_ENTRY(T, Name)       zvec_spsc_##Name *: zvec_spsc_front_##Name,
+#   define SPSC_RELEASE_ENTRY(T, Name)     zvec_spsc_##Name *: zvec_spsc_release_##Name,
+#   define SPSC_SIZE_ENTRY(T, Name)        zvec_spsc_##Name *: zvec_spsc_size_##Name,
+#   define MPMC_INIT_ENTRY(T, Name)        zvec_mpmc_##Name *: zvec_mpmc_init_##Name,
+#   define MPMC_FREE_ENTRY(T, Name)        zvec_mpmc_##Name *: zvec_mpmc_free_##Name,
+#   define MPMC_PUSH_ENTRY(T, Name)        zvec_mpmc_##Name *: zvec_mpmc_push_##Name,
+#   define MPMC_TRY_PUSH_ENTRY(T, Name)    zvec_mpmc_##Name *: zvec_mpmc_try_push_##Name,
+#   define MPMC_TRY_PUSH_N_ENTRY(T, Name)  zvec_mpmc_##Name *: zvec_mpmc_try_push_n_##Name,
+#   define MPMC_POP_ENTRY(T, Name)         zvec_mpmc_##Name *: zvec_mpmc_pop_##Name,
+#   define MPMC_TRY_POP_ENTRY(T, Name)     zvec_mpmc_##Name *: zvec_mpmc_try_pop_##Name,
+#   define MPMC_POP_N_ENTRY(T, Name)       zvec_mpmc_##Name *: zvec_mpmc_pop_n_##Name,
+#   define MPMC_TRY_POP_N_ENTRY(T, Name)   zvec_mpmc_##Name *: zvec_mpmc_try_pop_n_##Name,
+#   define MPMC_CLOSE_ENTRY(T, Name)       zvec_mpmc_##Name *: zvec_mpmc_close_##Name,
+#   define MPMC_SIZE_ENTRY(T, Name)        zvec_mpmc_##Name *: zvec_mpmc_size_##Name,
+#   define DEQUE_INIT_ENTRY(T, Name)       zvec_deque_##Name *: zvec_deque_init_##Name,
+#   define DEQUE_FREE_ENTRY(T, Name)       zvec_deque_##Name *: zvec_deque_free_##Name,
+#   define DEQUE_PUSH_ENTRY(T, Name)       zvec_deque_##Name *: zvec_deque_push_##Name,
+#   define DEQUE_POP_ENTRY(T, Name)        zvec_deque_##Name *: zvec_deque_pop_##Name,
+#   define DEQUE_STEAL_ENTRY(T, Name)      zvec_deque_##Name *: zvec_deque_steal_##Name,
+#   define DEQUE_SIZE_ENTRY(T, Name)       zvec_deque_##Name *: zvec_deque_size_##Name,
+#   define PAR_FOREACH_ENTRY(T, Name)      zvec_##Name *: zvec_par_foreach_##Name,
+#   define PAR_TRANSFORM_ENTRY(T, Name)    zvec_##Name *: zvec_par_transform_##Name,
+#   define PAR_REDUCE_ENTRY(T, Name)       zvec_##Name *: zvec_par_reduce_##Name,
+#   define RCU_INIT_ENTRY(T, Name)         zvec_rcu_##Name *: zvec_rcu_init_##Name,
+#   define RCU_FREE_ENTRY(T, Name)         zvec_rcu_##Name *: zvec_rcu_free_##Name,
+#   define RCU_REGISTER_ENTRY(T, Name)     zvec_rcu_##Name *: zvec_rcu_register_##Name,
+#   define RCU_UNREGISTER_ENTRY(T, Name)   zvec_rcu_##Name *: zvec_rcu_unregister_##Name,
+#   define RCU_READ_LOCK_ENTRY(T, Name)    zvec_rcu_##Name *: zvec_rcu_read_lock_##Name,
+#   define RCU_READ_UNLOCK_ENTRY(T, Name)  zvec_rcu_##Name *: zvec_rcu_read_unlock_##Name,
+#   define RCU_PUSH_ENTRY(T, Name)         zvec_rcu_##Name *: zvec_rcu_push_##Name,
+#   define RCU_EXTEND_ENTRY(T, Name)       zvec_rcu_##Name *: zvec_rcu_extend_##Name,
+#   define RCU_EDIT_ENTRY(T, Name)         zvec_rcu_##Name *: zvec_rcu_edit_##Name,
+#   define RCU_PUBLISH_ENTRY(T, Name)      zvec_rcu_##Name *: zvec_rcu_publish_##Name,
+#   define RCU_DISCARD_ENTRY(T, Name)      zvec_rcu_##Name *: zvec_rcu_discard_##Name,
+#   define RCU_SYNC_ENTRY(T, Name)         zvec_rcu_##Name *: zvec_rcu_synchronize_##Name,
+#   define COMBINE_INTO_ENTRY(T, Name)     zvec_##Name *: zvec_combine_into_##Name,
+#   define SHARD_INIT_ENTRY(T, Name)       zvec_shard_##Name *: zvec_shard_init_##Name,
+#   define SHARD_FREE_ENTRY(T, Name)       zvec_shard_##Name *: zvec_shard_free_##Name,
+#   define SHARD_LOCAL_ENTRY(T, Name)      zvec_shard_##Name *: zvec_shard_local_##Name,
+#   define SHARD_GET_ENTRY(T, Name)        zvec_shard_##Name *: zvec_shard_get_##Name,
+#   define SHARD_PUSH_ENTRY(T, Name)       zvec_shard_##Name *: zvec_shard_push_##Name,
+#   define SHARD_REMOVE_ENTRY(T, Name)     zvec_shard_##Name *: zvec_shard_swap_remove_##Name,
+#   define SHARD_SIZE_ENTRY(T, Name)       zvec_shard_##Name *: zvec_shard_size_##Name,
+#   define SHARD_VISIT_ENTRY(T, Name)      zvec_shard_##Name *: zvec_shard_visit_##Name,
+#   define SHARD_GATHER_ENTRY(T, Name)     zvec_shard_##Name *: zvec_shard_gather_##Name,
+#   define SEQ_INIT_ENTRY(T, Name)         zvec_seq_##Name *: zvec_seq_init_##Name,
+#   define SEQ_FREE_ENTRY(T, Name)         zvec_seq_##Name *: zvec_seq_free_##Name,
+#   define SEQ_RESERVE_ENTRY(T, Name)      zvec_seq_##Name *: zvec_seq_reserve_##Name,
+#   define SEQ_PUSH_ENTRY(T, Name)         zvec_seq_##Name *: zvec_seq_push_##Name,
+#   define SEQ_EXTEND_ENTRY(T, Name)       zvec_seq_##Name *: zvec_seq_extend_##Name,
+#   define SEQ_LENGTH_ENTRY(T, Name)       zvec_seq_##Name *: zvec_seq_length_##Name,
+#   define SEQ_SNAPSHOT_ENTRY(T, Name)     zvec_seq_##Name *: zvec_seq_snapshot_##Name,
+#   define SEQ_RECLAIM_ENTRY(T, Name)      zvec_seq_##Name *: zvec_seq_reclaim_##Name,
+#   define EPOCH_RESERVE_ENTRY(T, Name)    zvec_##Name *: zvec_reserve_epoch_##Name,
+#   define EPOCH_PUSH_ENTRY(T, Name)       zvec_##Name *: zvec_push_epoch_##Name,
+#   define EPOCH_EXTEND_ENTRY(T, Name)     zvec_##Name *: zvec_extend_epoch_##Name,
+#   define EPOCH_LOAD_ENTRY(T, Name)       zvec_##Name *: zvec_load_epoch_##Name,
+
+#   define zvec_conc_init(Name)            zvec_conc_init_##Name()
+#   define zvec_conc_free(c)               _Generic((c), Z_ALL_VECS(CONC_FREE_ENTRY)      default: (void)0)(c)
+#   define zvec_conc_push(c, val)          _Generic((c), Z_ALL_VECS(CONC_PUSH_ENTRY)      default: 0)(c, val)
+#   define zvec_conc_push_slot(c, idx)     _Generic((c), Z_ALL_VECS(CONC_PUSH_SLOT_ENTRY) default: (void *)0)(c, idx)
+#   define zvec_conc_publish(c, idx)       _Generic((c), Z_ALL_VECS(CONC_PUBLISH_ENTRY)   default: (void)0)(c, idx)
+#   define zvec_conc_extend(c, arr, n)     _Generic((c), Z_ALL_VECS(CONC_EXTEND_ENTRY)    default: 0)(c, arr, n)
+#   define zvec_conc_reserve(c, cap)       _Generic((c), Z_ALL_VECS(CONC_RESERVE_ENTRY)   default: 0)(c, cap)
+#   define zvec_conc_size(c)               _Generic((c), Z_ALL_VECS(CONC_SIZE_ENTRY)      default: 0)(c)
+#   define zvec_conc_at(c, idx)            _Generic((c), Z_ALL_VECS(CONC_AT_ENTRY)        default: (void *)0)(c, idx)
+#   define zvec_conc_watermark(c)          _Generic((c), Z_ALL_VECS(CONC_WATERMARK_ENTRY) default: 0)(c)
+#   define zvec_conc_to_vec(c, out)        _Generic((c), Z_ALL_VECS(CONC_TO_VEC_ENTRY)    default: 0)(c, out)
+
+#   define zvec_spsc_init(q, cap)          _Generic((q), Z_ALL_VECS(SPSC_INIT_ENTRY)      default: 0)(q, cap)
+#   define zvec_spsc_free(q)               _Generic((q), Z_ALL_VECS(SPSC_FREE_ENTRY)      default: (void)0)(q)
+#   define zvec_spsc_push(q, val)          _Generic((q), Z_ALL_VECS(SPSC_PUSH_ENTRY)      default: 0)(q, val)
+#   define zvec_spsc_push_n(q, arr, n)     _Generic((q), Z_ALL_VECS(SPSC_PUSH_N_ENTRY)    default: 0)(q, arr, n)
+#   define zvec_spsc_reserve_slot(q)       _Generic((q), Z_ALL_VECS(SPSC_RESERVE_ENTRY)   default: (void *)0)(q)
+#   define zvec_spsc_commit(q)             _Generic((q), Z_ALL_VECS(SPSC_COMMIT_ENTRY)    default: (void)0)(q)
+#   define zvec_spsc_pop(q, out)           _Generic((q), Z_ALL_VECS(SPSC_POP_ENTRY)       default: 0)(q, out)
+#   define zvec_spsc_pop_n(q, out, n)      _Generic((q), Z_ALL_VECS(SPSC_POP_N_ENTRY)     default: 0)(q, out, n)
+#   define zvec_spsc_front(q)              _Generic((q), Z_ALL_VECS(SPSC_FRONT_ENTRY)     default: (void *)0)(q)
+#   define zvec_spsc_release(q)            _Generic((q), Z_ALL_VECS(SPSC_RELEASE_ENTRY)   default: (void)0)(q)
+#   define zvec_spsc_size(q)               _Generic((q), Z_ALL_VECS(SPSC_SIZE_ENTRY)      default: 0)(q)
+
+#   define zvec_mpmc_init(q, cap)          _Generic((q), Z_ALL_VECS(MPMC_INIT_ENTRY)        default: 0)(q, cap)
+#   define zvec_mpmc_free(q)               _Generic((q), Z_ALL_VECS(MPMC_FREE_ENTRY)        default: (void)0)(q)
+#   define zvec_mpmc_push(q, val)          _Generic((q), Z_ALL_VECS(MPMC_PUSH_ENTRY)        default: 0)(q, val)
+#   define zvec_mpmc_try_push(q, val)      _Generic((q), Z_ALL_VECS(MPMC_TRY_PUSH_ENTRY)    default: 0)(q, val)
+#   define zvec_mpmc_try_push_n(q, arr, n) _Generic((q), Z_ALL_VECS(MPMC_TRY_PUSH_N_ENTRY)  default: 0)(q, arr, n)
+#   define zvec_mpmc_pop(q, out)           _Generic((q), Z_ALL_VECS(MPMC_POP_ENTRY)         default: 0)(q, out)
+#   define zvec_mpmc_try_pop(q, out)       _Generic((q), Z_ALL_VECS(MPMC_TRY_POP_ENTRY)     default: 0)(q, out)
+#   define zvec_mpmc_pop_n(q, out, n)      _Generic((q), Z_ALL_VECS(MPMC_POP_N_ENTRY)       default: 0)(q, out, n)
+#   define zvec_mpmc_try_pop_n(q, out, n)  _Generic((q), Z_ALL_VECS(MPMC_TRY_POP_N_ENTRY)   default: 0)(q, out, n)
+#   define zvec_mpmc_close(q)              _Generic((q), Z_ALL_VECS(MPMC_CLOSE_ENTRY)       default: (void)0)(q)
+#   define zvec_mpmc_size(q)               _Generic((q), Z_ALL_VECS(MPMC_SIZE_ENTRY)        default: 0)(q)
+
+#   define zvec_deque_init(d, cap)         _Generic((d), Z_ALL_VECS(DEQUE_INIT_ENTRY)       default: 0)(d, cap)
+#   define zvec_deque_free(d)              _Generic((d), Z_ALL_VECS(DEQUE_FREE_ENTRY)       default: (void)0)(d)
+#   define zvec_deque_push(d, val)         _Generic((d), Z_ALL_VECS(DEQUE_PUSH_ENTRY)       default: 0)(d, val)
+#   define zvec_deque_pop(d, out)          _Generic((d), Z_ALL_VECS(DEQUE_POP_ENTRY)        default: 0)(d, out)
+#   define zvec_deque_steal(d, out)        _Generic((d), Z_ALL_VECS(DEQUE_STEAL_ENTRY)      default: 0)(d, out)
+#   define zvec_deque_size(d)              _Generic((d), Z_ALL_VECS(DEQUE_SIZE_ENTRY)       default: 0)(d)
+
+#   define zvec_par_foreach(v, f, ctx)     _Generic((v), Z_ALL_VECS(PAR_FOREACH_ENTRY)      default: (void)0)(v, f, ctx)
+#   define zvec_par_transform(d, s, f)     _Generic((d), Z_ALL_VECS(PAR_TRANSFORM_ENTRY)    default: 0)(d, s, f)
+#   define zvec_par_reduce(v, i, m, c)     _Generic((v), Z_ALL_VECS(PAR_REDUCE_ENTRY)       default: 0)(v, i, m, c)
+
+#   define zvec_rcu_init(r)                _Generic((r), Z_ALL_VECS(RCU_INIT_ENTRY)         default: 0)(r)
+#   define zvec_rcu_free(r)                _Generic((r), Z_ALL_VECS(RCU_FREE_ENTRY)         default: (void)0)(r)
+#   define zvec_rcu_register(r)            _Generic((r), Z_ALL_VECS(RCU_REGISTER_ENTRY)     default: 0)(r)
+#   define zvec_rcu_unregister(r, slot)    _Generic((r), Z_ALL_VECS(RCU_UNREGISTER_ENTRY)   default: (void)0)(r, slot)
+#   define zvec_rcu_read_lock(r, slot)     _Generic((r), Z_ALL_VECS(RCU_READ_LOCK_ENTRY)    default: 0)(r, slot)
+#   define zvec_rcu_read_unlock(r, slot)   _Generic((r), Z_ALL_VECS(RCU_READ_UNLOCK_ENTRY)  default: (void)0)(r, slot)
+#   define zvec_rcu_push(r, val)           _Generic((r), Z_ALL_VECS(RCU_PUSH_ENTRY)         default: 0)(r, val)
+#   define zvec_rcu_extend(r, arr, n)      _Generic((r), Z_ALL_VECS(RCU_EXTEND_ENTRY)       default: 0)(r, arr, n)
+#   define zvec_rcu_edit(r)                _Generic((r), Z_ALL_VECS(RCU_EDIT_ENTRY)         default: (void *)0)(r)
+#   define zvec_rcu_publish(r)             _Generic((r), Z_ALL_VECS(RCU_PUBLISH_ENTRY)      default: 0)(r)
+#   define zvec_rcu_discard(r)             _Generic((r), Z_ALL_VECS(RCU_DISCARD_ENTRY)      default: (void)0)(r)
+#   define zvec_rcu_synchronize(r)         _Generic((r), Z_ALL_VECS(RCU_SYNC_ENTRY)         default: (void)0)(r)
+
+#   define zvec_local(Name)                zvec_local_##Name()
+#   define zvec_local_release(Name)        zvec_local_release_##Name()
+#   define zvec_combine_into(dst)          _Generic((dst), Z_ALL_VECS(COMBINE_INTO_ENTRY)   default: 0)(dst)
+
+#   define zvec_shard_init(s, n)           _Generic((s), Z_ALL_VECS(SHARD_INIT_ENTRY)       default: 0)(s, n)
+#   define zvec_shard_free(s)              _Generic((s), Z_ALL_VECS(SHARD_FREE_ENTRY)       default: (void)0)(s)
+#   define zvec_shard_local(s)             _Generic((s), Z_ALL_VECS(SHARD_LOCAL_ENTRY)      default: 0)(s)
+#   define zvec_shard_get(s, k)            _Generic((s), Z_ALL_VECS(SHARD_GET_ENTRY)        default: (void *)0)(s, k)
+#   define zvec_shard_push(s, k, val)      _Generic((s), Z_ALL_VECS(SHARD_PUSH_ENTRY)       default: 0)(s, k, val)
+#   define zvec_shard_swap_remove(s, k, i) _Generic((s), Z_ALL_VECS(SHARD_REMOVE_ENTRY)     default: (void)0)(s, k, i)
+#   define zvec_shard_size(s)              _Generic((s), Z_ALL_VECS(SHARD_SIZE_ENTRY)       default: 0)(s)
+#   define zvec_shard_visit(s, f, ctx)     _Generic((s), Z_ALL_VECS(SHARD_VISIT_ENTRY)      default: (void)0)(s, f, ctx)
+#   define zvec_shard_gather(s, out)       _Generic((s), Z_ALL_VECS(SHARD_GATHER_ENTRY)     default: 0)(s, out)
+#   define zvec_shard_foreach(s, iter)                                                 \
+        for (size_t iter##_shard = 0; iter##_shard < (s)->count; ++iter##_shard)        \
+            zvec_foreach(&(s)->shards[iter##_shard].vec, iter)
+
+#   define zvec_seq_init(v)                _Generic((v), Z_ALL_VECS(SEQ_INIT_ENTRY)         default: (void)0)(v)
+#   define zvec_seq_free(v)                _Generic((v), Z_ALL_VECS(SEQ_FREE_ENTRY)         default: (void)0)(v)
+#   define zvec_seq_reserve(v, n)          _Generic((v), Z_ALL_VECS(SEQ_RESERVE_ENTRY)      default: 0)(v, n)
+#   define zvec_seq_push(v, val)           _Generic((v), Z_ALL_VECS(SEQ_PUSH_ENTRY)         default: 0)(v, val)
+#   define zvec_seq_extend(v, arr, n)      _Generic((v), Z_ALL_VECS(SEQ_EXTEND_ENTRY)       default: 0)(v, arr, n)
+#   define zvec_seq_length(v)              _Generic((v), Z_ALL_VECS(SEQ_LENGTH_ENTRY)       default: 0)(v)
+#   define zvec_seq_snapshot(v)            _Generic((v), Z_ALL_VECS(SEQ_SNAPSHOT_ENTRY)     default: 0)(v)
+#   define zvec_seq_reclaim(v)             _Generic((v), Z_ALL_VECS(SEQ_RECLAIM_ENTRY)      default: (void)0)(v)
+
+#   define zvec_reserve_epoch(v, n, e)     _Generic((v), Z_ALL_VECS(EPOCH_RESERVE_ENTRY)    default: 0)(v, n, e)
+#   define zvec_push_epoch(v, val, e)      _Generic((v), Z_ALL_VECS(EPOCH_PUSH_ENTRY)       default: 0)(v, val, e)
+#   define zvec_extend_epoch(v, arr, n, e) _Generic((v), Z_ALL_VECS(EPOCH_EXTEND_ENTRY)     default: 0)(v, arr, n, e)
+#   define zvec_load_epoch(v)              _Generic((v), Z_ALL_VECS(EPOCH_LOAD_ENTRY)       default: 0)(v)
+#endif
+
+// File I/O API dispatch (ZVEC_ENABLE_IO).
+#if ZVEC_HAS_IO
+#   define SAVE_ENTRY(T, Name)             zvec_##Name *: zvec_save_##Name,
+#   define UNMAP_ENTRY(T, Name)            zvec_##Name *: zvec_unmap_##Name,
+#   define READ_FD_ENTRY(T, Name)          zvec_##Name *: zvec_read_fd_##Name,
+#   define PREAD_FD_ENTRY(T, Name)         zvec_##Name *: zvec_pread_fd_##Name,
+#   define WRITE_FD_ENTRY(T, Name)         zvec_##Name *: zvec_write_fd_##Name,
+#   define FILE_OPEN_ENTRY(T, Name)        zvec_file_##Name *: zvec_file_open_##Name,
+#   define FILE_RESERVE_ENTRY(T, Name)     zvec_file_##Name *: zvec_file_reserve_##Name,
+#   define FILE_PUSH_ENTRY(T, Name)        zvec_file_##Name *: zvec_file_push_##Name,
+#   define FILE_EXTEND_ENTRY(T, Name)      zvec_file_##Name *: zvec_file_extend_##Name,
+#   define FILE_SYNC_ENTRY(T, Name)        zvec_file_##Name *: zvec_file_sync_##Name,
+#   define FILE_CLOSE_ENTRY(T, Name)       zvec_file_##Name *: zvec_file_close_##Name,
+#   define SHM_CREATE_ENTRY(T, Name)       zvec_shm_##Name *: zvec_shm_create_##Name,
+#   define SHM_ATTACH_ENTRY(T, Name)       zvec_shm_##Name *: zvec_shm_attach_##Name,
+#   define SHM_REFRESH_ENTRY(T, Name)      zvec_shm_##Name *: zvec_shm_refresh_##Name,
+#   define SHM_PUSH_ENTRY(T, Name)         zvec_shm_##Name *: zvec_shm_push_##Name,
+#   define SHM_EXTEND_ENTRY(T, Name)       zvec_shm_##Name *: zvec_shm_extend_##Name,
+#   define SHM_DETACH_ENTRY(T, Name)       zvec_shm_##Name *: zvec_shm_detach_##Name,
+#   define PAGED_OPEN_ENTRY(T, Name)       zvec_paged_##Name *: zvec_paged_open_##Name,
+#   define PAGED_SIZE_ENTRY(T, Name)       zvec_paged_##Name *: zvec_paged_size_##Name,
+#   define PAGED_AT_ENTRY(T, Name)         zvec_paged_##Name *: zvec_paged_at_##Name,
+#   define PAGED_PEEK_ENTRY(T, Name)       zvec_paged_##Name *: zvec_paged_peek_##Name,
+#   define PAGED_PUSH_ENTRY(T, Name)       zvec_paged_##Name *: zvec_paged_push_##Name,
+#   define PAGED_EXTEND_ENTRY(T, Name)     zvec_paged_##Name *: zvec_paged_extend_##Name,
+#   define PAGED_PAGE_ENTRY(T, Name)       zvec_paged_##Name *: zvec_paged_page_##Name,
+#   define PAGED_PREFETCH_ENTRY(T, Name)   zvec_paged_##Name *: zvec_paged_prefetch_##Name,
+#   define PAGED_FLUSH_ENTRY(T, Name)      zvec_paged_##Name *: zvec_paged_flush_##Name,
+#   define PAGED_CLOSE_ENTRY(T, Name)      zvec_paged_##Name *: zvec_paged_close_##Name,
+#   define TRACK_INIT_ENTRY(T, Name)       zvec_track_##Name *: zvec_track_init_##Name,
+#   define TRACK_FREE_ENTRY(T, Name)       zvec_track_##Name *: zvec_track_free_##Name,
+#   define TRACK_MARK_ENTRY(T, Name)       zvec_track_##Name *: zvec_track_mark_##Name,
+#   define TRACK_AT_ENTRY(T, Name)         zvec_track_##Name *: zvec_track_at_##Name,
+#   define TRACK_SLOT_ENTRY(T, Name)       zvec_track_##Name *: zvec_track_push_slot_##Name,
+#   define TRACK_PUSH_ENTRY(T, Name)       zvec_track_##Name *: zvec_track_push_##Name,
+#   define TRACK_REMOVE_ENTRY(T, Name)     zvec_track_##Name *: zvec_track_remove_##Name,
+#   define CHECKPOINT_ENTRY(T, Name)       zvec_track_##Name *: zvec_checkpoint_##Name,
+#   if ZVEC_HAS_THREADS
+#       define LOG_OPEN_ENTRY(T, Name)     zvec_log_##Name *: zvec_log_open_##Name,
+#       define LOG_PUSH_ENTRY(T, Name)     zvec_log_##Name *: zvec_log_push_##Name,
+#       define LOG_EXTEND_ENTRY(T, Name)   zvec_log_##Name *: zvec_log_extend_##Name,
+#       define LOG_CLOSE_ENTRY(T, Name)    zvec_log_##Name *: zvec_log_close_##Name,
+#       define STREAM_OPEN_ENTRY(T, Name)  zvec_stream_##Name *: zvec_stream_open_##Name,
+#       define STREAM_NEXT_ENTRY(T, Name)  zvec_stream_##Name *: zvec_stream_next_chunk_##Name,
+#       define STREAM_CLOSE_ENTRY(T, Name) zvec_stream_##Name *: zvec_stream_close_##Name,
+#   endif
+
+#   define zvec_save(v, path)              _Generic((v), Z_ALL_VECS(SAVE_ENTRY)             default: 0)(v, path)
+#   define zvec_unmap(v)                   _Generic((v), Z_ALL_VECS(UNMAP_ENTRY)            default: (void)0)(v)
+#   define zvec_view_mmap(Name, path)      zvec_view_mmap_##Name(path)
+#   define zvec_read_fd(v, fd, max, part)  _Generic((v), Z_ALL_VECS(READ_FD_ENTRY)          default: 0)(v, fd, max, part)
+#   define zvec_pread_fd(v, fd, max, off)  _Generic((v), Z_ALL_VECS(PREAD_FD_ENTRY)         default: 0)(v, fd, max, off)
+#   define zvec_write_fd(v, fd)            _Generic((v), Z_ALL_VECS(WRITE_FD_ENTRY)         default: 0)(v, fd)
+
+#   define zvec_file_open(f, path)         _Generic((f), Z_ALL_VECS(FILE_OPEN_ENTRY)        default: 0)(f, path)
+#   define zvec_file_reserve(f, n)         _Generic((f), Z_ALL_VECS(FILE_RESERVE_ENTRY)     default: 0)(f, n)
+#   define zvec_file_push(f, val)          _Generic((f), Z_ALL_VECS(FILE_PUSH_ENTRY)        default: 0)(f, val)
+#   define zvec_file_extend(f, arr, n)     _Generic((f), Z_ALL_VECS(FILE_EXTEND_ENTRY)      default: 0)(f, arr, n)
+#   define zvec_file_sync(f)               _Generic((f), Z_ALL_VECS(FILE_SYNC_ENTRY)        default: 0)(f)
+#   define zvec_file_close(f)              _Generic((f), Z_ALL_VECS(FILE_CLOSE_ENTRY)       default: 0)(f)
+
+#   define zvec_shm_create(s, name, cap)   _Generic((s), Z_ALL_VECS(SHM_CREATE_ENTRY)       default: 0)(s, name, cap)
+#   define zvec_shm_attach(s, name)        _Generic((s), Z_ALL_VECS(SHM_ATTACH_ENTRY)       default: 0)(s, name)
+#   define zvec_shm_refresh(s)             _Generic((s), Z_ALL_VECS(SHM_REFRESH_ENTRY)      default: 0)(s)
+#   define zvec_shm_push(s, val)           _Generic((s), Z_ALL_VECS(SHM_PUSH_ENTRY)         default: 0)(s, val)
+#   define zvec_shm_extend(s, arr, n)      _Generic((s), Z_ALL_VECS(SHM_EXTEND_ENTRY)       default: 0)(s, arr, n)
+#   define zvec_shm_detach(s)              _Generic((s), Z_ALL_VECS(SHM_DETACH_ENTRY)       default: (void)0)(s)
+
+#   define zvec_paged_open(p, path, max)   _Generic((p), Z_ALL_VECS(PAGED_OPEN_ENTRY)       default: 0)(p, path, max)
+#   define zvec_paged_size(p)              _Generic((p), Z_ALL_VECS(PAGED_SIZE_ENTRY)       default: 0)(p)
+#   define zvec_paged_at(p, i)             _Generic((p), Z_ALL_VECS(PAGED_AT_ENTRY)         default: (void *)0)(p, i)
+#   define zvec_paged_peek(p, i)           _Generic((p), Z_ALL_VECS(PAGED_PEEK_ENTRY)       default: (void *)0)(p, i)
+#   define zvec_paged_push(p, val)         _Generic((p), Z_ALL_VECS(PAGED_PUSH_ENTRY)       default: 0)(p, val)
+#   define zvec_paged_extend(p, arr, n)    _Generic((p), Z_ALL_VECS(PAGED_EXTEND_ENTRY)     default: 0)(p, arr, n)
+#   define zvec_paged_page(p, pg, n)       _Generic((p), Z_ALL_VECS(PAGED_PAGE_ENTRY)       default: (void *)0)(p, pg, n)
+#   define zvec_paged_prefetch(p, i, n)    _Generic((p), Z_ALL_VECS(PAGED_PREFETCH_ENTRY)   default: (void)0)(p, i, n)
+#   define zvec_paged_flush(p)             _Generic((p), Z_ALL_VECS(PAGED_FLUSH_ENTRY)      default: 0)(p)
+#   define zvec_paged_close(p)             _Generic((p), Z_ALL_VECS(PAGED_CLOSE_ENTRY)      default: 0)(p)
+
+    // Read-only scan, one resident page at a time; 'iter' is refetched at page boundaries.
+#   if defined(__GNUC__) || defined(__clang__)
+#       define zvec_paged_foreach(p, iter)                                                 \
+            for (size_t iter##_pg = 0, iter##_left = 0, iter##_once = 1; iter##_once;      \
+                 iter##_once = 0)                                                          \
+                for (__typeof__(zvec_paged_peek(p, 0)) iter = NULL;                        \
+                     iter##_left ||                                                        \
+                     ((iter = zvec_paged_page(p, iter##_pg++, &iter##_left)),              \
+                      iter ? iter##_left : (iter##_left = 0));                             \
+                     ++iter, --iter##_left)
+#   else
+        /* Standard C fallback: declare 'const T *iter' before the loop. */
+#       define zvec_paged_foreach(p, iter)                                                 \
+            for (size_t iter##_pg = 0, iter##_left = 0;                                    \
+                 iter##_left ||                                                            \
+                 (((iter) = zvec_paged_page(p, iter##_pg++, &iter##_left)),                \
+                  (iter) ? iter##_left : (iter##_left = 0));                               \
+                 ++(iter), --iter##_left)
+#   endif
+
+#   define zvec_external_sort(in, out, Name, cmp, budget)                                  \
+        zvec_external_sort_##Name(in, out, cmp, budget)
+
+#   define zvec_track_init(t)              _Generic((t), Z_ALL_VECS(TRACK_INIT_ENTRY)       default: (void)0)(t)
+#   define zvec_track_free(t)              _Generic((t), Z_ALL_VECS(TRACK_FREE_ENTRY)       default: (void)0)(t)
+#   define zvec_track_mark(t, i, n)        _Generic((t), Z_ALL_VECS(TRACK_MARK_ENTRY)       default: (void)0)(t, i, n)
+#   define zvec_track_at(t, i)             _Generic((t), Z_ALL_VECS(TRACK_AT_ENTRY)         default: (void *)0)(t, i)
+#   define zvec_track_push_slot(t)         _Generic((t), Z_ALL_VECS(TRACK_SLOT_ENTRY)       default: (void *)0)(t)
+#   define zvec_track_push(t, val)         _Generic((t), Z_ALL_VECS(TRACK_PUSH_ENTRY)       default: 0)(t, val)
+#   define zvec_track_remove(t, i)         _Generic((t), Z_ALL_VECS(TRACK_REMOVE_ENTRY)     default: (void)0)(t, i)
+#   define zvec_checkpoint(t, fa, fb)      _Generic((t), Z_ALL_VECS(CHECKPOINT_ENTRY)       default: 0)(t, fa, fb)
+
+#   if ZVEC_HAS_THREADS
+#       define zvec_log_open(l, path)      _Generic((l), Z_ALL_VECS(LOG_OPEN_ENTRY)         default: 0)(l, path)
+#       define zvec_log_push(l, val)       _Generic((l), Z_ALL_VECS(LOG_PUSH_ENTRY)         default: 0)(l, val)
+#       define zvec_log_extend(l, arr, n)  _Generic((l), Z_ALL_VECS(LOG_EXTEND_ENTRY)       default: 0)(l, arr, n)
+#       define zvec_log_close(l)           _Generic((l), Z_ALL_VECS(LOG_CLOSE_ENTRY)        default: (void)0)(l)
+#       define zvec_log_load(Name, path, out) zvec_log_load_##Name(path, out)
+
+#       define zvec_stream_open(s, p, n)   _Generic((s), Z_ALL_VECS(STREAM_OPEN_ENTRY)      default: 0)(s, p, n)
+#       define zvec_stream_next_chunk(s)   _Generic((s), Z_ALL_VECS(STREAM_NEXT_ENTRY)      default: (void *)0)(s)
+#       define zvec_stream_close(s)        _Generic((s), Z_ALL_VECS(STREAM_CLOSE_ENTRY)     default: (void)0)(s)
+#   endif
+#endif
+
+/*
+ * Bit manipulation helpers shared by the compressed containers.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#   define ZVEC_POPCOUNT64(x)  ((unsigned)__builtin_popcountll((unsigned long long)(x)))
+#   define ZVEC_CTZ64(x)       ((unsigned)__builtin_ctzll((unsigned long long)(x)))
+#else
+    static inline unsigned zvec_popcount64_impl(uint64_t x)
+    {
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (unsigned)((x * 0x0101010101010101ULL) >> 56);
+    }
+
+    static inline unsigned zvec_ctz64_impl(uint64_t x)
+    {
+        unsigned n = 0;
+        while (!(x & 1))
+        {
+            x >>= 1;
+            n++;
+        }
+        return n;
+    }
+#   define ZVEC_POPCOUNT64(x)  zvec_popcount64_impl(x)
+#   define ZVEC_CTZ64(x)       zvec_ctz64_impl(x)
+#endif
+
+#if !defined(ZVEC_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#   include <emmintrin.h>
+#   define ZVEC_HAS_SSE2 1
+#else
+#   define ZVEC_HAS_SSE2 0
+#endif
+
+/*
+ * Compressed sets of 32-bit integers (roaring-style).
+ *
+ * Values are partitioned by their high 16 bits into containers kept sorted by
+ * key. Sparse containers store the low 16 bits as a sorted uint16_t array; once
+ * they hold more than ZVEC_ROAR_ARRAY_MAX values they become a 65536-bit bitmap.
+ * A dense range therefore costs ~1 bit per ID and a sparse one 2 bytes per ID.
+ *
+ * Build from / expand to sorted 32-bit vectors with zvec_roar_from_vec and
+ * zvec_roar_to_vec (e.g. a registered zvec_Int). Negative ints are treated as
+ * their uint32_t bit pattern.
+ */
+#define ZVEC_ROAR_ARRAY_MAX  4096
+#define ZVEC_ROAR_WORDS      1024  // 65536 bits per bitmap container.
+
+typedef struct
+{
+    uint16_t key;       // High 16 bits shared by every value in the container.
+    uint32_t card;      // Number of values stored.
+    uint32_t cap;       // Allocated slots in 'array' (0 for bitmaps).
+    uint16_t *array;    // Sorted low halves, or NULL when 'bits' is used.
+    uint64_t *bits;     // ZVEC_ROAR_WORDS words, or NULL when 'array' is used.
+} zvec_roar_cont;
+
+typedef struct
+{
+    zvec_roar_cont *conts;
+    size_t length;
+    size_t capacity;
+} zvec_roar;
+
+static inline zvec_roar zvec_roar_init(void)
+{
+    zvec_roar r;
+    memset(&r, 0, sizeof(zvec_roar));
+    return r;
+}
+
+static inline void zvec_roar_cont_free_impl(zvec_roar_cont *c)
+{
+    ZVEC_FREE(c->array);
+    ZVEC_FREE(c->bits);
+    memset(c, 0, sizeof(zvec_roar_cont));
+}
+
+static inline void zvec_roar_clear(zvec_roar *r)
+{
+    size_t i;
+    for (i = 0; i < r->length; ++i)
+    {
+        zvec_roar_cont_free_impl(&r->conts[i]);
+    }
+    r->length = 0;
+}
+
+static inline void zvec_roar_free(zvec_roar *r)
+{
+    zvec_roar_clear(r);
+    ZVEC_FREE(r->conts);
+    memset(r, 0, sizeof(zvec_roar));
+}
+
+static inline size_t zvec_roar_cardinality(const zvec_roar *r)
+{
+    size_t i, total = 0;
+    for (i = 0; i < r->length; ++i)
+    {
+        total += r->conts[i].card;
+    }
+    return total;
+}
+
+// Binary search for 'key'; sets *pos to its index or insertion point.
+static inline int zvec_roar_find_impl(const zvec_roar *r, uint16_t key, size_t *pos)
+{
+    size_t l = 0;
+    size_t h = r->length;
+    while (l < h)
+    {
+        size_t mid = l + (h - l) / 2;
+        if (r->conts[mid].key < key)
+        {
+            l = mid + 1;
+        }
+        else
+        {
+            h = mid;
+        }
+    }
+    *pos = l;
+    return l < r->length && r->conts[l].key == key;
+}
+
+// Inserts an empty array container for 'key' at 'pos'.
+static inline zvec_roar_cont *zvec_roar_insert_impl(zvec_roar *r, size_t pos, uint16_t key)
+{
+    if (r->length >= r->capacity)
+    {
+        size_t new_cap = r->capacity ? r->capacity * 2 : 4;
+        zvec_roar_cont *c = (zvec_roar_cont *)ZVEC_REALLOC(r->conts,
+                                                           new_cap * sizeof(zvec_roar_cont));
+        if (!c)
+        {
+            return NULL;
+        }
+        r->conts = c;
+        r->capacity = new_cap;
+    }
+    memmove(&r->conts[pos + 1], &r->conts[pos], (r->length - pos) * sizeof(zvec_roar_cont));
+    memset(&r->conts[pos], 0, sizeof(zvec_roar_cont));
+    r->conts[pos].key = key;
+    r->length++;
+    return &r->conts[pos];
+}
+
+static inline int zvec_roar_to_bitmap_impl(zvec_roar_cont *c)
+{
+    uint32_t i;
+    uint64_t *bits = (uint64_t *)ZVEC_CALLOC(ZVEC_ROAR_WORDS, sizeof(uint64_t));
+    if (!bits)
+    {
+        return Z_ENOMEM;
+    }
+    for (i = 0; i < c->card; ++i)
+    {
+        bits[c->array[i] >> 6] |= 1ULL << (c->array[i] & 63);
+    }
+    ZVEC_FREE(c->array);
+    c->array = NULL;
+    c->cap = 0;
+    c->bits = bits;
+    return Z_OK;
+}
+
+static inline int zvec_roar_to_array_impl(zvec_roar_cont *c)
+{
+    uint32_t i, n = 0;
+    uint16_t *arr = (uint16_t *)ZVEC_MALLOC((c->card ? c->card : 1) * sizeof(uint16_t));
+    if (!arr)
+    {
+        return Z_ENOMEM;
+    }
+    for (i = 0; i < ZVEC_ROAR_WORDS; ++i)
+    {
+        uint64_t w = c->bits[i];
+        while (w)
+        {
+            arr[n++] = (uint16_t)((i << 6) + ZVEC_CTZ64(w));
+            w &= w - 1;
+        }
+    }
+    ZVEC_FREE(c->bits);
+    c->bits = NULL;
+    c->array = arr;
+    c->cap = c->card ? c->card : 1;
+    return Z_OK;
+}
+
+// Inserts 'low' at index 'at' of an array container, converting when it overflows.
+static inline int zvec_roar_array_insert_impl(zvec_roar_cont *c, uint32_t at, uint16_t low)
+{
+    if (c->card >= ZVEC_ROAR_ARRAY_MAX)
+    {
+        if (Z_OK != zvec_roar_to_bitmap_impl(c))
+        {
+            return Z_ENOMEM;
+        }
+        c->bits[low >> 6] |= 1ULL << (low & 63);
+        c->card++;
+        return Z_OK;
+    }
+    if (c->card >= c->cap)
+    {
+        uint32_t new_cap = c->cap ? c->cap * 2 : 8;
+        uint16_t *arr;
+        if (new_cap > ZVEC_ROAR_ARRAY_MAX)
+        {
+            new_cap = ZVEC_ROAR_ARRAY_MAX;
+        }
+        arr = (uint16_t *)ZVEC_REALLOC(c->array, new_cap * sizeof(uint16_t));
+        if (!arr)
+        {
+            return Z_ENOMEM;
+        }
+        c->array = arr;
+        c->cap = new_cap;
+    }
+    memmove(&c->array[at + 1], &c->array[at], (c->card - at) * sizeof(uint16_t));
+    c->array[at] = low;
+    c->card++;
+    return Z_OK;
+}
+
+static inline int zvec_roar_add(zvec_roar *r, uint32_t x)
+{
+    uint16_t key = (uint16_t)(x >> 16);
+    uint16_t low = (uint16_t)x;
+    zvec_roar_cont *c;
+    size_t pos;
+    uint32_t l, h;
+    if (r->length && r->conts[r->length - 1].key == key)
+    {
+        pos = r->length - 1; // Fast path for ascending input.
+    }
+    else if (!zvec_roar_find_impl(r, key, &pos))
+    {
+        if (!zvec_roar_insert_impl(r, pos, key))
+        {
+            return Z_ENOMEM;
+        }
+    }
+    c = &r->conts[pos];
+    if (c->bits)
+    {
+        uint64_t mask = 1ULL << (low & 63);
+        if (!(c->bits[low >> 6] & mask))
+        {
+            c->bits[low >> 6] |= mask;
+            c->card++;
+        }
+        return Z_OK;
+    }
+    if (0 == c->card || c->array[c->card - 1] < low)
+    {
+        return zvec_roar_array_insert_impl(c, c->card, low);
+    }
+    l = 0;
+    h = c->card;
+    while (l < h)
+    {
+        uint32_t mid = l + (h - l) / 2;
+        if (c->array[mid] < low)
+        {
+            l = mid + 1;
+        }
+        else
+        {
+            h = mid;
+        }
+    }
+    if (c->array[l] == low)
+    {
+        return Z_OK;
+    }
+    return zvec_roar_array_insert_impl(c, l, low);
+}
+
+static inline int zvec_roar_contains(const zvec_roar *r, uint32_t x)
+{
+    uint16_t low = (uint16_t)x;
+    const zvec_roar_cont *c;
+    size_t pos;
+    uint32_t l, h;
+    if (!zvec_roar_find_impl(r, (uint16_t)(x >> 16), &pos))
+    {
+        return 0;
+    }
+    c = &r->conts[pos];
+    if (c->bits)
+    {
+        return (int)((c->bits[low >> 6] >> (low & 63)) & 1);
+    }
+    l = 0;
+    h = c->card;
+    while (l < h)
+    {
+        uint32_t mid = l + (h - l) / 2;
+        if (c->array[mid] < low)
+        {
+            l = mid + 1;
+        }
+        else
+        {
+            h = mid;
+        }
+    }
+    return l < c->card && c->array[l] == low;
+}
+
+// Replaces the contents of 'r' with 'count' values (ascending input is the fast path).
+static inline int zvec_roar_from_array(zvec_roar *r, const uint32_t *vals, size_t count)
+{
+    size_t i;
+    zvec_roar_clear(r);
+    for (i = 0; i < count; ++i)
+    {
+        if (Z_OK != zvec_roar_add(r, vals[i]))
+        {
+            return Z_ENOMEM;
+        }
+    }
+    return Z_OK;
+}
+
+// Writes every value in ascending order to 'out'; returns how many were written.
+static inline size_t zvec_roar_to_array(const zvec_roar *r, uint32_t *out)
+{
+    size_t i, n = 0;
+    for (i = 0; i < r->length; ++i)
+    {
+        const zvec_roar_cont *c = &r->conts[i];
+        uint32_t hi = (uint32_t)c->key << 16;
+        uint32_t j;
+        if (c->bits)
+        {
+            for (j = 0; j < ZVEC_ROAR_WORDS; ++j)
+            {
+                uint64_t w = c->bits[j];
+                while (w)
+                {
+                    out[n++] = hi | ((j << 6) + ZVEC_CTZ64(w));
+                    w &= w - 1;
+                }
+            }
+        }
+        else
+        {
+            for (j = 0; j < c->card; ++j)
+            {
+                out[n++] = hi | c->array[j];
+            }
+        }
+    }
+    return n;
+}
+
+/*
+ * Sorted uint16_t intersection. With SSE2, blocks of 8 are compared all-against-all
+ * (8 rotations of 'b'), and the block with the smaller maximum is advanced.
+ * 'out' may be NULL to only count. Inputs must be strictly increasing.
+ */
+static inline uint32_t zvec_roar_intersect16_impl(const uint16_t *a, uint32_t na,
+                                                  const uint16_t *b, uint32_t nb,
+                                                  uint16_t *out)
+{
+    uint32_t i = 0, j = 0, n = 0;
+#if ZVEC_HAS_SSE2
+    while (i + 8 <= na && j + 8 <= nb)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + j));
+        __m128i hit = _mm_cmpeq_epi16(va, vb);
+        int k, mask;
+        for (k = 1; k < 8; ++k)
+        {
+            vb = _mm_or_si128(_mm_srli_si128(vb, 2), _mm_slli_si128(vb, 14));
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi16(va, vb));
+        }
+        mask = _mm_movemask_epi8(hit);
+        while (mask)
+        {
+            unsigned bit = ZVEC_CTZ64((uint64_t)mask);
+            if (out)
+            {
+                out[n] = a[i + (bit >> 1)];
+            }
+            n++;
+            mask &= ~(3 << bit);
+        }
+        if (a[i + 7] < b[j + 7])
+        {
+            i += 8;
+        }
+        else if (a[i + 7] > b[j + 7])
+        {
+            j += 8;
+        }
+        else
+        {
+            i += 8;
+            j += 8;
+        }
+    }
+#endif
+    while (i < na && j < nb)
+    {
+        if (a[i] < b[j])
+        {
+            i++;
+        }
+        else if (a[i] > b[j])
+        {
+            j++;
+        }
+        else
+        {
+            if (out)
+            {
+                out[n] = a[i];
+            }
+            n++;
+            i++;
+            j++;
+        }
+    }
+    return n;
+}
+
+// Intersects two containers into 'dst' (already keyed); 'dst' may end up empty.
+static inline int zvec_roar_cont_and_impl(const zvec_roar_cont *a, const zvec_roar_cont *b,
+                                          zvec_roar_cont *dst)
+{
+    uint32_t i;
+    if (a->bits && b->bits)
+    {
+        uint64_t *bits = (uint64_t *)ZVEC_MALLOC(ZVEC_ROAR_WORDS * sizeof(uint64_t));
+        uint32_t card = 0;
+        if (!bits)
+        {
+            return Z_ENOMEM;
+        }
+        for (i = 0; i < ZVEC_ROAR_WORDS; ++i)
+        {
+            bits[i] = a->bits[i] & b->bits[i];
+            card += ZVEC_POPCOUNT64(bits[i]);
+        }
+        dst->bits = bits;
+        dst->card = card;
+        return card <= ZVEC_ROAR_ARRAY_MAX ? zvec_roar_to_array_impl(dst) : Z_OK;
+    }
+    if (a->bits || b->bits)
+    {
+        const zvec_roar_cont *arr = a->bits ? b : a;
+        const uint64_t *bits = a->bits ? a->bits : b->bits;
+        uint32_t n = 0;
+        dst->array = (uint16_t *)ZVEC_MALLOC((arr->card ? arr->card : 1) * sizeof(uint16_t));
+        if (!dst->array)
+        {
+            return Z_ENOMEM;
+        }
+        for (i = 0; i < arr->card; ++i)
+        {
+            uint16_t low = arr->array[i];
+            dst->array[n] = low;
+            n += (uint32_t)((bits[low >> 6] >> (low & 63)) & 1);
+        }
+        dst->card = n;
+        dst->cap = arr->card ? arr->card : 1;
+        return Z_OK;
+    }
+    {
+        uint32_t cap = a->card < b->card ? a->card : b->card;
+        dst->array = (uint16_t *)ZVEC_MALLOC((cap ? cap : 1) * sizeof(uint16_t));
+        if (!dst->array)
+        {
+            return Z_ENOMEM;
+        }
+        dst->cap = cap ? cap : 1;
+        dst->card = zvec_roar_intersect16_impl(a->array, a->card, b->array, b->card,
+                                               dst->array);
+    }
+    return Z_OK;
+}
+
+// Unites two containers into 'dst' (already keyed).
+static inline int zvec_roar_cont_or_impl(const zvec_roar_cont *a, const zvec_roar_cont *b,
+                                         zvec_roar_cont *dst)
+{
+    uint32_t i;
+    if (!a->bits && !b->bits && a->card + b->card <= ZVEC_ROAR_ARRAY_MAX)
+    {
+        uint32_t x = 0, y = 0, n = 0;
+        uint32_t cap = a->card + b->card;
+        dst->array = (uint16_t *)ZVEC_MALLOC((cap ? cap : 1) * sizeof(uint16_t));
+        if (!dst->array)
+        {
+            return Z_ENOMEM;
+        }
+        while (x < a->card && y < b->card)
+        {
+            uint16_t va = a->array[x];
+            uint16_t vb = b->array[y];
+            dst->array[n++] = va < vb ? va : vb;
+            x += va <= vb;
+            y += vb <= va;
+        }
+        while (x < a->card)
+        {
+            dst->array[n++] = a->array[x++];
+        }
+        while (y < b->card)
+        {
+            dst->array[n++] = b->array[y++];
+        }
+        dst->card = n;
+        dst->cap = cap ? cap : 1;
+        return Z_OK;
+    }
+    dst->bits = (uint64_t *)ZVEC_CALLOC(ZVEC_ROAR_WORDS, sizeof(uint64_t));
+    if (!dst->bits)
+    {
+        return Z_ENOMEM;
+    }
+    if (a->bits && b->bits)
+    {
+        for (i = 0; i < ZVEC_ROAR_WORDS; ++i)
+        {
+            dst->bits[i] = a->bits[i] | b->bits[i];
+        }
+    }
+    else
+    {
+        const zvec_roar_cont *src[2];
+        int s;
+        src[0] = a;
+        src[1] = b;
+        for (s = 0; s < 2; ++s)
+        {
+            if (src[s]->bits)
+            {
+                memcpy(dst->bits, src[s]->bits, ZVEC_ROAR_WORDS * sizeof(uint64_t));
+            }
+        }
+        for (s = 0; s < 2; ++s)
+        {
+            for (i = 0; !src[s]->bits && i < src[s]->card; ++i)
+            {
+                uint16_t low = src[s]->array[i];
+                dst->bits[low >> 6] |= 1ULL << (low & 63);
+            }
+        }
+    }
+    dst->card = 0;
+    for (i = 0; i < ZVEC_ROAR_WORDS; ++i)
+    {
+        dst->card += ZVEC_POPCOUNT64(dst->bits[i]);
+    }
+    return dst->card <= ZVEC_ROAR_ARRAY_MAX ? zvec_roar_to_array_impl(dst) : Z_OK;
+}
+
+static inline int zvec_roar_copy_cont_impl(const zvec_roar_cont *src, zvec_roar_cont *dst)
+{
+    size_t bytes = src->bits ? ZVEC_ROAR_WORDS * sizeof(uint64_t)
+                             : (src->card ? src->card : 1) * sizeof(uint16_t);
+    void *mem = ZVEC_MALLOC(bytes);
+    if (!mem)
+    {
+        return Z_ENOMEM;
+    }
+    memcpy(mem, src->bits ? (const void *)src->bits : (const void *)src->array,
+           src->bits ? bytes : src->card * sizeof(uint16_t));
+    if (src->bits)
+    {
+        dst->bits = (uint64_t *)mem;
+    }
+    else
+    {
+        dst->array = (uint16_t *)mem;
+        dst->cap = src->card ? src->card : 1;
+    }
+    dst->card = src->card;
+    return Z_OK;
+}
+
+// dst = a AND b. 'dst' must be distinct from both inputs; its contents are replaced.
+static inline int zvec_roar_and(zvec_roar *dst, const zvec_roar *a, const zvec_roar *b)
+{
+    size_t i = 0, j = 0;
+    assert(dst != a && dst != b && "Output must not alias an input");
+    zvec_roar_clear(dst);
+    while (i < a->length && j < b->length)
+    {
+        if (a->conts[i].key < b->conts[j].key)
+        {
+            i++;
+        }
+        else if (a->conts[i].key > b->conts[j].key)
+        {
+            j++;
+        }
+        else
+        {
+            zvec_roar_cont *c = zvec_roar_insert_impl(dst, dst->length, a->conts[i].key);
+            if (!c || Z_OK != zvec_roar_cont_and_impl(&a->conts[i], &b->conts[j], c))
+            {
+                return Z_ENOMEM;
+            }
+            if (0 == c->card)
+            {
+                zvec_roar_cont_free_impl(c);
+                dst->length--;
+            }
+            i++;
+            j++;
+        }
+    }
+    return Z_OK;
+}
+
+// dst = a OR b. 'dst' must be distinct from both inputs; its contents are replaced.
+static inline int zvec_roar_or(zvec_roar *dst, const zvec_roar *a, const zvec_roar *b)
+{
+    size_t i = 0, j = 0;
+    assert(dst != a && dst != b && "Output must not alias an input");
+    zvec_roar_clear(dst);
+    while (i < a->length || j < b->length)
+    {
+        const zvec_roar_cont *ca = i < a->length ? &a->conts[i] : NULL;
+        const zvec_roar_cont *cb = j < b->length ? &b->conts[j] : NULL;
+        zvec_roar_cont *c;
+        int rc;
+        if (ca && cb && ca->key == cb->key)
+        {
+            c = zvec_roar_insert_impl(dst, dst->length, ca->key);
+            rc = c ? zvec_roar_cont_or_impl(ca, cb, c) : Z_ENOMEM;
+            i++;
+            j++;
+        }
+        else if (ca && (!cb || ca->key < cb->key))
+        {
+            c = zvec_roar_insert_impl(dst, dst->length, ca->key);
+            rc = c ? zvec_roar_copy_cont_impl(ca, c) : Z_ENOMEM;
+            i++;
+        }
+        else
+        {
+            c = zvec_roar_insert_impl(dst, dst->length, cb->key);
+            rc = c ? zvec_roar_copy_cont_impl(cb, c) : Z_ENOMEM;
+            j++;
+        }
+        if (Z_OK != rc)
+        {
+            return rc;
+        }
+    }
+    return Z_OK;
+}
+
+// |a AND b| without materializing the intersection.
+static inline size_t zvec_roar_and_cardinality(const zvec_roar *a, const zvec_roar *b)
+{
+    size_t i = 0, j = 0, total = 0;
+    while (i < a->length && j < b->length)
+    {
+        const zvec_roar_cont *ca = &a->conts[i];
+        const zvec_roar_cont *cb = &b->conts[j];
+        uint32_t k;
+        if (ca->key < cb->key)
+        {
+            i++;
+            continue;
+        }
+        if (ca->key > cb->key)
+        {
+            j++;
+            continue;
+        }
+        if (ca->bits && cb->bits)
+        {
+            for (k = 0; k < ZVEC_ROAR_WORDS; ++k)
+            {
+                total += ZVEC_POPCOUNT64(ca->bits[k] & cb->bits[k]);
+            }
+        }
+        else if (ca->bits || cb->bits)
+        {
+            const zvec_roar_cont *arr = ca->bits ? cb : ca;
+            const uint64_t *bits = ca->bits ? ca->bits : cb->bits;
+            for (k = 0; k < arr->card; ++k)
+            {
+                uint16_t low = arr->array[k];
+                total += (bits[low >> 6] >> (low & 63)) & 1;
+            }
+        }
+        else
+        {
+            total += zvec_roar_intersect16_impl(ca->array, ca->card, cb->array, cb->card, NULL);
+        }
+        i++;
+        j++;
+    }
+    return total;
+}
+
+// Compile-time check that a vector holds 32-bit integers (not float or a struct).
+#ifdef __cplusplus
+#   define ZVEC_ASSERT_INT32(v)                                                             \
+        static_cast<void>(sizeof(char[(sizeof(*(v)->data) == 4 &&                           \
+            std::is_integral<std::remove_reference<decltype(*(v)->data)>::type>::value)     \
+                                          ? 1 : -1]))
+#else
+#   define ZVEC_ASSERT_INT32(v)                                                             \
+        ((void)sizeof(char[(sizeof(*(v)->data) == 4 &&                                      \
+                            _Generic(*(v)->data, int: 1, unsigned int: 1, long: 1,          \
+                                     unsigned long: 1, default: 0)) ? 1 : -1]))
+#endif
+
+#define zvec_roar_from_vec(r, v)                                                            \
+    (ZVEC_ASSERT_INT32(v),                                                                  \
+     zvec_roar_from_array((r), (const uint32_t *)(const void *)(v)->data, (v)->length))
+
+#define zvec_roar_to_vec(r, v)                                                              \
+    (ZVEC_ASSERT_INT32(v),                                                                  \
+     Z_OK != zvec_reserve((v), (v)->length + zvec_roar_cardinality(r)) ? Z_ENOMEM :         \
+     ((v)->length +=                                                                        \
+          zvec_roar_to_array((r), (uint32_t *)(void *)((v)->data + (v)->length)),           \
+      Z_OK))
+
+/*
+ * Packed bit vector (zvec_bits).
+ *
+ * One bit per flag, stored in 64-bit words, with the familiar push / at / clear
+ * API plus popcount-based counting and word-at-a-time scanning. Bits at or past
+ * 'length' are always zero, so whole words can be counted without masking.
+ *
+ * zvec_bits_build_rank() adds an optional index (one cumulative count per 512
+ * bits, ~12.5% overhead) that makes zvec_bits_rank O(1) and zvec_bits_select
+ * O(log n). Any mutation invalidates the index until it is rebuilt; queries
+ * then fall back to a linear scan.
+ */
+#define ZVEC_BITS_NONE          ((size_t)-1)
+#define ZVEC_BITS_BLOCK_WORDS   8   // Words covered by one rank index entry.
+
+typedef struct
+{
+    uint64_t *words;
+    size_t length;      // Number of bits in use.
+    size_t capacity;    // Number of bits allocated (multiple of 64).
+    uint64_t *rank;     // Set bits before each block, or NULL.
+    size_t rank_len;
+    int rank_valid;
+} zvec_bits;
+
+static inline zvec_bits zvec_bits_init(void)
+{
+    zvec_bits b;
+    memset(&b, 0, sizeof(zvec_bits));
+    return b;
+}
+
+static inline void zvec_bits_free(zvec_bits *b)
+{
+    ZVEC_FREE(b->words);
+    ZVEC_FREE(b->rank);
+    memset(b, 0, sizeof(zvec_bits));
+}
+
+static inline int zvec_bits_reserve(zvec_bits *b, size_t nbits)
+{
+    size_t old_words = b->capacity / 64;
+    size_t new_words = (nbits + 63) / 64;
+    uint64_t *w;
+    if (nbits <= b->capacity)
+    {
+        return Z_OK;
+    }
+    w = (uint64_t *)ZVEC_REALLOC(b->words, new_words * sizeof(uint64_t));
+    if (!w)
+    {
+        return Z_ENOMEM;
+    }
+    memset(w + old_words, 0, (new_words - old_words) * sizeof(uint64_t));
+    b->words = w;
+    b->capacity = new_words * 64;
+    return Z_OK;
+}
+
+// Grows (with zero bits) or truncates to exactly 'nbits'.
+static inline int zvec_bits_resize(zvec_bits *b, size_t nbits)
+{
+    if (nbits > b->length)
+    {
+        if (Z_OK != zvec_bits_reserve(b, nbits))
+        {
+            return Z_ENOMEM;
+        }
+    }
+    else if (nbits < b->length)
+    {
+        size_t first = (nbits + 63) / 64;
+        size_t used = (b->length + 63) / 64;
+        if (nbits & 63)
+        {
+            b->words[nbits / 64] &= (1ULL << (nbits & 63)) - 1;
+        }
+        memset(b->words + first, 0, (used - first) * sizeof(uint64_t));
+    }
+    b->length = nbits;
+    b->rank_valid = 0;
+    return Z_OK;
+}
+
+static inline void zvec_bits_clear(zvec_bits *b)
+{
+    zvec_bits_resize(b, 0);
+}
+
+static inline int zvec_bits_is_empty(const zvec_bits *b)
+{
+    return 0 == b->length;
+}
+
+static inline int zvec_bits_push(zvec_bits *b, int value)
+{
+    if (b->length >= b->capacity)
+    {
+        if (Z_OK != zvec_bits_reserve(b, Z_GROWTH_FACTOR(b->capacity)))
+        {
+            return Z_ENOMEM;
+        }
+    }
+    if (value)
+    {
+        b->words[b->length / 64] |= 1ULL << (b->length & 63);
+    }
+    b->length++;
+    b->rank_valid = 0;
+    return Z_OK;
+}
+
+static inline int zvec_bits_pop_get(zvec_bits *b)
+{
+    size_t i;
+    int bit;
+    assert(b->length > 0 && "Bit vector is empty");
+    i = --b->length;
+    bit = (int)((b->words[i / 64] >> (i & 63)) & 1);
+    b->words[i / 64] &= ~(1ULL << (i & 63));
+    b->rank_valid = 0;
+    return bit;
+}
+
+static inline int zvec_bits_at(const zvec_bits *b, size_t i)
+{
+    assert(i < b->length && "Bit index out of bounds");
+    return (int)((b->words[i / 64] >> (i & 63)) & 1);
+}
+
+static inline void zvec_bits_set(zvec_bits *b, size_t i, int value)
+{
+    uint64_t mask = 1ULL << (i & 63);
+    assert(i < b->length && "Bit index out of bounds");
+    if (value)
+    {
+        b->words[i / 64] |= mask;
+    }
+    else
+    {
+        b->words[i / 64] &= ~mask;
+    }
+    b->rank_valid = 0;
+}
+
+// Sets bit 'i' and returns its previous value (visited-set idiom).
+static inline int zvec_bits_test_and_set(zvec_bits *b, size_t i)
+{
+    uint64_t mask = 1ULL << (i & 63);
+    uint64_t old;
+    assert(i < b->length && "Bit index out of bounds");
+    old = b->words[i / 64];
+    b->words[i / 64] = old | mask;
+    b->rank_valid = 0;
+    return (old & mask) != 0;
+}
+
+static inline size_t zvec_bits_count(const zvec_bits *b)
+{
+    size_t i, n = 0;
+    size_t used = (b->length + 63) / 64;
+    for (i = 0; i < used; ++i)
+    {
+        n += ZVEC_POPCOUNT64(b->words[i]);
+    }
+    return n;
+}
+
+// Index of the first set bit at or after 'from', or ZVEC_BITS_NONE.
+static inline size_t zvec_bits_find_next_set(const zvec_bits *b, size_t from)
+{
+    size_t i, used;
+    uint64_t w;
+    if (from >= b->length)
+    {
+        return ZVEC_BITS_NONE;
+    }
+    used = (b->length + 63) / 64;
+    i = from / 64;
+    w = b->words[i] & (~0ULL << (from & 63));
+    while (!w)
+    {
+        if (++i >= used)
+        {
+            return ZVEC_BITS_NONE;
+        }
+        w = b->words[i];
+    }
+    return i * 64 + ZVEC_CTZ64(w);
+}
+
+static inline int zvec_bits_build_rank(zvec_bits *b)
+{
+    size_t used = (b->length + 63) / 64;
+    size_t blocks = used / ZVEC_BITS_BLOCK_WORDS + 1;
+    size_t i, total = 0;
+    if (blocks > b->rank_len)
+    {
+        uint64_t *r = (uint64_t *)ZVEC_REALLOC(b->rank, blocks * sizeof(uint64_t));
+        if (!r)
+        {
+            return Z_ENOMEM;
+        }
+        b->rank = r;
+        b->rank_len = blocks;
+    }
+    for (i = 0; i < used; ++i)
+    {
+        if (0 == i % ZVEC_BITS_BLOCK_WORDS)
+        {
+            b->rank[i / ZVEC_BITS_BLOCK_WORDS] = total;
+        }
+        total += ZVEC_POPCOUNT64(b->words[i]);
+    }
+    if (0 == used % ZVEC_BITS_BLOCK_WORDS)
+    {
+        b->rank[used / ZVEC_BITS_BLOCK_WORDS] = total;
+    }
+    b->rank_valid = 1;
+    return Z_OK;
+}
+
+// Number of set bits in [0, i).
+static inline size_t zvec_bits_rank(const zvec_bits *b, size_t i)
+{
+    size_t w, first = 0, n = 0;
+    if (i > b->length)
+    {
+        i = b->length;
+    }
+    if (b->rank_valid)
+    {
+        first = (i / 64) / ZVEC_BITS_BLOCK_WORDS * ZVEC_BITS_BLOCK_WORDS;
+        n = b->rank[first / ZVEC_BITS_BLOCK_WORDS];
+    }
+    for (w = first; w < i / 64; ++w)
+    {
+        n += ZVEC_POPCOUNT64(b->words[w]);
+    }
+    if (i & 63)
+    {
+        n += ZVEC_POPCOUNT64(b->words[i / 64] & ((1ULL << (i & 63)) - 1));
+    }
+    return n;
+}
+
+// Index of the k-th set bit (0-based), or ZVEC_BITS_NONE.
+static inline size_t zvec_bits_select(const zvec_bits *b, size_t k)
+{
+    size_t used = (b->length + 63) / 64;
+    size_t w = 0;
+    uint64_t word;
+    if (b->rank_valid && used > 0)
+    {
+        size_t lo = 0;
+        size_t hi = (used - 1) / ZVEC_BITS_BLOCK_WORDS;
+        while (lo < hi)
+        {
+            size_t mid = lo + (hi - lo + 1) / 2;
+            if (b->rank[mid] <= k)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid - 1;
+            }
+        }
+        w = lo * ZVEC_BITS_BLOCK_WORDS;
+        k -= b->rank[lo];
+    }
+    for (; w < used; ++w)
+    {
+        size_t c = ZVEC_POPCOUNT64(b->words[w]);
+        if (k < c)
+        {
+            break;
+        }
+        k -= c;
+    }
+    if (w >= used)
+    {
+        return ZVEC_BITS_NONE;
+    }
+    word = b->words[w];
+    while (k--)
+    {
+        word &= word - 1;
+    }
+    return w * 64 + ZVEC_CTZ64(word);
+}
+
+// Iterates the indices of set bits: zvec_bits_foreach_set(&b, i) { ... }
+#define zvec_bits_foreach_set(b, idx)                                                       \
+    for (size_t idx = zvec_bits_find_next_set((b), 0);                                      \
+         idx != ZVEC_BITS_NONE;                                                             \
+         idx = zvec_bits_find_next_set((b), idx + 1))
+
+/*
+ * Bit-packed integer vector (zvec_packed).
+ *
+ * Appends 32-bit integers into blocks of ZVEC_PACKED_BLOCK values. Each full
+ * block is sealed with frame-of-reference encoding (value - block minimum) or,
+ * when the block is non-decreasing and it is narrower, delta encoding, then
+ * bit-packed at the smallest width that fits. The newest partial block stays
+ * unpacked in 'tail' so push and at() on recent data cost nothing extra.
+ *
+ * Packed values use a 4-lane interleaved layout (value i lives in lane i % 4),
+ * so SSE2 decodes four values per shift/mask step. FOR blocks support O(1)
+ * random access; delta blocks are decoded up to the requested index.
+ */
+#define ZVEC_PACKED_BLOCK 128
+
+typedef struct
+{
+    int32_t base;       // Block minimum (FOR) or first value (delta).
+    uint8_t bits;       // Packed width of each value, 0..32.
+    uint8_t delta;      // Non-zero when values are stored as deltas.
+    size_t offset;      // First payload word in zvec_packed.words.
+} zvec_packed_block;
+
+typedef struct
+{
+    zvec_packed_block *blocks;
+    size_t nblocks;
+    size_t block_cap;
+    uint32_t *words;    // Payload of every sealed block (4 * bits words each).
+    size_t nwords;
+    size_t word_cap;
+    int32_t tail[ZVEC_PACKED_BLOCK];
+    size_t tail_len;
+    size_t length;
+} zvec_packed;
+
+static inline zvec_packed zvec_packed_init(void)
+{
+    zvec_packed p;
+    memset(&p, 0, sizeof(zvec_packed));
+    return p;
+}
+
+static inline void zvec_packed_free(zvec_packed *p)
+{
+    ZVEC_FREE(p->blocks);
+    ZVEC_FREE(p->words);
+    memset(p, 0, sizeof(zvec_packed));
+}
+
+static inline void zvec_packed_clear(zvec_packed *p)
+{
+    p->nblocks = 0;
+    p->nwords = 0;
+    p->tail_len = 0;
+    p->length = 0;
+}
+
+// Bytes of heap memory in use (compare with length * sizeof(int32_t)).
+static inline size_t zvec_packed_bytes(const zvec_packed *p)
+{
+    return p->nblocks * sizeof(zvec_packed_block) + p->nwords * sizeof(uint32_t);
+}
+
+static inline unsigned zvec_packed_width_impl(uint32_t max)
+{
+    unsigned bits = 0;
+    while (bits < 32 && (max >> bits))
+    {
+        bits++;
+    }
+    return bits;
+}
+
+static inline void zvec_packed_pack_impl(const uint32_t *in, unsigned bits, uint32_t *out)
+{
+    unsigned lane, k;
+    memset(out, 0, 4 * bits * sizeof(uint32_t));
+    for (lane = 0; lane < 4; ++lane)
+    {
+        unsigned pos = 0;
+        for (k = 0; k < ZVEC_PACKED_BLOCK / 4; ++k, pos += bits)
+        {
+            uint32_t val = in[k * 4 + lane];
+            unsigned w = pos / 32;
+            unsigned off = pos % 32;
+            out[w * 4 + lane] |= val << off;
+            if (off + bits > 32)
+            {
+                out[(w + 1) * 4 + lane] |= val >> (32 - off);
+            }
+        }
+    }
+}
+
+// Seals the full tail into a packed block.
+static inline int zvec_packed_seal_impl(zvec_packed *p)
+{
+    uint32_t vals[ZVEC_PACKED_BLOCK];
+    uint32_t deltas[ZVEC_PACKED_BLOCK];
+    uint32_t max_for = 0, max_delta = 0;
+    int32_t min = p->tail[0];
+    int sorted = 1;
+    unsigned i, bits;
+    zvec_packed_block *blk;
+    for (i = 1; i < ZVEC_PACKED_BLOCK; ++i)
+    {
+        if (p->tail[i] < min)
+        {
+            min = p->tail[i];
+        }
+        if (p->tail[i] < p->tail[i - 1])
+        {
+            sorted = 0;
+        }
+    }
+    deltas[0] = 0;
+    for (i = 0; i < ZVEC_PACKED_BLOCK; ++i)
+    {
+        vals[i] = (uint32_t)p->tail[i] - (uint32_t)min;
+        max_for |= vals[i];
+        if (i > 0)
+        {
+            deltas[i] = (uint32_t)p->tail[i] - (uint32_t)p->tail[i - 1];
+            max_delta |= deltas[i];
+        }
+    }
+    sorted = sorted && zvec_packed_width_impl(max_delta) < zvec_packed_width_impl(max_for);
+    bits = zvec_packed_width_impl(sorted ? max_delta : max_for);
+    if (p->nblocks >= p->block_cap)
+    {
+        size_t new_cap = Z_GROWTH_FACTOR(p->block_cap);
+        zvec_packed_block *b = (zvec_packed_block *)ZVEC_REALLOC(p->blocks,
+                                                    new_cap * sizeof(zvec_packed_block));
+        if (!b)
+        {
+            return Z_ENOMEM;
+        }
+        p->blocks = b;
+        p->block_cap = new_cap;
+    }
+    if (p->nwords + 4 * bits > p->word_cap)
+    {
+        size_t new_cap = p->word_cap ? p->word_cap : Z_GROWTH_FACTOR(0);
+        uint32_t *w;
+        while (new_cap < p->nwords + 4 * bits)
+        {
+            new_cap = Z_GROWTH_FACTOR(new_cap);
+        }
+        w = (uint32_t *)ZVEC_REALLOC(p->words, new_cap * sizeof(uint32_t));
+        if (!w)
+        {
+            return Z_ENOMEM;
+        }
+        p->words = w;
+        p->word_cap = new_cap;
+    }
+    blk = &p->blocks[p->nblocks++];
+    blk->base = sorted ? p->tail[0] : min;
+    blk->bits = (uint8_t)bits;
+    blk->delta = (uint8_t)sorted;
+    blk->offset = p->nwords;
+    if (bits)
+    {
+        zvec_packed_pack_impl(sorted ? deltas : vals, bits, p->words + p->nwords);
+    }
+    p->nwords += 4 * bits;
+    p->tail_len = 0;
+    return Z_OK;
+}
+
+static inline int zvec_packed_push(zvec_packed *p, int32_t value)
+{
+    p->tail[p->tail_len++] = value;
+    p->length++;
+    if (ZVEC_PACKED_BLOCK == p->tail_len && Z_OK != zvec_packed_seal_impl(p))
+    {
+        p->tail_len--;
+        p->length--;
+        return Z_ENOMEM;
+    }
+    return Z_OK;
+}
+
+static inline int zvec_packed_extend(zvec_packed *p, const int32_t *vals, size_t count)
+{
+    size_t i;
+    for (i = 0; i < count; ++i)
+    {
+        if (Z_OK != zvec_packed_push(p, vals[i]))
+        {
+            return Z_ENOMEM;
+        }
+    }
+    return Z_OK;
+}
+
+// Decodes sealed block 'b' into out[0..ZVEC_PACKED_BLOCK).
+static inline void zvec_packed_decode_block(const zvec_packed *p, size_t b, int32_t *out)
+{
+    const zvec_packed_block *blk = &p->blocks[b];
+    const uint32_t *in = p->words + blk->offset;
+    unsigned bits = blk->bits;
+    uint32_t mask = bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+    unsigned k, pos = 0;
+#if ZVEC_HAS_SSE2
+    const __m128i vmask = _mm_set1_epi32((int)mask);
+    const __m128i vbase = _mm_set1_epi32(blk->base);
+    __m128i carry = vbase;
+    for (k = 0; k < ZVEC_PACKED_BLOCK / 4; ++k, pos += bits)
+    {
+        unsigned w = pos / 32;
+        unsigned off = pos % 32;
+        __m128i v = _mm_setzero_si128();
+        if (bits)
+        {
+            v = _mm_srl_epi32(_mm_loadu_si128((const __m128i *)(in + w * 4)),
+                              _mm_cvtsi32_si128((int)off));
+            if (off + bits > 32)
+            {
+                __m128i hi = _mm_loadu_si128((const __m128i *)(in + (w + 1) * 4));
+                v = _mm_or_si128(v, _mm_sll_epi32(hi, _mm_cvtsi32_si128((int)(32 - off))));
+            }
+            v = _mm_and_si128(v, vmask);
+        }
+        if (blk->delta)
+        {
+            // In-register prefix sum of 4 consecutive deltas, plus the running total.
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi32(v, carry);
+            carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+        else
+        {
+            v = _mm_add_epi32(v, vbase);
+        }
+        _mm_storeu_si128((__m128i *)(out + k * 4), v);
+    }
+#else
+    uint32_t run = (uint32_t)blk->base;
+    for (k = 0; k < ZVEC_PACKED_BLOCK / 4; ++k, pos += bits)
+    {
+        unsigned w = pos / 32;
+        unsigned off = pos % 32;
+        unsigned lane;
+        for (lane = 0; lane < 4; ++lane)
+        {
+            uint32_t v = 0;
+            if (bits)
+            {
+                v = in[w * 4 + lane] >> off;
+                if (off + bits > 32)
+                {
+                    v |= in[(w + 1) * 4 + lane] << (32 - off);
+                }
+                v &= mask;
+            }
+            if (blk->delta)
+            {
+                run += v;
+                out[k * 4 + lane] = (int32_t)run;
+            }
+            else
+            {
+                out[k * 4 + lane] = (int32_t)((uint32_t)blk->base + v);
+            }
+        }
+    }
+#endif
+}
+
+static inline int32_t zvec_packed_at(const zvec_packed *p, size_t i)
+{
+    const zvec_packed_block *blk;
+    size_t sealed = p->nblocks * ZVEC_PACKED_BLOCK;
+    assert(i < p->length && "Index out of bounds");
+    if (i >= sealed)
+    {
+        return p->tail[i - sealed];
+    }
+    blk = &p->blocks[i / ZVEC_PACKED_BLOCK];
+    if (blk->delta)
+    {
+        int32_t buf[ZVEC_PACKED_BLOCK];
+        zvec_packed_decode_block(p, i / ZVEC_PACKED_BLOCK, buf);
+        return buf[i % ZVEC_PACKED_BLOCK];
+    }
+    else
+    {
+        const uint32_t *in = p->words + blk->offset;
+        unsigned j = (unsigned)(i % ZVEC_PACKED_BLOCK);
+        unsigned pos = (j / 4) * blk->bits;
+        unsigned w = pos / 32;
+        unsigned off = pos % 32;
+        uint32_t v = 0;
+        if (blk->bits)
+        {
+            v = in[w * 4 + j % 4] >> off;
+            if (off + blk->bits > 32)
+            {
+                v |= in[(w + 1) * 4 + j % 4] << (32 - off);
+            }
+            if (blk->bits < 32)
+            {
+                v &= (1u << blk->bits) - 1;
+            }
+        }
+        return (int32_t)((uint32_t)blk->base + v);
+    }
+}
+
+// Decodes every value into 'out' (length elements); returns the count.
+static inline size_t zvec_packed_to_array(const zvec_packed *p, int32_t *out)
+{
+    size_t b;
+    if (0 == p->length)
+    {
+        return 0;
+    }
+    for (b = 0; b < p->nblocks; ++b)
+    {
+        zvec_packed_decode_block(p, b, out + b * ZVEC_PACKED_BLOCK);
+    }
+    if (p->tail_len)
+    {
+        memcpy(out + p->nblocks * ZVEC_PACKED_BLOCK, p->tail, p->tail_len * sizeof(int32_t));
+    }
+    return p->length;
+}
+
+#define zvec_packed_from_vec(p, v)                                                          \
+    (ZVEC_ASSERT_INT32(v),                                                                  \
+     zvec_packed_extend((p), (const int32_t *)(const void *)(v)->data, (v)->length))
+
+#define zvec_packed_to_vec(p, v)                                                            \
+    (ZVEC_ASSERT_INT32(v),                                                                  \
+     0 == (p)->length ? Z_OK :                                                              \
+     Z_OK != zvec_reserve((v), (v)->length + (p)->length) ? Z_ENOMEM :                      \
+     ((v)->length +=                                                                        \
+          zvec_packed_to_array((p), (int32_t *)(void *)((v)->data + (v)->length)),          \
+      Z_OK))
+
+/*
+ * Delimited text parsing (zvec_parse_ints / zvec_parse_floats).
+ *
+ * Fields are separated by 'sep' or by a newline, so a single CSV column parses
+ * either way. Blanks and '\r' around a field are ignored, as is an empty last
+ * field (a trailing newline). One pass counts the separators (16 bytes per
+ * SSE2 compare) so the vector is reserved once. A second pass finds each field
+ * the same way and converts it straight into the reserved capacity. Integers
+ * take eight digits per step (SWAR). Decimals use one exact power-of-ten
+ * multiply when mantissa and exponent allow it (Clinger's fast path) and
+ * strtod/strtof otherwise. A malformed or out-of-range field fails the whole
+ * call with Z_EINVAL and leaves the vector length unchanged.
+ */
+#define ZVEC_PARSE_UNSIGNED     16u     // Kind flag: unsigned integer elements.
+#define ZVEC_PARSE_FLOAT        32u     // Kind flag: float / double elements.
+#define ZVEC_PARSE_MAX_FIELD    128     // Longest field handed to the strtod fallback.
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ || \
+    defined(_M_X64) || defined(_M_IX86)
+#   define ZVEC_PARSE_SWAR 1
+#else
+#   define ZVEC_PARSE_SWAR 0
+#endif
+
+// Number of fields in buf: separators and newlines, plus one.
+static inline size_t zvec_parse_count_impl(const char *buf, size_t len, char sep)
+{
+    size_t i = 0, n = 1;
+#if ZVEC_HAS_SSE2
+    const __m128i vsep = _mm_set1_epi8(sep);
+    const __m128i vnl = _mm_set1_epi8('\n');
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i b = _mm_loadu_si128((const __m128i *)(const void *)(buf + i));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(b, vsep),
+                                                  _mm_cmpeq_epi8(b, vnl)));
+        n += ZVEC_POPCOUNT64((uint64_t)(unsigned)mask);
+    }
+#endif
+    for (; i < len; ++i)
+    {
+        n += (buf[i] == sep || buf[i] == '\n');
+    }
+    return n;
+}
+
+// First separator or newline in [p, end), or end.
+static inline const char *zvec_parse_find_impl(const char *p, const char *end, char sep)
+{
+#if ZVEC_HAS_SSE2
+    const __m128i vsep = _mm_set1_epi8(sep);
+    const __m128i vnl = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i b = _mm_loadu_si128((const __m128i *)(const void *)p);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(b, vsep),
+                                                  _mm_cmpeq_epi8(b, vnl)));
+        if (mask)
+        {
+            return p + ZVEC_CTZ64((uint64_t)(unsigned)mask);
+        }
+    }
+#endif
+    while (p < end && *p != sep && *p != '\n')
+    {
+        p++;
+    }
+    return p;
+}
+
+static inline int zvec_parse_blank_impl(char c)
+{
+    return ' ' == c || '\t' == c || '\r' == c;
+}
+
+/*
+ * Accumulates the decimal digits at p into *acc (wrapping past 19 digits; the
+ * caller checks the count). Returns the first non-digit.
+ */
+static inline const char *zvec_parse_digits_impl(const char *p, const char *end,
+                                                 uint64_t *acc)
+{
+    uint64_t v = *acc;
+#if ZVEC_PARSE_SWAR
+    while (end - p >= 8)
+    {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        if ((((w & 0xF0F0F0F0F0F0F0F0ULL) |
+              (((w + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))) !=
+            0x3333333333333333ULL)
+        {
+            break;
+        }
+        w -= 0x3030303030303030ULL;
+        w = (w * 10) + (w >> 8);
+        w = (((w & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+             (((w >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+        v = v * 100000000ULL + w;
+        p += 8;
+    }
+#endif
+    while (p < end && (unsigned)(*p - '0') < 10)
+    {
+        v = v * 10 + (uint64_t)(*p - '0');
+        p++;
+    }
+    *acc = v;
+    return p;
+}
+
+// Parses the integer field [p, end) into *out (kind: width | ZVEC_PARSE_UNSIGNED).
+static inline int zvec_parse_int_field_impl(const char *p, const char *end, unsigned kind,
+                                            void *out)
+{
+    size_t width = kind & 15;
+    int is_unsigned = (kind & ZVEC_PARSE_UNSIGNED) != 0;
+    uint64_t max = (4 == width) ? (is_unsigned ? UINT32_MAX : INT32_MAX)
+                                : (is_unsigned ? UINT64_MAX : INT64_MAX);
+    uint64_t mag = 0;
+    const char *digits, *stop;
+    int neg = 0;
+    if (p < end && ('-' == *p || '+' == *p))
+    {
+        neg = ('-' == *p++);
+    }
+    if (p == end || (unsigned)(*p - '0') >= 10)
+    {
+        return Z_EINVAL;
+    }
+    while (end - p > 1 && '0' == *p)
+    {
+        p++;
+    }
+    digits = p;
+    stop = zvec_parse_digits_impl(p, end, &mag);
+    if (stop != end)
+    {
+        return Z_EINVAL;
+    }
+    if (end - digits > 19)
+    {
+        // Only 20-digit unsigned 64-bit values fit; redo those with overflow checks.
+        if (end - digits > 20)
+        {
+            return Z_EINVAL;
+        }
+        mag = 0;
+        for (p = digits; p < end; ++p)
+        {
+            uint64_t d = (uint64_t)(*p - '0');
+            if (mag > (UINT64_MAX - d) / 10)
+            {
+                return Z_EINVAL;
+            }
+            mag = mag * 10 + d;
+        }
+    }
+    if (neg ? (0 != mag && (is_unsigned || mag > max + 1)) : mag > max)
+    {
+        return Z_EINVAL;
+    }
+    if (4 == width)
+    {
+        uint32_t v = (uint32_t)(neg ? 0 - mag : mag);
+        memcpy(out, &v, 4);
+    }
+    else
+    {
+        uint64_t v = neg ? 0 - mag : mag;
+        memcpy(out, &v, 8);
+    }
+    return Z_OK;
+}
+
+// Parses the decimal field [p, end) into a float (width 4) or double (width 8).
+static inline int zvec_parse_float_field_impl(const char *p, const char *end, size_t width,
+                                              void *out)
+{
+    static const double tens[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const char *start = p;
+    uint64_t mant = 0;
+    int neg = 0, frac = 0, exact = 1, seen = 0, sig = 0, exp10 = 0, overflow;
+    char tmp[ZVEC_PARSE_MAX_FIELD];
+    char *stop;
+    if (p < end && ('-' == *p || '+' == *p))
+    {
+        neg = ('-' == *p++);
+    }
+    for (; p < end; ++p)
+    {
+        unsigned d = (unsigned)(*p - '0');
+        if (d < 10)
+        {
+            seen = 1;
+            if (0 == mant && 0 == d)
+            {
+                exp10 -= frac;          // Leading zero.
+            }
+            else if (sig < 19)
+            {
+                mant = mant * 10 + d;
+                sig++;
+                exp10 -= frac;
+            }
+            else
+            {
+                exact = 0;              // Too many digits for a 64-bit mantissa.
+            }
+        }
+        else if ('.' == *p && !frac)
+        {
+            frac = 1;
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (seen && p < end && ('e' == *p || 'E' == *p))
+    {
+        int eneg = 0, e = 0;
+        const char *digits;
+        if (++p < end && ('-' == *p || '+' == *p))
+        {
+            eneg = ('-' == *p++);
+        }
+        for (digits = p; p < end && (unsigned)(*p - '0') < 10; ++p)
+        {
+            e = (e < 10000) ? e * 10 + (*p - '0') : e;
+        }
+        seen = (p != digits);
+        exp10 += eneg ? -e : e;
+    }
+    if (seen && exact && p == end)
+    {
+        if (8 == width && mant <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22)
+        {
+            double v = (double)mant;
+            v = (exp10 < 0) ? v / tens[-exp10] : v * tens[exp10];
+            v = neg ? -v : v;
+            memcpy(out, &v, 8);
+            return Z_OK;
+        }
+        if (4 == width && mant <= (1ULL << 24) && exp10 >= -10 && exp10 <= 10)
+        {
+            float v = (float)mant;
+            v = (exp10 < 0) ? v / (float)tens[-exp10] : v * (float)tens[exp10];
+            v = neg ? -v : v;
+            memcpy(out, &v, 4);
+            return Z_OK;
+        }
+    }
+    // Slow path on a NUL-terminated copy (also accepts inf, nan and hex floats).
+    // Overflow (ERANGE with a huge result) is out of range; underflow to a
+    // denormal or zero is kept, and a literal "inf" does not set ERANGE.
+    if ((size_t)(end - start) >= sizeof(tmp))
+    {
+        return Z_EINVAL;
+    }
+    memcpy(tmp, start, (size_t)(end - start));
+    tmp[end - start] = '\0';
+    errno = 0;
+    if (8 == width)
+    {
+        double v = strtod(tmp, &stop);
+        overflow = (ERANGE == errno && (v > 1.0 || v < -1.0));
+        memcpy(out, &v, 8);
+    }
+    else
+    {
+        float v = strtof(tmp, &stop);
+        overflow = (ERANGE == errno && (v > 1.0f || v < -1.0f));
+        memcpy(out, &v, 4);
+    }
+    return (stop == tmp + (end - start) && stop != tmp && !overflow) ? Z_OK : Z_EINVAL;
+}
+
+/*
+ * Parses every field of buf into out, which has room for
+ * zvec_parse_count_impl(buf, len, sep) elements, and adds the number parsed to
+ * *length. kind: element width in bytes | ZVEC_PARSE_UNSIGNED / ZVEC_PARSE_FLOAT.
+ */
+static inline int zvec_parse_impl(const char *buf, size_t len, char sep, void *out,
+                                  unsigned kind, size_t *length)
+{
+    const char *p = buf, *end = buf + len;
+    size_t width = kind & 15;
+    size_t n = 0;
+    for (;;)
+    {
+        const char *stop = zvec_parse_find_impl(p, end, sep);
+        const char *a = p, *b = stop;
+        void *dst = (char *)out + n * width;
+        int rc;
+        while (a < b && zvec_parse_blank_impl(*a))
+        {
+            a++;
+        }
+        while (b > a && zvec_parse_blank_impl(b[-1]))
+        {
+            b--;
+        }
+        if (a == b)
+        {
+            if (stop == end)
+            {
+                break;
+            }
+            return Z_EINVAL;
+        }
+        rc = (kind & ZVEC_PARSE_FLOAT) ? zvec_parse_float_field_impl(a, b, width, dst)
+                                       : zvec_parse_int_field_impl(a, b, kind, dst);
+        if (Z_OK != rc)
+        {
+            return rc;
+        }
+        n++;
+        if (stop == end)
+        {
+            break;
+        }
+        p = stop + 1;
+    }
+    *length += n;
+    return Z_OK;
+}
+
+#ifndef __cplusplus
+// Integer element kind; other element types fail to compile.
+#   define ZVEC_PARSE_INT_KIND(v)                                                           \
+        ((unsigned)sizeof(*(v)->data) |                                                     \
+         _Generic(*(v)->data, int: 0u, long: 0u, long long: 0u,                             \
+                  unsigned int: ZVEC_PARSE_UNSIGNED,                                        \
+                  unsigned long: ZVEC_PARSE_UNSIGNED,                                       \
+                  unsigned long long: ZVEC_PARSE_UNSIGNED))
+
+#   define ZVEC_PARSE_FLOAT_KIND(v)                                                         \
+        (_Generic(*(v)->data, float: 4u, double: 8u) | ZVEC_PARSE_FLOAT)
+
+#   define zvec_parse_ints(v, buf, len, sep)                                                \
+        (Z_OK != zvec_reserve((v), (v)->length +                                            \
+                                   zvec_parse_count_impl((buf), (len), (sep)))              \
+             ? Z_ENOMEM                                                                     \
+             : zvec_parse_impl((buf), (len), (sep), (void *)((v)->data + (v)->length),      \
+                               ZVEC_PARSE_INT_KIND(v), &(v)->length))
+
+#   define zvec_parse_floats(v, buf, len, sep)                                              \
+        (Z_OK != zvec_reserve((v), (v)->length +                                            \
+                                   zvec_parse_count_impl((buf), (len), (sep)))              \
+             ? Z_ENOMEM                                                                     \
+             : zvec_parse_impl((buf), (len), (sep), (void *)((v)->data + (v)->length),      \
+                               ZVEC_PARSE_FLOAT_KIND(v), &(v)->length))
 #endif
 
 // Optional short names (never enabled by default).
@@ -1158,8 +9115,14 @@ Z_ALL_VECS(ZVEC_GENERATE_IMPL)
 #   define vec_clear              zvec_clear
 #   define vec_reverse            zvec_reverse
 #   define vec_sort               zvec_sort
+#   define vec_stable_sort        zvec_stable_sort
 #   define vec_bsearch            zvec_bsearch
 #   define vec_lower_bound        zvec_lower_bound
+#   define vec_merge              zvec_merge
+#   define vec_union              zvec_union
+#   define vec_intersect          zvec_intersect
+#   define vec_difference         zvec_difference
+#   define vec_unique             zvec_unique
 #   define vec_foreach            zvec_foreach
 #   if Z_HAS_ZERROR && !defined(__cplusplus)
 #       define vec_reserve_safe   zvec_reserve_safe